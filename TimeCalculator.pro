@@ -10,5 +10,18 @@ SUBDIRS += \
 		lib \
 		application
 
+!wasm:!android:!ios {
+	bench.file = bench/bench.pro
+	bench.makefile = Makefile
+
+	generator.file = generator/generator.pro
+	generator.makefile = Makefile
+
+	tests.file = tests/tests.pro
+	tests.makefile = Makefile
+
+	SUBDIRS += bench generator tests
+}
+
 CONFIG += ordered
 
@@ -0,0 +1,38 @@
+lessThan(QT_MAJOR_VERSION, 6): error(Minimum Qt version 6 required)
+
+TEMPLATE = app
+TARGET = bench
+
+QT += gui quick svg quickcontrols2 sql printsupport concurrent testlib
+
+CONFIG += c++20
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../common.pri)
+include(../version/version.pri)
+
+DESTDIR = ..
+
+include(../lib/import_lib.pri)
+
+!android:if(linux|win32){
+	QMAKE_LFLAGS += \
+		"-Wl,--rpath,'$${LITERAL_DOLLAR}$${LITERAL_DOLLAR}ORIGIN'" \
+		"-Wl,--rpath,'$${LITERAL_DOLLAR}$${LITERAL_DOLLAR}ORIGIN/lib'"
+}
+
+include(../src/sources.pri)
+
+INCLUDEPATH += ../generator
+
+SOURCES += \
+	databasebench.cpp \
+	main.cpp \
+	startupbench.cpp \
+	../generator/historygenerator.cpp
+
+HEADERS += \
+	databasebench.h \
+	startupbench.h \
+	../generator/historygenerator.h
@@ -0,0 +1,408 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * databasebench.cpp
+ *
+ * Created on: 2024. 01. 25.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * DatabaseBench
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "databasebench.h"
+#include "civilcalendar.hpp"
+#include <QBuffer>
+#include <QJsonArray>
+#include <QRandomGenerator>
+#include <QTest>
+
+
+/// All calculations are made as of this date
+
+const QDate DatabaseBench::m_asOf(2024, 1, 1);
+
+
+
+/**
+ * @brief DatabaseBench::DatabaseBench
+ * @param application
+ * @param parent
+ */
+
+DatabaseBench::DatabaseBench(BenchApplication *application, QObject *parent)
+	: QObject(parent)
+	, m_application(application)
+{
+	Q_ASSERT(m_application);
+}
+
+
+/**
+ * @brief DatabaseBench::~DatabaseBench
+ */
+
+DatabaseBench::~DatabaseBench()
+{
+
+}
+
+
+
+/**
+ * @brief DatabaseBench::cleanupTestCase
+ */
+
+void DatabaseBench::cleanupTestCase()
+{
+	m_databases.clear();
+	m_files.clear();
+}
+
+
+
+/**
+ * @brief DatabaseBench::sizes
+ * Number of jobs: 10 ... 100 000 (limited by the environment variable BENCH_MAX_JOBS)
+ */
+
+void DatabaseBench::sizes() const
+{
+	QTest::addColumn<int>("jobs");
+
+	bool ok = false;
+	int max = qEnvironmentVariableIntValue("BENCH_MAX_JOBS", &ok);
+
+	if (!ok)
+		max = 100000;
+
+	for (int n=10; n<=max && n<=100000; n*=10)
+		QTest::addRow("%d", n) << n;
+}
+
+
+
+/**
+ * @brief DatabaseBench::database
+ * Loaded database of the given size (shared by the read-only benchmarks)
+ * @param jobs
+ * @return
+ */
+
+Database *DatabaseBench::database(const int &jobs)
+{
+	if (auto it = m_databases.find(jobs); it != m_databases.end())
+		return it->second.get();
+
+	if (m_files.find(jobs) == m_files.end())
+		m_files[jobs] = generator(jobs).toJson();
+
+	Database *db = Database::fromJson(m_files[jobs]);
+
+	if (db)
+		m_databases[jobs].reset(db);
+
+	return db;
+}
+
+
+
+/**
+ * @brief DatabaseBench::generator
+ * Synthetic employee file
+ * @param jobs
+ * @return
+ */
+
+HistoryGenerator DatabaseBench::generator(const int &jobs)
+{
+	HistoryGenerator::Options options;
+	options.jobs = jobs;
+	options.seed = 1;
+	options.asOf = m_asOf;
+
+	return HistoryGenerator(options);
+}
+
+
+
+/**
+ * @brief DatabaseBench::fromJson
+ */
+
+void DatabaseBench::fromJson()
+{
+	QFETCH(int, jobs);
+
+	if (m_files.find(jobs) == m_files.end())
+		m_files[jobs] = generator(jobs).toJson();
+
+	const QJsonObject &json = m_files[jobs];
+
+	QBENCHMARK {
+		std::unique_ptr<Database> db(Database::fromJson(json));
+		QVERIFY(db);
+	}
+}
+
+
+
+/**
+ * @brief DatabaseBench::toJson
+ */
+
+void DatabaseBench::toJson()
+{
+	QFETCH(int, jobs);
+
+	Database *db = database(jobs);
+	QVERIFY(db);
+
+	QBENCHMARK {
+		QByteArray content;
+		QBuffer buffer(&content);
+		buffer.open(QIODevice::WriteOnly);
+		QVERIFY(db->toJson(&buffer, QJsonDocument::Compact));
+	}
+}
+
+
+
+/**
+ * @brief DatabaseBench::jobAddBatch
+ */
+
+void DatabaseBench::jobAddBatch()
+{
+	QFETCH(int, jobs);
+
+	QVector<QVariantMap> list;
+	list.reserve(jobs);
+
+	for (const QJsonValue &v : generator(jobs).toJson().value(QStringLiteral("jobs")).toArray()) {
+		QVariantMap map = v.toObject().toVariantMap();
+		map.remove(QStringLiteral("id"));
+		map[QStringLiteral("start")] = QDate::fromString(map.value(QStringLiteral("start")).toString(), QStringLiteral("yyyy-MM-dd"));
+
+		if (map.contains(QStringLiteral("end")))
+			map[QStringLiteral("end")] = QDate::fromString(map.value(QStringLiteral("end")).toString(), QStringLiteral("yyyy-MM-dd"));
+
+		list.append(map);
+	}
+
+	Database db;
+	QVERIFY(db.open());
+	db.setAsOf(m_asOf);
+
+	QBENCHMARK_ONCE {
+		QVERIFY(db.jobAddBatch(list));
+	}
+}
+
+
+
+/**
+ * @brief DatabaseBench::sqlMainView
+ */
+
+void DatabaseBench::sqlMainView()
+{
+	QFETCH(int, jobs);
+
+	Database *db = database(jobs);
+	QVERIFY(db);
+
+	QBENCHMARK {
+		QVariantMap map;
+		QCOMPARE(db->sqlMainView(&map, db->snapshot()).size(), jobs);
+	}
+}
+
+
+
+/**
+ * @brief DatabaseBench::sync
+ * Sync including the model patch
+ */
+
+void DatabaseBench::sync()
+{
+	QFETCH(int, jobs);
+
+	Database *db = database(jobs);
+	QVERIFY(db);
+
+	QBENCHMARK {
+		db->sync();
+
+		while (db->m_patcher->isBusy())
+			QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 10);
+	}
+}
+
+
+
+/**
+ * @brief DatabaseBench::overlapGet
+ */
+
+void DatabaseBench::overlapGet()
+{
+	QFETCH(int, jobs);
+
+	Database *db = database(jobs);
+	QVERIFY(db);
+
+	const int id = jobs / 2;
+
+	QBENCHMARK {
+		db->overlapGet(id);
+	}
+}
+
+
+
+/**
+ * @brief DatabaseBench::importParse
+ */
+
+void DatabaseBench::importParse()
+{
+	QFETCH(int, jobs);
+
+	const QByteArray &content = generator(jobs).toXlsx();
+
+	QBENCHMARK {
+		const auto &list = BenchApplication::importParse(content);
+		QVERIFY(list);
+		QCOMPARE(list->size(), jobs);
+	}
+}
+
+
+
+/**
+ * @brief DatabaseBench::toMarkdown
+ */
+
+void DatabaseBench::toMarkdown()
+{
+	QFETCH(int, jobs);
+
+	Database *db = database(jobs);
+	QVERIFY(db);
+
+	QBENCHMARK {
+		QVERIFY(!db->toMarkdown().isEmpty());
+	}
+}
+
+
+
+/**
+ * @brief DatabaseBench::toTextDocument
+ */
+
+void DatabaseBench::toTextDocument()
+{
+	QFETCH(int, jobs);
+
+	Database *db = database(jobs);
+	QVERIFY(db);
+
+	const QString &html = db->toMarkdown();
+
+	QBENCHMARK {
+		QVERIFY(!m_application->toTextDocument(html, db->title()).isEmpty());
+	}
+}
+
+
+
+/**
+ * @brief durationPairs
+ * Fixed set of date pairs for the duration benchmarks
+ * @return
+ */
+
+static const QVector<std::pair<QDate, QDate>> &durationPairs()
+{
+	static const QVector<std::pair<QDate, QDate>> list = []() {
+		QRandomGenerator gen(1);
+		QVector<std::pair<QDate, QDate>> l;
+		l.reserve(100000);
+
+		for (int i=0; i<100000; ++i) {
+			const QDate &start = QDate(1970, 1, 1).addDays(gen.bounded(20000));
+			l.append({start, start.addDays(gen.bounded(15000))});
+		}
+
+		return l;
+	}();
+
+	return list;
+}
+
+
+
+/**
+ * @brief DatabaseBench::durationQDate
+ * Years and days between two dates with QDate arithmetic (the algorithm before CivilCalendar)
+ */
+
+void DatabaseBench::durationQDate()
+{
+	const auto &list = durationPairs();
+
+	QBENCHMARK {
+		qint64 sum = 0;
+
+		for (const auto &[date1, date2] : list) {
+			const QDate &d2 = date2.addDays(1);
+			const QDate d(d2.year(), date1.month(), date1.day());
+
+			if (d2 < d)
+				sum += d2.year()-1-date1.year() + QDate(d2.year()-1, date1.month(), date1.day()).daysTo(d2);
+			else
+				sum += d2.year()-date1.year() + d.daysTo(d2);
+		}
+
+		QVERIFY(sum > 0);
+	}
+}
+
+
+
+/**
+ * @brief DatabaseBench::durationCivilCalendar
+ */
+
+void DatabaseBench::durationCivilCalendar()
+{
+	const auto &list = durationPairs();
+
+	QBENCHMARK {
+		qint64 sum = 0;
+
+		for (const auto &[date1, date2] : list) {
+			const CivilCalendar::Duration &d = CivilCalendar::between(date1.toJulianDay(), date2.toJulianDay());
+			sum += d.years + d.days;
+		}
+
+		QVERIFY(sum > 0);
+	}
+}
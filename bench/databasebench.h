@@ -0,0 +1,107 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * databasebench.h
+ *
+ * Created on: 2024. 01. 25.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * DatabaseBench
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASEBENCH_H
+#define DATABASEBENCH_H
+
+#include "application.h"
+#include "historygenerator.h"
+#include <QObject>
+#include <QJsonObject>
+#include <map>
+
+
+/**
+ * @brief The BenchApplication class
+ * Exposes the report and import helpers of Application
+ */
+
+class BenchApplication : public Application
+{
+public:
+	BenchApplication(QGuiApplication *app) : Application(app) {}
+
+	using Application::importParse;
+	using Application::toTextDocument;
+};
+
+
+
+/**
+ * @brief The DatabaseBench class
+ *
+ * Benchmarks of the calculation, persistence and report paths on synthetic files.
+ * Every file is generated with a fixed seed and evaluated as of a fixed date, so the
+ * results are comparable between runs.
+ */
+
+class DatabaseBench : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit DatabaseBench(BenchApplication *application, QObject *parent = nullptr);
+	virtual ~DatabaseBench();
+
+private slots:
+	void cleanupTestCase();
+
+	void fromJson_data() { sizes(); }
+	void fromJson();
+	void toJson_data() { sizes(); }
+	void toJson();
+	void jobAddBatch_data() { sizes(); }
+	void jobAddBatch();
+	void sqlMainView_data() { sizes(); }
+	void sqlMainView();
+	void sync_data() { sizes(); }
+	void sync();
+	void overlapGet_data() { sizes(); }
+	void overlapGet();
+	void importParse_data() { sizes(); }
+	void importParse();
+	void toMarkdown_data() { sizes(); }
+	void toMarkdown();
+	void toTextDocument_data() { sizes(); }
+	void toTextDocument();
+
+	void durationQDate();
+	void durationCivilCalendar();
+
+private:
+	void sizes() const;
+	Database *database(const int &jobs);
+
+	static HistoryGenerator generator(const int &jobs);
+
+	static const QDate m_asOf;
+
+	BenchApplication *const m_application;
+	std::map<int, QJsonObject> m_files;
+	std::map<int, std::unique_ptr<Database>> m_databases;
+};
+
+#endif // DATABASEBENCH_H
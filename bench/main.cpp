@@ -0,0 +1,77 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * main.cpp
+ *
+ * Created on: 2024. 01. 25.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * Benchmark
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "databasebench.h"
+#include "startupbench.h"
+#include <QGuiApplication>
+#include <QTest>
+#include <algorithm>
+
+
+/**
+ * Results are written as CSV to the standard output unless an other QTest output format is given:
+ *
+ *   bench > result.csv
+ *   bench -o result.xml,xml
+ *   BENCH_MAX_JOBS=1000 bench sync
+ *
+ * The first argument "startup" runs the startup benchmark instead (time to first frame of the application):
+ *
+ *   BENCH_STARTUP_RUNS=10 bench startup
+ */
+
+int main(int argc, char *argv[])
+{
+	if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+
+	QGuiApplication app(argc, argv);
+
+	QStringList args = app.arguments();
+
+	const bool startup = args.size() > 1 && args.at(1) == QStringLiteral("startup");
+
+	if (startup)
+		args.removeAt(1);
+
+	static const QStringList formats = {
+		QStringLiteral("-o"), QStringLiteral("-txt"), QStringLiteral("-csv"), QStringLiteral("-xml"),
+		QStringLiteral("-lightxml"), QStringLiteral("-junitxml"), QStringLiteral("-teamcity"), QStringLiteral("-tap")
+	};
+
+	if (std::none_of(args.cbegin(), args.cend(), [](const QString &a) { return formats.contains(a); }))
+		args.insert(1, QStringLiteral("-csv"));
+
+	if (startup) {
+		StartupBench bench;
+		return QTest::qExec(&bench, args);
+	}
+
+	BenchApplication application(&app);
+	DatabaseBench bench(&application);
+
+	return QTest::qExec(&bench, args);
+}
@@ -0,0 +1,246 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * startupbench.cpp
+ *
+ * Created on: 2024. 01. 30.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * StartupBench
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "startupbench.h"
+#include "historygenerator.h"
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QSaveFile>
+#include <QTest>
+#include <algorithm>
+
+
+/**
+ * @brief StartupBench::StartupBench
+ * @param parent
+ */
+
+StartupBench::StartupBench(QObject *parent)
+	: QObject(parent)
+{
+
+}
+
+
+
+/**
+ * @brief StartupBench::initTestCase
+ * Generated database for the page pushes and the first job of it for the job editor
+ */
+
+void StartupBench::initTestCase()
+{
+	QVERIFY(m_dir.isValid());
+
+	HistoryGenerator::Options options;
+	options.jobs = 1000;
+
+	const QJsonObject &json = HistoryGenerator(options).toJson();
+
+	m_databaseFile = m_dir.filePath(QStringLiteral("startup.json"));
+
+	QSaveFile f(m_databaseFile);
+	QVERIFY(f.open(QIODevice::WriteOnly));
+	f.write(QJsonDocument(json).toJson(QJsonDocument::Compact));
+	QVERIFY(f.commit());
+
+	const QJsonObject &job = json.value(QStringLiteral("jobs")).toArray().first().toObject();
+
+	m_jobParameters = QString::fromUtf8(QJsonDocument(QJsonObject{{ QStringLiteral("editData"), job }})
+										.toJson(QJsonDocument::Compact));
+}
+
+
+
+/**
+ * @brief StartupBench::firstFrame_data
+ */
+
+void StartupBench::firstFrame_data()
+{
+	QTest::addColumn<QStringList>("arguments");
+
+	QTest::addRow("lazy") << QStringList{};
+	QTest::addRow("eager") << QStringList{QStringLiteral("--eager-startup")};
+}
+
+
+
+/**
+ * @brief StartupBench::firstFrame
+ */
+
+void StartupBench::firstFrame()
+{
+	QFETCH(QStringList, arguments);
+
+	if (!QFileInfo::exists(program()))
+		QSKIP("Application binary not found");
+
+	const int n = runs();
+
+	QVector<double> list;
+	list.reserve(n);
+
+	for (int i=0; i<n; ++i) {
+		const std::optional<double> &ms = launch(arguments, QByteArrayLiteral("first-frame-ms:"));
+		QVERIFY2(ms, "Application didn't report the first frame");
+		list.append(*ms);
+	}
+
+	std::sort(list.begin(), list.end());
+
+	QTest::setBenchmarkResult(list.at(list.size()/2), QTest::WalltimeMilliseconds);
+}
+
+
+
+/**
+ * @brief StartupBench::pagePush_data
+ */
+
+void StartupBench::pagePush_data()
+{
+	QTest::addColumn<QString>("page");
+	QTest::addColumn<QString>("parameters");
+
+	QTest::addRow("database") << QStringLiteral("PageDatabase.qml") << QString();
+	QTest::addRow("jobEdit") << QStringLiteral("PageJobEdit.qml") << m_jobParameters;
+	QTest::addRow("import") << QStringLiteral("PageImport.qml") << QString();
+}
+
+
+
+/**
+ * @brief StartupBench::pagePush
+ * Loading time of a page pushed after the first frame (compiled QML vs. runtime compilation),
+ * the generated database is loaded and synchronized before
+ */
+
+void StartupBench::pagePush()
+{
+	QFETCH(QString, page);
+	QFETCH(QString, parameters);
+
+	if (!QFileInfo::exists(program()))
+		QSKIP("Application binary not found");
+
+	const int n = runs();
+
+	QVector<double> list;
+	list.reserve(n);
+
+	QStringList arguments = {
+		QStringLiteral("--benchmark-page"), page,
+		QStringLiteral("--benchmark-database"), m_databaseFile,
+	};
+
+	if (!parameters.isEmpty())
+		arguments << QStringLiteral("--benchmark-page-parameters") << parameters;
+
+	for (int i=0; i<n; ++i) {
+		const std::optional<double> &ms = launch(arguments, QByteArrayLiteral("page-push-ms:"));
+		QVERIFY2(ms, "Application didn't report the page push");
+		list.append(*ms);
+	}
+
+	std::sort(list.begin(), list.end());
+
+	QTest::setBenchmarkResult(list.at(list.size()/2), QTest::WalltimeMilliseconds);
+}
+
+
+
+/**
+ * @brief StartupBench::program
+ * @return
+ */
+
+QString StartupBench::program()
+{
+#ifdef Q_OS_WIN
+	return QCoreApplication::applicationDirPath()+QStringLiteral("/TimeCalculator.exe");
+#else
+	return QCoreApplication::applicationDirPath()+QStringLiteral("/TimeCalculator");
+#endif
+}
+
+
+
+/**
+ * @brief StartupBench::runs
+ * @return
+ */
+
+int StartupBench::runs()
+{
+	bool ok = false;
+	const int runs = qEnvironmentVariableIntValue("BENCH_STARTUP_RUNS", &ok);
+
+	return ok && runs > 0 ? runs : 5;
+}
+
+
+
+/**
+ * @brief StartupBench::launch
+ * Start the application in startup benchmark mode
+ * @param arguments
+ * @param key
+ * @return milliseconds reported in the line starting with key
+ */
+
+std::optional<double> StartupBench::launch(const QStringList &arguments, const QByteArray &key)
+{
+	QProcess process;
+	process.setProgram(program());
+	process.setArguments(QStringList{QStringLiteral("--startup-benchmark")} + arguments);
+	process.setProcessChannelMode(QProcess::SeparateChannels);
+	process.start();
+
+	if (!process.waitForFinished(60000)) {
+		process.kill();
+		process.waitForFinished();
+		return std::nullopt;
+	}
+
+	for (const QByteArray &line : process.readAllStandardOutput().split('\n')) {
+		if (!line.startsWith(key))
+			continue;
+
+		bool ok = false;
+		const double ms = line.mid(key.size()).trimmed().toDouble(&ok);
+
+		if (ok)
+			return ms;
+	}
+
+	return std::nullopt;
+}
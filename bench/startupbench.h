@@ -0,0 +1,68 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * startupbench.h
+ *
+ * Created on: 2024. 01. 30.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * StartupBench
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef STARTUPBENCH_H
+#define STARTUPBENCH_H
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <optional>
+
+
+/**
+ * @brief The StartupBench class
+ *
+ * Time to the first frame of the application (median of BENCH_STARTUP_RUNS launches),
+ * with lazy and eager loading of the resources, and the time of pushing the pages onto
+ * the main stack (with a generated database opened as current one, the job editor with an
+ * existing job). The application binary is expected next to the benchmark executable.
+ */
+
+class StartupBench : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit StartupBench(QObject *parent = nullptr);
+
+private slots:
+	void initTestCase();
+	void firstFrame_data();
+	void firstFrame();
+	void pagePush_data();
+	void pagePush();
+
+private:
+	static QString program();
+	static int runs();
+	static std::optional<double> launch(const QStringList &arguments, const QByteArray &key);
+
+	QTemporaryDir m_dir;
+	QString m_databaseFile;
+	QString m_jobParameters;
+};
+
+#endif // STARTUPBENCH_H
@@ -0,0 +1,241 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * historygenerator.cpp
+ *
+ * Created on: 2024. 01. 26.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * HistoryGenerator
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "historygenerator.h"
+#include "application.h"
+#include "xlsxdocument.h"
+#include <QBuffer>
+#include <QJsonArray>
+#include <QRandomGenerator>
+
+
+
+/**
+ * @brief HistoryGenerator::HistoryGenerator
+ * @param options
+ */
+
+HistoryGenerator::HistoryGenerator(const Options &options)
+	: m_options(options)
+{
+
+}
+
+
+
+/**
+ * @brief HistoryGenerator::employerName
+ * Name of the employer by index (different for every index)
+ * @param index
+ * @return
+ */
+
+QString HistoryGenerator::employerName(const int &index)
+{
+	static const QStringList names = {
+		QStringLiteral("Petőfi Sándor"), QStringLiteral("Arany János"), QStringLiteral("Kölcsey Ferenc"),
+		QStringLiteral("Széchenyi István"), QStringLiteral("Bolyai János"), QStringLiteral("Kodály Zoltán"),
+		QStringLiteral("Móricz Zsigmond"), QStringLiteral("József Attila"), QStringLiteral("Szent István"),
+		QStringLiteral("Radnóti Miklós"),
+	};
+
+	static const QStringList kinds = {
+		QStringLiteral("Általános Iskola"), QStringLiteral("Gimnázium"), QStringLiteral("Technikum"),
+		QStringLiteral("Óvoda"), QStringLiteral("Kollégium"),
+	};
+
+	static const QStringList cities = {
+		QStringLiteral("Budapest"), QStringLiteral("Debrecen"), QStringLiteral("Szeged"), QStringLiteral("Pécs"),
+		QStringLiteral("Győr"), QStringLiteral("Miskolc"), QStringLiteral("Kecskemét"), QStringLiteral("Eger"),
+	};
+
+	const int n = names.size() * kinds.size() * cities.size();
+
+	QString txt = QStringLiteral("%1 %2, %3")
+				  .arg(names.at(index % names.size()))
+				  .arg(kinds.at((index / names.size()) % kinds.size()))
+				  .arg(cities.at((index / names.size() / kinds.size()) % cities.size()));
+
+	if (index >= n)
+		txt.append(QStringLiteral(" %1").arg(index / n + 1));
+
+	return txt;
+}
+
+
+
+/**
+ * @brief HistoryGenerator::toJson
+ * @return
+ */
+
+QJsonObject HistoryGenerator::toJson() const
+{
+	const Options &o = m_options;
+
+	QRandomGenerator gen(o.seed);
+
+	const auto chance = [&gen](const double &p) { return gen.generateDouble() < p; };
+	const auto between = [&gen](const int &min, const int &max) { return max > min ? min + gen.bounded(max-min+1) : min; };
+
+	const QStringList &types = Application::jobTypeList();
+	const int weightSum = std::max(1, o.modeWeights[0] + o.modeWeights[1] + o.modeWeights[2]);
+	const int range = std::max<qint64>(1, o.from.daysTo(o.asOf));
+
+	QJsonArray jobList;
+	QJsonArray calcList;
+
+	QDate prevStart;
+	QDate prevEnd;
+	int calcId = 1;
+
+	for (int i=1; i<=o.jobs; ++i) {
+		QDate start;
+
+		if (prevStart.isValid() && chance(o.overlap)) {
+			start = prevStart.addDays(between(0, std::max<qint64>(0, prevStart.daysTo(prevEnd))));
+		} else if (prevEnd.isValid()) {
+			start = prevEnd.addDays(1 + between(0, o.maxGap));
+		} else {
+			start = o.from.addDays(between(0, range / 10));
+		}
+
+		// Long histories start again from the beginning of the period
+
+		if (start >= o.asOf)
+			start = o.from.addDays(between(0, range / 10));
+
+		const QDate &end = start.addDays(between(o.minDays, o.maxDays));
+		const bool openEnded = chance(o.openEnded);
+
+		QJsonObject job;
+		job.insert(QStringLiteral("id"), i);
+		job.insert(QStringLiteral("start"), start.toString(QStringLiteral("yyyy-MM-dd")));
+
+		if (!openEnded)
+			job.insert(QStringLiteral("end"), end.toString(QStringLiteral("yyyy-MM-dd")));
+
+		job.insert(QStringLiteral("name"), QStringLiteral("pedagógus"));
+		job.insert(QStringLiteral("master"), employerName(between(0, std::max(1, o.employers)-1)));
+		job.insert(QStringLiteral("type"), types.at(gen.bounded(types.size())));
+		job.insert(QStringLiteral("hour"), chance(0.8) ? 40 : between(10, 39));
+		job.insert(QStringLiteral("value"), between(10, 26));
+
+		jobList.append(job);
+
+		for (int type=2; type<=3; ++type) {
+			if (!chance(o.calcRatio))
+				continue;
+
+			const int w = gen.bounded(weightSum);
+			const int mode = w < o.modeWeights[0] ? 0 : w < o.modeWeights[0] + o.modeWeights[1] ? 1 : 2;
+
+			QJsonObject calc;
+			calc.insert(QStringLiteral("id"), calcId++);
+			calc.insert(QStringLiteral("jobid"), i);
+			calc.insert(QStringLiteral("type"), type);
+			calc.insert(QStringLiteral("mode"), mode);
+
+			if (mode == 2) {
+				calc.insert(QStringLiteral("years"), between(0, 8));
+				calc.insert(QStringLiteral("days"), between(0, 364));
+			}
+
+			calcList.append(calc);
+		}
+
+		// An open-ended job runs until asOf: the next jobs continue the chain of the closed ones
+
+		if (!openEnded) {
+			prevStart = start;
+			prevEnd = end;
+		}
+	}
+
+	QJsonObject json;
+	json.insert(QStringLiteral("_type"), QStringLiteral("TimeCalculator"));
+	json.insert(QStringLiteral("_version"), 0);
+	json.insert(QStringLiteral("title"), QStringLiteral("Generált adatbázis (%1 munkakör, seed: %2)").arg(o.jobs).arg(o.seed));
+	json.insert(QStringLiteral("asOf"), o.asOf.toString(QStringLiteral("yyyy-MM-dd")));
+	json.insert(QStringLiteral("jobs"), jobList);
+	json.insert(QStringLiteral("calculations"), calcList);
+
+	return json;
+}
+
+
+
+/**
+ * @brief HistoryGenerator::toXlsx
+ * Import spreadsheet of the jobs (calculation settings are not part of the import)
+ * @return
+ */
+
+QByteArray HistoryGenerator::toXlsx() const
+{
+	static const QList<std::pair<QString, QString>> columns = {
+		{ QStringLiteral("start"), QStringLiteral("Jogviszony kezdete") },
+		{ QStringLiteral("end"), QStringLiteral("Jogviszony vége") },
+		{ QStringLiteral("name"), QStringLiteral("Munkakör") },
+		{ QStringLiteral("master"), QStringLiteral("Munkáltató") },
+		{ QStringLiteral("type"), QStringLiteral("Jogviszony típusa") },
+		{ QStringLiteral("hour"), QStringLiteral("Munkaidő") },
+		{ QStringLiteral("value"), QStringLiteral("Heti óraszám") },
+	};
+
+	QXlsx::Document doc;
+
+	for (int i=0; i<columns.size(); ++i)
+		doc.write(1, i+1, columns.at(i).second);
+
+	int row = 2;
+
+	for (const QJsonValue &v : toJson().value(QStringLiteral("jobs")).toArray()) {
+		const QJsonObject &job = v.toObject();
+
+		for (int i=0; i<columns.size(); ++i) {
+			const QString &key = columns.at(i).first;
+
+			if (!job.contains(key))
+				continue;
+
+			if (key == QStringLiteral("start") || key == QStringLiteral("end"))
+				doc.write(row, i+1, QDate::fromString(job.value(key).toString(), QStringLiteral("yyyy-MM-dd")));
+			else
+				doc.write(row, i+1, job.value(key).toVariant());
+		}
+
+		++row;
+	}
+
+	QByteArray content;
+	QBuffer buffer(&content);
+	buffer.open(QIODevice::WriteOnly);
+	doc.saveAs(&buffer);
+	buffer.close();
+
+	return content;
+}
@@ -0,0 +1,76 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * historygenerator.h
+ *
+ * Created on: 2024. 01. 26.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * HistoryGenerator
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef HISTORYGENERATOR_H
+#define HISTORYGENERATOR_H
+
+#include <QDate>
+#include <QJsonObject>
+
+
+/**
+ * @brief The HistoryGenerator class
+ *
+ * Synthetic employment histories for load and stress tests, written as TimeCalculator JSON file
+ * or as import spreadsheet. The same options and seed always give the same file.
+ */
+
+class HistoryGenerator
+{
+public:
+	struct Options {
+		int jobs = 100;
+		quint32 seed = 1;
+
+		double overlap = 0.2;			// Probability of a job starting before the previous one ends
+		double openEnded = 0.1;			// Ratio of jobs without end date
+		int employers = 20;				// Number of different employers
+
+		double calcRatio = 0.3;			// Probability of a practice/prestige setting for a job
+		int modeWeights[3] = { 10, 70, 20 };	// Weights of not counted / calculated / manual settings
+
+		int minDays = 30;
+		int maxDays = 3000;
+		int maxGap = 180;
+
+		QDate from = QDate(1980, 1, 1);
+		QDate asOf = QDate(2024, 1, 1);
+	};
+
+	explicit HistoryGenerator(const Options &options = Options());
+
+	const Options &options() const { return m_options; }
+
+	QJsonObject toJson() const;
+	QByteArray toXlsx() const;
+
+	static QString employerName(const int &index);
+
+private:
+	Options m_options;
+};
+
+#endif // HISTORYGENERATOR_H
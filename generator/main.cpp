@@ -0,0 +1,173 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * main.cpp
+ *
+ * Created on: 2024. 01. 26.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * Generator
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "historygenerator.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <iostream>
+
+
+/**
+ * Synthetic employment histories for load and stress tests:
+ *
+ *   generator --jobs 10000 --seed 42 -o history.json
+ *   generator --jobs 500 --overlap 0.6 --open 0.3 --employers 5 --format xlsx -o history.xlsx
+ *   generator --calc 0.5 --modes 0,50,50 > history.json
+ */
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName(QStringLiteral("generator"));
+
+	HistoryGenerator::Options options;
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(QStringLiteral("TimeCalculator history generator"));
+	parser.addHelpOption();
+
+	parser.addOptions({
+						  {{QStringLiteral("n"), QStringLiteral("jobs")}, QStringLiteral("Number of jobs"), QStringLiteral("num"),
+						   QString::number(options.jobs)},
+						  {{QStringLiteral("s"), QStringLiteral("seed")}, QStringLiteral("Random seed"), QStringLiteral("num"),
+						   QString::number(options.seed)},
+						  {QStringLiteral("overlap"), QStringLiteral("Probability of overlapping jobs (0..1)"), QStringLiteral("ratio"),
+						   QString::number(options.overlap)},
+						  {QStringLiteral("open"), QStringLiteral("Ratio of jobs without end date (0..1)"), QStringLiteral("ratio"),
+						   QString::number(options.openEnded)},
+						  {QStringLiteral("employers"), QStringLiteral("Number of different employers"), QStringLiteral("num"),
+						   QString::number(options.employers)},
+						  {QStringLiteral("calc"), QStringLiteral("Probability of a calculation setting (0..1)"), QStringLiteral("ratio"),
+						   QString::number(options.calcRatio)},
+						  {QStringLiteral("modes"), QStringLiteral("Weights of the calculation modes (not counted,calculated,manual)"),
+						   QStringLiteral("w0,w1,w2"), QStringLiteral("%1,%2,%3").arg(options.modeWeights[0])
+						   .arg(options.modeWeights[1]).arg(options.modeWeights[2])},
+						  {QStringLiteral("as-of"), QStringLiteral("Date of the calculations (yyyy-MM-dd)"), QStringLiteral("date"),
+						   options.asOf.toString(QStringLiteral("yyyy-MM-dd"))},
+						  {{QStringLiteral("f"), QStringLiteral("format")}, QStringLiteral("Output format (json, xlsx)"), QStringLiteral("format"),
+						   QStringLiteral("json")},
+						  {{QStringLiteral("o"), QStringLiteral("output")}, QStringLiteral("Output file (default: standard output)"),
+						   QStringLiteral("file")},
+					  });
+
+	parser.process(app);
+
+	const auto toInt = [&parser](const QString &name, int *dst) {
+		bool ok = false;
+		const int v = parser.value(name).toInt(&ok);
+
+		if (!ok || v < 0) {
+			std::cerr << "Invalid value: --" << qPrintable(name) << std::endl;
+			return false;
+		}
+
+		*dst = v;
+		return true;
+	};
+
+	const auto toRatio = [&parser](const QString &name, double *dst) {
+		bool ok = false;
+		const double v = parser.value(name).toDouble(&ok);
+
+		if (!ok || v < 0. || v > 1.) {
+			std::cerr << "Invalid value: --" << qPrintable(name) << std::endl;
+			return false;
+		}
+
+		*dst = v;
+		return true;
+	};
+
+	const auto toSeed = [&parser](const QString &name, quint32 *dst) {
+		bool ok = false;
+		const uint v = parser.value(name).toUInt(&ok);
+
+		if (!ok) {
+			std::cerr << "Invalid value: --" << qPrintable(name) << std::endl;
+			return false;
+		}
+
+		*dst = v;
+		return true;
+	};
+
+	if (!toInt(QStringLiteral("jobs"), &options.jobs) ||
+			!toSeed(QStringLiteral("seed"), &options.seed) ||
+			!toInt(QStringLiteral("employers"), &options.employers) ||
+			!toRatio(QStringLiteral("overlap"), &options.overlap) ||
+			!toRatio(QStringLiteral("open"), &options.openEnded) ||
+			!toRatio(QStringLiteral("calc"), &options.calcRatio))
+		return 1;
+
+	if (const QStringList &w = parser.value(QStringLiteral("modes")).split(','); w.size() == 3) {
+		for (int i=0; i<3; ++i)
+			options.modeWeights[i] = std::max(0, w.at(i).toInt());
+	} else {
+		std::cerr << "Invalid value: --modes" << std::endl;
+		return 1;
+	}
+
+	options.asOf = QDate::fromString(parser.value(QStringLiteral("as-of")), QStringLiteral("yyyy-MM-dd"));
+
+	if (!options.asOf.isValid() || options.asOf <= options.from) {
+		std::cerr << "Invalid value: --as-of" << std::endl;
+		return 1;
+	}
+
+	const QString &format = parser.value(QStringLiteral("format"));
+
+	HistoryGenerator generator(options);
+	QByteArray content;
+
+	if (format == QStringLiteral("json"))
+		content = QJsonDocument(generator.toJson()).toJson(QJsonDocument::Indented);
+	else if (format == QStringLiteral("xlsx"))
+		content = generator.toXlsx();
+	else {
+		std::cerr << "Invalid format: " << qPrintable(format) << std::endl;
+		return 1;
+	}
+
+	QFile file;
+
+	if (parser.isSet(QStringLiteral("output"))) {
+		file.setFileName(parser.value(QStringLiteral("output")));
+
+		if (!file.open(QIODevice::WriteOnly)) {
+			std::cerr << "Can't write file: " << qPrintable(file.fileName()) << std::endl;
+			return 1;
+		}
+	} else if (!file.open(stdout, QIODevice::WriteOnly)) {
+		return 1;
+	}
+
+	file.write(content);
+	file.close();
+
+	return 0;
+}
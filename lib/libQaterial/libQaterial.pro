@@ -14,9 +14,15 @@ else: TARGET = Qaterial
 DESTDIR = ../
 
 RESOURCES += \
-	$$PWD/QaterialIcons.qrc \
 	$$PWD/Qaterial-Qt6.qrc
 
+# Only the icons referenced by the QML files of the application and of Qaterial are compiled in
+# (used/QaterialIcons.qrc in the build directory, same resource name). CONFIG+=qaterial_icons_all
+# bundles the whole set.
+
+qaterial_icons_all: RESOURCES += $$PWD/QaterialIcons.qrc
+else: RESOURCES += $$OUT_PWD/used/QaterialIcons.qrc
+
 
 DEFINES += \
 	QOLM_STATIC \
@@ -51,6 +57,34 @@ linux:!exists(Qaterial-Qt6.qrc): {
 
 # Icons
 
+# QML property name of the icon file (ab-testing.svg -> abTesting)
+
+defineReplace(qaterialIconName) {
+	iconBaseName = $$replace(1, .svg,)
+
+	iconNameParts = $$split(iconBaseName, -)
+
+	partNum = $$size(iconNameParts)
+
+	qmlName =
+
+	greaterThan(partNum, 1): {
+		for (part, iconNameParts) {
+			isEmpty(qmlName): qmlName = $$part
+			else: qmlName += $$upper($$str_member($$part, 0, 0))$$str_member($$part, 1, -1)
+		}
+	} else {
+		qmlName = $$iconBaseName
+	}
+
+	restrictedNames = console delete export function import null package switch
+
+	contains(restrictedNames, $$qmlName): qmlName = $${qmlName}_
+
+	return($$join(qmlName,,,))
+}
+
+
 linux:!exists(QaterialIcons.qrc): {
 
 	lines = <RCC>
@@ -67,29 +101,9 @@ linux:!exists(QaterialIcons.qrc): {
 
 	flist = $$files($$PWD/../MaterialDesignSvgo/svg/*)
 
-	restrictedNames = console delete export function import null package switch
-
 	for (file, flist) {
 		baseName = $$basename(file)
-		iconBaseName = $$replace(baseName, .svg,)
-
-		iconNameParts = $$split(iconBaseName, -)
-
-		partNum = $$size(iconNameParts)
-
-		qmlName =
-
-		greaterThan(partNum, 1): {
-			for (part, iconNameParts) {
-				isEmpty(qmlName): qmlName = $$part
-				else: qmlName += $$upper($$str_member($$part, 0, 0))$$str_member($$part, 1, -1)
-			}
-		} else {
-			qmlName = $$iconBaseName
-		}
-
-
-		contains(restrictedNames, $$qmlName): qmlName = $${qmlName}_
+		qmlName = $$qaterialIconName($$baseName)
 
 		qmlLines += "	readonly property string $$join(qmlName,,,): \"qrc:/Qaterial/Icons/$$baseName\";"
 
@@ -107,6 +121,48 @@ linux:!exists(QaterialIcons.qrc): {
 }
 
 
+# Icons referenced as Icons.<name> (Qaterial.Icons.<name>) in the QML and JS files. Regenerated on
+# every qmake run; the scanned files are dependencies of the Makefile, so editing them re-runs qmake
+# (new QML files need a manual qmake run).
+
+!qaterial_icons_all: {
+	usedIcons =
+
+	qmlFiles = \
+		$$files($$PWD/../../qml/*.qml, true) \
+		$$files($$PWD/../../qml/*.js, true) \
+		$$files($$PWD/../Qaterial/qml/Qaterial-Qt6/*.qml, true)
+
+	QMAKE_INTERNAL_INCLUDED_FILES += $$qmlFiles
+
+	for (qmlFile, qmlFiles) {
+		words = $$cat($$qmlFile)
+		iconWords = $$find(words, Icons\\.[a-zA-Z_]+)
+
+		for (w, iconWords): usedIcons += $$replace(w, ^.*Icons\\.([a-zA-Z0-9_]+).*$, \\1)
+	}
+
+	usedIcons = $$unique(usedIcons)
+
+	lines = <RCC>
+	lines += "<qresource prefix=\"/Qaterial/Icons\">"
+
+	flist = $$files($$PWD/../MaterialDesignSvgo/svg/*)
+
+	for (file, flist) {
+		contains(usedIcons, $$qaterialIconName($$basename(file))): \
+			lines += "	<file alias=\"$$basename(file)\">$$relative_path($$file, $$OUT_PWD/used)</file>"
+	}
+
+	lines += </qresource>
+	lines += </RCC>
+
+	message(Create used/QaterialIcons.qrc ($$size(usedIcons) icons))
+	mkpath($$OUT_PWD/used)
+	write_file($$OUT_PWD/used/QaterialIcons.qrc, lines)
+}
+
+
 # Sources
 
 HEADERS += \
@@ -2,6 +2,7 @@ import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
 import Qaterial as Qaterial
+import TimeCalculator
 import "./QaterialHelper" as Qaterial
 
 Qaterial.ToolBar {
@@ -0,0 +1,40 @@
+import QtQuick
+import TimeCalculator
+
+// Asynchronous call of App.database: the callback gets the result of requestFinished()
+
+QtObject {
+	id: root
+
+	property var _callbacks: ({})
+
+	readonly property Connections _connections: Connections {
+		target: App.database
+
+		function onRequestFinished(request : int, result : variant) {
+			let f = root._callbacks[request]
+
+			if (f === undefined)
+				return
+
+			delete root._callbacks[request]
+
+			if (f)
+				f(result)
+		}
+	}
+
+	function call(_method : string, _args : variant, _callback : variant) : bool {
+		if (!App.database)
+			return false
+
+		let id = App.database.request(_method, _args)
+
+		if (id < 0)
+			return false
+
+		_callbacks[id] = _callback ? _callback : null
+
+		return true
+	}
+}
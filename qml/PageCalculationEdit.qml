@@ -2,6 +2,7 @@ import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
 import Qaterial as Qaterial
+import TimeCalculator
 import "./QaterialHelper" as Qaterial
 
 QPage {
@@ -346,17 +347,24 @@ QPage {
 									   _prestige, _prestigeYears, _prestigeDays,
 								   ])
 
-			if (App.database.calculationEdit(editData.id, d)) {
-				App.snack(qsTr("Sikeres módosítás"))
-				_form.modified = false
-				App.stackPop()
-			} else {
-				App.messageError(qsTr("Sikertelen módosítás"))
-			}
+			_request.call("calculationEdit", [editData.id, d], function(_success) {
+				if (_success) {
+					App.snack(qsTr("Sikeres módosítás"))
+					_form.modified = false
+					App.stackPop()
+				} else {
+					App.messageError(qsTr("Sikertelen módosítás"))
+				}
+			})
 		}
 	}
 
 
+	DatabaseRequest {
+		id: _request
+	}
+
+
 	ListModel {
 		id: _calcModel
 	}
@@ -366,18 +374,20 @@ QPage {
 		if (!editData)
 			return
 
-		let d = App.database.calculationGet(editData.id)
-
-		_form.setItems([
-						   _job, _jobYears, _jobDays,
-						   _practice, _practiceYears, _practiceDays,
-						   _prestige, _prestigeYears, _prestigeDays,
-					   ], d)
+		_request.call("calculationGet", [editData.id], function(_data) {
+			_form.setItems([
+							   _job, _jobYears, _jobDays,
+							   _practice, _practiceYears, _practiceDays,
+							   _prestige, _prestigeYears, _prestigeDays,
+						   ], _data)
+		})
 
+		_request.call("overlapGet", [editData.id], overlapLoaded)
+	}
 
-		let list = App.database.overlapGet(editData.id)
 
-		_rptr.model = list
+	function overlapLoaded(_list) {
+		_rptr.model = _list
 
 		_calcModel.clear()
 
@@ -393,8 +403,8 @@ QPage {
 							  })
 		}
 
-		for (let i=0; i<list.length; ++i) {
-			let ll = list[i]
+		for (let i=0; i<_list.length; ++i) {
+			let ll = _list[i]
 
 			_calcModel.append({
 								  date: ll.start,
@@ -2,6 +2,7 @@ import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
 import Qaterial as Qaterial
+import TimeCalculator
 import "./QaterialHelper" as Qaterial
 import "JScript.js" as JS
 
@@ -20,12 +21,19 @@ QPage {
 		QMenu {
 			id: menu
 
+			QMenuItem { action: actionUndo }
+			QMenuItem { action: actionRedo }
+			Qaterial.MenuSeparator {}
 			QMenuItem { action: actionRename }
 			QMenuItem { action: actionImport }
 			Qaterial.MenuSeparator {}
 			QMenuItem { action: actionSave }
 			QMenuItem { action: _actionPrint }
 			QMenuItem { action: actionClose }
+			Qaterial.MenuSeparator { visible: App.debug }
+			QMenuItem { action: actionQueryStats; visible: App.debug; height: visible ? implicitHeight : 0 }
+			QMenuItem { action: actionTracing; visible: App.debug; height: visible ? implicitHeight : 0 }
+			QMenuItem { action: actionTraceSave; visible: App.debug; height: visible ? implicitHeight : 0 }
 		}
 	}
 
@@ -49,6 +57,30 @@ QPage {
 	}
 
 
+	DatabaseRequest {
+		id: _request
+	}
+
+
+	Action {
+		id: actionUndo
+		text: App.database && App.database.undoText !== "" ? qsTr("Visszavonás: %1").arg(App.database.undoText) : qsTr("Visszavonás")
+		icon.source: Qaterial.Icons.undo
+		enabled: App.database && App.database.canUndo
+		shortcut: "Ctrl+Z"
+		onTriggered: _request.call("undo", [], null)
+	}
+
+	Action {
+		id: actionRedo
+		text: App.database && App.database.redoText !== "" ? qsTr("Ismét: %1").arg(App.database.redoText) : qsTr("Ismét")
+		icon.source: Qaterial.Icons.redo
+		enabled: App.database && App.database.canRedo
+		shortcut: "Ctrl+Shift+Z"
+		onTriggered: _request.call("redo", [], null)
+	}
+
+
 	Action {
 		id: actionSave
 		text: qsTr("Mentés")
@@ -79,6 +111,30 @@ QPage {
 		}
 	}
 
+	Action {
+		id: actionQueryStats
+		text: qsTr("SQL statisztika")
+		icon.source: Qaterial.Icons.informationOutline
+		shortcut: "Ctrl+Shift+D"
+		onTriggered: App.stackPushPage("PageQueryStats.qml")
+	}
+
+	Action {
+		id: actionTracing
+		text: qsTr("Nyomkövetés")
+		checkable: true
+		checked: App.tracing
+		onToggled: App.tracing = checked
+	}
+
+	Action {
+		id: actionTraceSave
+		text: qsTr("Nyomkövetés mentése")
+		icon.source: Qaterial.Icons.contentSave
+		shortcut: "Ctrl+Shift+T"
+		onTriggered: App.traceSave()
+	}
+
 	Action {
 		id: actionImport
 		text: qsTr("Importálás")
@@ -147,14 +203,22 @@ QPage {
 
 				width: 200
 
+				property bool _custom: false
+
 				model: [
 					{ value: -1, text: qsTr("Mai dátum") },
-					{ value: 20240101, text: new Date(2024, 0, 1).toLocaleDateString(Qt.locale(), "yyyy. MMMM d.") }
+					{ value: 20240101, text: new Date(2024, 0, 1).toLocaleDateString(Qt.locale(), "yyyy. MMMM d.") },
+					{ value: 0, text: qsTr("Egyéni dátum") }
 				]
 
 				textRole: "text"
 				valueRole: "value"
 				onActivated: {
+					_custom = (currentValue === 0)
+
+					if (_custom)
+						return
+
 					App.database.prestigeCalculationTime = currentValue
 					App.database.sync()
 				}
@@ -163,12 +227,74 @@ QPage {
 					if (!App.database)
 						return -1
 
+					if (_custom)
+						return model.length-1
+
 					for (let n=0; n<model.length; ++n) {
 						if (model[n].value === App.database.prestigeCalculationTime)
 							return n
 					}
 
-					return -1
+					return model.length-1
+				}
+			}
+
+			Qaterial.TextField {
+				anchors.verticalCenter: parent.verticalCenter
+				font: Qaterial.Style.textTheme.body2
+				width: 150
+
+				visible: _combo1.currentIndex === _combo1.model.length-1
+
+				placeholderText: qsTr("ÉÉÉÉ-HH-NN")
+				inputMethodHints: Qt.ImhDate
+				validator: RegularExpressionValidator { regularExpression: /^(\d{4}-\d{2}-\d{2})?$/ }
+
+				text: App.database && !isNaN(App.database.prestigeCutoff) ?
+						  App.database.prestigeCutoff.toLocaleDateString(Qt.locale(), "yyyy-MM-dd") : ""
+
+				onEditingFinished: {
+					if (!App.database || text === "")
+						return
+
+					App.database.prestigeCutoff = Date.fromLocaleDateString(Qt.locale(), text, "yyyy-MM-dd")
+					App.database.sync()
+				}
+			}
+
+			Qaterial.LabelCaption {
+				text: qsTr("Számítás napja:")
+				anchors.verticalCenter: parent.verticalCenter
+			}
+
+			Qaterial.TextField {
+				anchors.verticalCenter: parent.verticalCenter
+				font: Qaterial.Style.textTheme.body2
+				width: 150
+
+				placeholderText: qsTr("Mai dátum")
+				inputMethodHints: Qt.ImhDate
+				validator: RegularExpressionValidator { regularExpression: /^(\d{4}-\d{2}-\d{2})?$/ }
+
+				text: App.database && !isNaN(App.database.asOf) ?
+						  App.database.asOf.toLocaleDateString(Qt.locale(), "yyyy-MM-dd") : ""
+
+				onEditingFinished: {
+					if (!App.database)
+						return
+
+					App.database.asOf = text === "" ? new Date(NaN) : Date.fromLocaleDateString(Qt.locale(), text, "yyyy-MM-dd")
+				}
+			}
+
+			Qaterial.CheckBox {
+				anchors.verticalCenter: parent.verticalCenter
+				text: qsTr("Átfedések egyszer számítva")
+				font: Qaterial.Style.textTheme.body2
+				checked: App.database && App.database.unionMode
+				onToggled: {
+					App.database.unionMode = checked
+					App.database.sync()
 				}
 			}
 		}
@@ -193,17 +319,92 @@ QPage {
 			width: _view.width
 		}
 
+		Flow {
+			anchors.left: _view.left
+			width: _view.width
+			spacing: 10
+
+			visible: App.database && !App.database.paged
+
+			Qaterial.TextField {
+				width: 250
+				placeholderText: qsTr("Keresés (munkakör, munkáltató)")
+				font: Qaterial.Style.textTheme.body2
+				onTextChanged: if (App.database) App.database.proxyModel.filterText = text
+			}
+
+			Qaterial.ComboBox {
+				width: 200
+				font: Qaterial.Style.textTheme.body2
+
+				model: [
+					{ value: JobProxyModel.SortId, text: qsTr("Rögzítés sorrendje") },
+					{ value: JobProxyModel.SortStart, text: qsTr("Kezdete szerint") },
+					{ value: JobProxyModel.SortEnd, text: qsTr("Vége szerint") },
+					{ value: JobProxyModel.SortDuration, text: qsTr("Időtartam szerint") },
+					{ value: JobProxyModel.SortType, text: qsTr("Típus szerint") },
+					{ value: JobProxyModel.SortEmployer, text: qsTr("Munkáltató szerint") }
+				]
+
+				textRole: "text"
+				valueRole: "value"
+				onActivated: App.database.proxyModel.sortField = currentValue
+			}
+
+			Qaterial.RoundButton {
+				icon.source: App.database && App.database.proxyModel.sortOrder === Qt.DescendingOrder ?
+								 Qaterial.Icons.sortDescending : Qaterial.Icons.sortAscending
+				foregroundColor: Qaterial.Style.iconColor()
+				onClicked: App.database.proxyModel.sortOrder = (App.database.proxyModel.sortOrder === Qt.AscendingOrder ?
+																	Qt.DescendingOrder : Qt.AscendingOrder)
+			}
+
+			Qaterial.ComboBox {
+				width: 250
+				font: Qaterial.Style.textTheme.body2
+				model: [qsTr("Minden jogviszony")].concat(App.jobTypeList)
+				onActivated: App.database.proxyModel.filterType = currentIndex > 0 ? currentText : ""
+			}
+
+			Qaterial.CheckBox {
+				text: qsTr("Csak átfedések")
+				onToggled: App.database.proxyModel.filterOverlap = checked
+			}
+		}
+
 		ListView {
 			id: _view
 
-			height: contentHeight
+			readonly property bool _paged: App.database && App.database.paged
+
+			// Paged model: only the visible delegates are created and rows are fetched while scrolling
+
+			height: _paged ? Math.min(contentHeight, control.height) : contentHeight
+			interactive: _paged
+			clip: _paged
 
 			width: Math.min(parent.width, Qaterial.Style.maxContainerSize)
 			anchors.horizontalCenter: parent.horizontalCenter
 
 			boundsBehavior: Flickable.StopAtBounds
 
-			model: App.database ? App.database.model : null
+			model: App.database ? (_paged ? App.database.pagedModel : App.database.proxyModel) : null
+
+			// The stale rows of the paged model are fetched again when they become visible
+
+			onContentYChanged: _updateVisibleRange()
+			onHeightChanged: _updateVisibleRange()
+			onCountChanged: _updateVisibleRange()
+
+			function _updateVisibleRange() {
+				if (!_paged)
+					return
+
+				let first = indexAt(width/2, contentY)
+				let last = indexAt(width/2, contentY+height-1)
+
+				App.database.pagedModel.setVisibleRange(first < 0 ? 0 : first, last < 0 ? count-1 : last)
+			}
 
 			delegate: Qaterial.LoaderItemDelegate {
 				width: ListView.view.width
@@ -219,6 +420,7 @@ QPage {
 				secondaryText: new Date(model.start).toLocaleDateString(Qt.locale(), "yyyy. MMMM d.")
 							   + (model.end ? (" - " + new Date(model.end).toLocaleDateString(Qt.locale(), "yyyy. MMMM d.")) : "")
 							   + qsTr(" (%1 év %2 nap)").arg(model.durationYears).arg(model.durationDays)
+							   + (model.cluster > 0 ? qsTr(" – átfedési csoport #%1").arg(model.cluster) : "")
 
 
 
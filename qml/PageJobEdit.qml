@@ -2,6 +2,7 @@ import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
 import Qaterial as Qaterial
+import TimeCalculator
 import "./QaterialHelper" as Qaterial
 
 QPage {
@@ -161,6 +162,11 @@ QPage {
 	}
 
 
+	DatabaseRequest {
+		id: _request
+	}
+
+
 	Action {
 		id: _actionSave
 		text: qsTr("Kész")
@@ -187,21 +193,25 @@ QPage {
 			}
 
 			if (editData) {
-				if (App.database.jobEdit(editData.id, d)) {
-					App.snack(qsTr("Sikeres módosítás"))
-					_form.modified = false
-					App.stackPop()
-				} else {
-					App.messageError(qsTr("Sikertelen módosítás"))
-				}
+				_request.call("jobEdit", [editData.id, d], function(_success) {
+					if (_success) {
+						App.snack(qsTr("Sikeres módosítás"))
+						_form.modified = false
+						App.stackPop()
+					} else {
+						App.messageError(qsTr("Sikertelen módosítás"))
+					}
+				})
 			} else {
-				if (App.database.jobAdd(d)) {
-					App.snack(qsTr("Új munkakör létrehozva"))
-					_form.modified = false
-					App.stackPop()
-				} else {
-					App.messageError(qsTr("Nem sikerült rögzíteni"))
-				}
+				_request.call("jobAdd", [d], function(_id) {
+					if (_id > 0) {
+						App.snack(qsTr("Új munkakör létrehozva"))
+						_form.modified = false
+						App.stackPop()
+					} else {
+						App.messageError(qsTr("Nem sikerült rögzíteni"))
+					}
+				})
 			}
 		}
 	}
@@ -218,13 +228,15 @@ QPage {
 						{
 							onAccepted: function()
 							{
-								if (App.database.jobDelete(editData.id)) {
-									App.snack(qsTr("Sikeres törlés"))
-									_form.modified = false
-									App.stackPop()
-								} else {
-									App.messageError(qsTr("Törlés sikertelen"))
-								}
+								_request.call("jobDelete", [editData.id], function(_success) {
+									if (_success) {
+										App.snack(qsTr("Sikeres törlés"))
+										_form.modified = false
+										App.stackPop()
+									} else {
+										App.messageError(qsTr("Törlés sikertelen"))
+									}
+								})
 							},
 							text: qsTr("Biztosan törlöd a munkakört?"),
 							title: editData.name,
@@ -0,0 +1,82 @@
+import QtQuick
+import QtQuick.Controls
+import Qaterial as Qaterial
+import TimeCalculator
+import "./QaterialHelper" as Qaterial
+
+QPage {
+	id: control
+
+	property var _stats: []
+
+	title: qsTr("SQL statisztika")
+	subtitle: qsTr("%1 lekérdezés").arg(_stats.length)
+
+	appBar.rightComponent: Row {
+		Qaterial.AppBarButton {
+			icon.source: Qaterial.Icons.refresh
+			ToolTip.text: qsTr("Frissítés")
+			onClicked: reload()
+		}
+
+		Qaterial.AppBarButton {
+			icon.source: Qaterial.Icons.delete_
+			ToolTip.text: qsTr("Nullázás")
+			onClicked: {
+				App.queryStatsReset()
+				reload()
+			}
+		}
+	}
+
+	QScrollable {
+		anchors.fill: parent
+		horizontalPadding: 0
+
+		refreshEnabled: true
+		onRefreshRequest: reload()
+
+		QLabelInformative {
+			visible: _stats.length === 0
+			text: qsTr("Nincs végrehajtott lekérdezés")
+		}
+
+		ListView {
+			id: _view
+
+			height: contentHeight
+			interactive: false
+
+			width: Math.min(parent.width, Qaterial.Style.maxContainerSize)
+			anchors.horizontalCenter: parent.horizontalCenter
+
+			model: _stats
+
+			delegate: Qaterial.ItemDelegate {
+				width: ListView.view.width
+
+				text: modelData.sql
+				secondaryText: qsTr("%1× – összesen %2 ms, átlag %3 µs, p99 %4 µs, max %5 µs – %6 sor")
+							   .arg(modelData.count)
+							   .arg((modelData.total / 1000).toFixed(1))
+							   .arg(modelData.mean.toFixed(0))
+							   .arg(modelData.p99.toFixed(0))
+							   .arg(modelData.max.toFixed(0))
+							   .arg(modelData.rows)
+
+				onClicked: App.messageInfo(qsTr("prepare: %1 µs\nbind: %2 µs\nstep: %3 µs\n\n%4")
+										   .arg(modelData.prepare.toFixed(0))
+										   .arg(modelData.bind.toFixed(0))
+										   .arg(modelData.step.toFixed(0))
+										   .arg(modelData.sql),
+										   qsTr("SQL statisztika"))
+			}
+		}
+	}
+
+	function reload() {
+		_stats = App.queryStats()
+	}
+
+	Component.onCompleted: reload()
+}
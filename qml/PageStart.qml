@@ -2,6 +2,7 @@ import QtQuick
 import QtQuick.Controls
 import QtQuick.Layouts
 import Qaterial as Qaterial
+import TimeCalculator
 import "./QaterialHelper" as Qaterial
 import "JScript.js" as JS
 
@@ -20,6 +21,7 @@ QPage {
 		QMenu {
 			id: menu
 
+			QMenuItem { action: actionJubilee }
 			QMenuItem { action: actionAbout }
 		}
 	}
@@ -58,6 +60,23 @@ QPage {
 	}
 
 
+	Action {
+		id: actionJubilee
+		text: qsTr("Jubileumi naptár")
+		icon.source: Qaterial.Icons.calendarStar
+		enabled: Qt.platform.os !== "wasm"
+		onTriggered: {
+			Qaterial.DialogManager.showTextFieldDialog({
+														   textTitle: qsTr("Mappa vagy fájllista"),
+														   title: qsTr("Jubileumi jutalmak a következő 12 hónapban"),
+														   standardButtons: DialogButtonBox.Cancel | DialogButtonBox.Ok,
+														   onAccepted: function(_text, _noerror) {
+															   App.jubileeExport(_text)
+														   }
+													   })
+		}
+	}
+
 	Action {
 		id: actionAbout
 		text: qsTr("Névjegy")
@@ -24,12 +24,17 @@
  *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include "Logger.h"
+#include "logfilter.h"
+#include "tracer.h"
+#include <QCommandLineParser>
 #include <QFontDatabase>
 #include <QDebug>
+#include <QJsonDocument>
 #include <Qaterial/Qaterial.hpp>
 #include <QMetaObject>
 #include <QQuickWindow>
+#include <QTextStream>
+#include <QTimer>
 
 #include "abstractapplication.h"
 #include "../version/version.h"
@@ -55,6 +60,7 @@ const int AbstractApplication::m_versionMinor = VERSION_MINOR;
 const int AbstractApplication::m_versionBuild = VERSION_BUILD;
 const char *AbstractApplication::m_version = VERSION_FULL;
 AbstractApplication *AbstractApplication::m_instance = nullptr;
+QElapsedTimer AbstractApplication::m_startupTimer;
 
 #ifdef QT_NO_DEBUG
 const bool AbstractApplication::m_debug = false;
@@ -72,6 +78,8 @@ const bool AbstractApplication::m_debug = true;
 
 void AbstractApplication::initialize()
 {
+	m_startupTimer.start();
+
 	QCoreApplication::setApplicationName(QStringLiteral("TimeCalculator"));
 	QCoreApplication::setOrganizationDomain(QStringLiteral("TimeCalculator"));
 	QCoreApplication::setApplicationVersion(m_version);
@@ -92,12 +100,18 @@ void AbstractApplication::initialize()
 
 bool AbstractApplication::loadMainQml()
 {
+	TRACE_SCOPE("loadMainQml");
+
 	const QUrl url(QStringLiteral("qrc:/main.qml"));
 	QObject::connect(m_engine.get(), &QQmlApplicationEngine::objectCreated,
-					 m_application, [url](QObject *obj, const QUrl &objUrl) {
+					 m_application, [this, url](QObject *obj, const QUrl &objUrl) {
 		if (!obj && url == objUrl)
 			QCoreApplication::exit(-1);
 
+		if (QQuickWindow *window = qobject_cast<QQuickWindow*>(obj))
+			QObject::connect(window, &QQuickWindow::frameSwapped, this, &AbstractApplication::onFirstFrame,
+							 Qt::SingleShotConnection);
+
 #if defined(Q_OS_ANDROID)
 #if QT_VERSION < 0x060000
 		QtAndroid::hideSplashScreen();
@@ -135,12 +149,122 @@ void AbstractApplication::loadFonts(const QStringList &fontList)
 }
 
 
+/**
+ * @brief AbstractApplication::loadFontsDeferred
+ * In lazy startup mode the fonts are loaded after the first frame
+ * @param fontList
+ */
+
+void AbstractApplication::loadFontsDeferred(const QStringList &fontList)
+{
+	if (m_lazyStartup)
+		m_deferredFonts.append(fontList);
+	else
+		loadFonts(fontList);
+}
+
+
+
+/**
+ * @brief AbstractApplication::onFirstFrame
+ * First frame of the main window swapped: load the deferred resources
+ */
+
+void AbstractApplication::onFirstFrame()
+{
+	const qint64 elapsed = m_startupTimer.nsecsElapsed();
+
+	if (Tracer::enabled())
+		Tracer::add("firstFrame", "app", Tracer::now() - elapsed, elapsed);
+
+	LOG_CINFO("app") << "First frame after" << elapsed / 1000000 << "ms";
+
+	if (!m_deferredFonts.isEmpty())
+		loadFonts(std::exchange(m_deferredFonts, {}));
+
+	if (m_startupBenchmark) {
+		QTextStream(stdout) << "first-frame-ms: " << elapsed / 1000000. << Qt::endl;
+
+		if (m_benchmarkPage.isEmpty()) {
+			QTimer::singleShot(0, m_application, &QCoreApplication::quit);
+			return;
+		}
+
+		// The page is pushed when the database is loaded and its models are synchronized
+
+		QFuture<bool> future = m_benchmarkDatabase.isEmpty() ? QtFuture::makeReadyFuture(true)
+															 : benchmarkDatabaseOpen(m_benchmarkDatabase);
+
+		future.then(this, [this](bool success) {
+			if (!success) {
+				LOG_CERROR("app") << "Can't open database:" << qPrintable(m_benchmarkDatabase);
+			} else {
+				QElapsedTimer timer;
+				timer.start();
+
+				if (stackPushPage(m_benchmarkPage, m_benchmarkParameters))
+					QTextStream(stdout) << "page-push-ms: " << timer.nsecsElapsed() / 1000000. << Qt::endl;
+			}
+
+			QTimer::singleShot(0, m_application, &QCoreApplication::quit);
+		});
+	}
+}
+
+
+
+/**
+ * @brief AbstractApplication::benchmarkDatabaseOpen
+ * Open the database of the page benchmark (not supported by default)
+ * @param fileName
+ * @return
+ */
+
+QFuture<bool> AbstractApplication::benchmarkDatabaseOpen(const QString &fileName)
+{
+	Q_UNUSED(fileName);
+	return QtFuture::makeReadyFuture(false);
+}
+
+
+
+/**
+ * @brief benchmarkValue
+ * Page parameter of the startup benchmark from JSON: yyyy-MM-dd strings are passed as dates
+ * (as in the rows of the models)
+ * @param value
+ * @return
+ */
+
+static QVariant benchmarkValue(const QVariant &value)
+{
+	if (value.typeId() == QMetaType::QVariantMap) {
+		QVariantMap map = value.toMap();
+
+		for (QVariant &v : map)
+			v = benchmarkValue(v);
+
+		return map;
+	}
+
+	if (value.typeId() == QMetaType::QString) {
+		if (const QDate &date = QDate::fromString(value.toString(), QStringLiteral("yyyy-MM-dd")); date.isValid())
+			return date;
+	}
+
+	return value;
+}
+
+
+
 /**
  * @brief AbstractApplication::loadQaterial
  */
 
 void AbstractApplication::loadQaterial()
 {
+	TRACE_SCOPE("loadQaterial");
+
 	m_engine->addImportPath(QStringLiteral("qrc:/"));
 
 	qaterial::setDefaultFontFamily(MAIN_FONT);
@@ -208,6 +332,41 @@ AbstractApplication::~AbstractApplication()
 
 int AbstractApplication::run()
 {
+	QCommandLineParser parser;
+	const QCommandLineOption traceOption(QStringLiteral("trace"),
+										 QStringLiteral("Write Chrome trace events to <file> on exit"),
+										 QStringLiteral("file"));
+	const QCommandLineOption eagerOption(QStringLiteral("eager-startup"),
+										 QStringLiteral("Load every resource before the first frame"));
+	const QCommandLineOption benchmarkOption(QStringLiteral("startup-benchmark"),
+											 QStringLiteral("Print the time to the first frame and quit"));
+	const QCommandLineOption benchmarkPageOption(QStringLiteral("benchmark-page"),
+												 QStringLiteral("Push <qml> after the first frame and print its loading time (startup benchmark)"),
+												 QStringLiteral("qml"));
+	const QCommandLineOption benchmarkDatabaseOption(QStringLiteral("benchmark-database"),
+													 QStringLiteral("Open <file> before the page is pushed (startup benchmark)"),
+													 QStringLiteral("file"));
+	const QCommandLineOption benchmarkParametersOption(QStringLiteral("benchmark-page-parameters"),
+													   QStringLiteral("Parameters of the pushed page as JSON object (startup benchmark)"),
+													   QStringLiteral("json"));
+	parser.addOptions({traceOption, eagerOption, benchmarkOption, benchmarkPageOption,
+					   benchmarkDatabaseOption, benchmarkParametersOption});
+	parser.parse(m_application->arguments());
+
+	const QString &traceFile = parser.value(traceOption);
+
+	m_lazyStartup = !parser.isSet(eagerOption);
+	m_startupBenchmark = parser.isSet(benchmarkOption);
+	m_benchmarkPage = parser.value(benchmarkPageOption);
+	m_benchmarkDatabase = parser.value(benchmarkDatabaseOption);
+	m_benchmarkParameters = benchmarkValue(QJsonDocument::fromJson(parser.value(benchmarkParametersOption).toUtf8())
+										   .object().toVariantMap()).toMap();
+
+	if (!traceFile.isEmpty())
+		Tracer::setEnabled(true);
+
+	Tracer::Scope startup("startup");
+
 	registerQmlTypes();
 	loadQaterial();
 
@@ -231,12 +390,17 @@ int AbstractApplication::run()
 
 	retranslate(Utils::settingsGet(QStringLiteral("window/language"), QStringLiteral("hu")).toString());
 
+	startup.finish();
+
 	LOG_CINFO("app") << "Run Application";
 
 	const int r = m_application->exec();
 
 	LOG_CINFO("app") << "Application finished with code" << r;
 
+	if (!traceFile.isEmpty())
+		Tracer::save(traceFile);
+
 	return r;
 }
 
@@ -558,6 +722,11 @@ QQuickItem *AbstractApplication::stackPushPage(QString qml, QVariantMap paramete
 		return nullptr;
 	}
 
+	TRACE_SCOPE("stackPushPage");
+
+	QElapsedTimer timer;
+	timer.start();
+
 	QQuickItem *o = nullptr;
 	QMetaObject::invokeMethod(m_mainStack, "createPage", Qt::DirectConnection,
 							  Q_RETURN_ARG(QQuickItem*, o),
@@ -570,7 +739,7 @@ QQuickItem *AbstractApplication::stackPushPage(QString qml, QVariantMap paramete
 		return nullptr;
 	}
 
-	LOG_CDEBUG("app") << "Lap betöltve:" << qPrintable(qml) << o;
+	LOG_CDEBUG("app") << "Lap betöltve:" << qPrintable(qml) << o << timer.elapsed() << "ms";
 
 	return o;
 }
@@ -995,9 +1164,8 @@ void AbstractApplication::wasmSave(const QByteArray &content, const QString &nam
 
 	const std::string &filename = name.toStdString();
 	const std::string &mime_type = mime.toStdString();
-	const std::string &data = content.toStdString();
 
-	emscripten_browser_file::download(filename, mime_type, data);
+	emscripten_browser_file::download(filename, mime_type, std::string_view(content.constData(), content.size()));
 }
 
 
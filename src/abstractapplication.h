@@ -27,6 +27,8 @@
 #ifndef ABSTRACTAPPLICATION_H
 #define ABSTRACTAPPLICATION_H
 
+#include <QElapsedTimer>
+#include <QFuture>
 #include <QGuiApplication>
 #include <QQuickWindow>
 #include <QQuickItem>
@@ -47,6 +49,7 @@ Q_DECLARE_OPAQUE_POINTER(Utils*)
 class AbstractApplication : public QObject
 {
 	Q_OBJECT
+	QML_ANONYMOUS
 
 	Q_PROPERTY(QQuickItem *mainStack READ mainStack WRITE setMainStack NOTIFY mainStackChanged FINAL)
 	Q_PROPERTY(QQuickWindow *mainWindow READ mainWindow WRITE setMainWindow NOTIFY mainWindowChanged FINAL)
@@ -143,8 +146,12 @@ protected:
 	virtual void setAppContextProperty() = 0;
 
 	void loadFonts(const QStringList &fontList);
+	void loadFontsDeferred(const QStringList &fontList);
 	void loadQaterial();
 
+	virtual void onFirstFrame();
+	virtual QFuture<bool> benchmarkDatabaseOpen(const QString &fileName);
+
 #ifdef Q_OS_WASM
 	void enableTabCloseConfirmation(bool enable);
 	//void wasmOpen(const QString &accept, void(*func)(const QByteArray &, const QString &));
@@ -160,12 +167,20 @@ protected:
 
 	static AbstractApplication *m_instance;
 	static const bool m_debug;
+	static QElapsedTimer m_startupTimer;
 
 	QGuiApplication *const m_application;
 	std::unique_ptr<QQmlApplicationEngine> m_engine;
 	std::unique_ptr<Utils> m_utils;
 	std::unique_ptr<QTranslator> m_translator;
 
+	bool m_lazyStartup = true;
+	bool m_startupBenchmark = false;
+	QString m_benchmarkPage;
+	QString m_benchmarkDatabase;
+	QVariantMap m_benchmarkParameters;
+	QStringList m_deferredFonts;
+
 	QQuickItem *m_mainStack = nullptr;
 	QQuickWindow *m_mainWindow = nullptr;
 	bool m_mainWindowClosable = false;
@@ -3,11 +3,19 @@ lessThan(QT_MAJOR_VERSION, 6): error(Minimum Qt version 6 required)
 TEMPLATE = app
 TARGET = TimeCalculator
 
-QT += gui quick svg quickcontrols2 sql printsupport
+QT += gui quick svg quickcontrols2 sql printsupport concurrent
 
-CONFIG += c++17
+CONFIG += c++20
 CONFIG += separate_debug_info
 
+# QML module: the types are registered declaratively (QML_ELEMENT) and the qml files
+# of the resources are compiled ahead of time by qmlcachegen
+
+CONFIG += qmltypes qtquickcompiler
+
+QML_IMPORT_NAME = TimeCalculator
+QML_IMPORT_MAJOR_VERSION = 1
+
 include(../common.pri)
 include(../version/version.pri)
 include(../translations/translations.pri)
@@ -23,12 +31,10 @@ include(../lib/import_lib.pri)
 }
 
 
+include(sources.pri)
+
 SOURCES += \
-	abstractapplication.cpp \
-	application.cpp \
-	database.cpp \
-	main.cpp \
-	utils_.cpp
+	main.cpp
 
 wasm {
 	SOURCES += \
@@ -39,21 +45,18 @@ wasm {
 
 } else {
 	SOURCES += \
+		asyncappender.cpp \
 		desktopapplication.cpp
 
 	HEADERS += \
+		asyncappender.h \
 		desktopapplication.h
 }
 
 
 
 HEADERS += \
-	../version/version.h \
-	abstractapplication.h \
-	application.h \
-	database.h \
-	querybuilder.hpp \
-	utils_.h
+	../version/version.h
 
 RESOURCES += \
 	../qml/qml.qrc \
@@ -25,10 +25,17 @@
  */
 
 #include "application.h"
-#include "Logger.h"
+#include "logfilter.h"
 #include "qtextdocument.h"
+#include <QDir>
 #include <QPdfWriter>
+#include <QPointer>
+#include <QSaveFile>
 #include "utils_.h"
+#include "civilcalendar.hpp"
+#include "durationcache.h"
+#include "querystats.h"
+#include "tracer.h"
 #include "xlsxdatavalidation.h"
 #include "xlsxdocument.h"
 
@@ -62,8 +69,13 @@ const QStringList Application::m_jobTypeList = {
 
 Application::Application(QGuiApplication *app)
 	: AbstractApplication(app)
+	, m_databaseManager(new DatabaseManager)
 {
+	m_databaseManager->setThreaded(true);
 
+	// Every statement would be normalized, hashed and timed: only in debug builds or on request
+
+	QueryStats::setEnabled(debug() || !qEnvironmentVariableIsEmpty("TIMECALCULATOR_QUERY_STATS"));
 }
 
 
@@ -78,22 +90,54 @@ Application::~Application()
 
 
 
+/**
+ * @brief Application::create
+ * QML singleton (App) of the TimeCalculator module
+ * @return
+ */
+
+Application *Application::create(QQmlEngine *, QJSEngine *)
+{
+	Application *app = qobject_cast<Application*>(m_instance);
+
+	Q_ASSERT(app);
+
+	QJSEngine::setObjectOwnership(app, QJSEngine::CppOwnership);
+
+	return app;
+}
+
+
+
 /**
  * @brief Application::dbOpen
  */
 
-void Application::dbOpen(const QString &)
+void Application::dbOpen(const QString &accept)
 {
-	if (m_database)
-		return messageError(tr("Már meg van nyitva egy adatbázis!"));
+	dbOpenTask(accept);
+}
 
-	if (QFile::exists("/tmp/_test.json")) {
-		const auto &json = Utils::fileToJsonObject("/tmp/_test.json");
-		if (!json) {
-			messageError(tr("Érvénytelen fájl"));
-		} else {
-			loadFromJson(*json);
-		}
+
+
+/**
+ * @brief Application::dbOpenTask
+ * @return
+ */
+
+Coro::Task<> Application::dbOpenTask(const QString)
+{
+	static const QString fileName = QStringLiteral("/tmp/_test.json");
+
+	if (!QFile::exists(fileName))
+		co_return;
+
+	const auto &json = co_await Coro::run(this, []() { return Utils::fileToJsonObject(fileName); });
+
+	if (!json) {
+		messageError(tr("Érvénytelen fájl"));
+	} else {
+		loadFromJson(*json, fileName);
 	}
 }
 
@@ -108,15 +152,27 @@ void Application::dbSave()
 	if (!m_database)
 		return messageError(tr("Nincs megnyitva adatbázis!"));
 
-	const auto &json = m_database->toJson();
+	dbSaveTask();
+}
 
-	if (json) {
-		if (Utils::jsonObjectToFile(*json, "/tmp/_test.json")) {
-			snack(tr("Mentés sikerült"));
-			m_database->setModified(false);
-		} else
-			messageError(tr("Sikertelen mentés"));
-	}
+
+
+/**
+ * @brief Application::dbSaveTask
+ * @return
+ */
+
+Coro::Task<> Application::dbSaveTask()
+{
+	QPointer<Database> db = m_database;
+
+	if (co_await Coro::await(db->saveAsync(QStringLiteral("/tmp/_test.json")), this)) {
+		snack(tr("Mentés sikerült"));
+
+		if (db)
+			db->setModified(false);
+	} else
+		messageError(tr("Sikertelen mentés"));
 }
 
 
@@ -130,14 +186,58 @@ void Application::dbPrint()
 	if (!m_database)
 		return messageError(tr("Nincs megnyitva adatbázis!"));
 
-	const QByteArray &content = toTextDocument();
+	dbPrintTask();
+}
 
-	QFile f("/tmp/out.pdf");
-	f.open(QIODevice::WriteOnly);
-	f.write(content);
-	f.close();
 
-	snack(tr("PDF elkészült"));
+
+/**
+ * @brief Application::dbPrintTask
+ * @return
+ */
+
+Coro::Task<> Application::dbPrintTask()
+{
+	const QByteArray &content = co_await printContent();
+
+	if (content.isEmpty())
+		co_return;
+
+	const bool success = co_await Coro::run(this, [content]() {
+		QFile f(QStringLiteral("/tmp/out.pdf"));
+
+		if (!f.open(QIODevice::WriteOnly))
+			return false;
+
+		f.write(content);
+		f.close();
+		return true;
+	});
+
+	if (success)
+		snack(tr("PDF elkészült"));
+	else
+		messageError(tr("Sikertelen mentés"));
+}
+
+
+
+/**
+ * @brief Application::printContent
+ * Report of the database as PDF: the report is queried on the database thread, rendered on the GUI thread
+ * @return
+ */
+
+Coro::Task<QByteArray> Application::printContent()
+{
+	QPointer<Database> db = m_database;
+
+	const QString &html = co_await Coro::await(db->toMarkdownAsync(), this);
+
+	if (!db)
+		co_return QByteArray();
+
+	co_return toTextDocument(html, db->title());
 }
 
 
@@ -149,23 +249,18 @@ void Application::dbPrint()
 
 bool Application::dbCreate(const QString &title)
 {
-	if (m_database) {
-		messageError(tr("Már meg van nyitva egy adatbázis!"));
-		return false;
-	}
+	Database *db = m_databaseManager->create(title);
 
-	std::unique_ptr<Database> ptr(new Database);
+	if (!db)
+		return false;
 
-	if (ptr->prepare(ptr->databaseName())) {
-		ptr->setTitle(title);
-		ptr->sync();
-		ptr->setModified(true);
-		setDatabase(ptr);
-		stackPushPage(QStringLiteral("PageDatabase.qml"));
-		return true;
-	}
+	db->sync();
+	db->setModified(true);
+	m_databases.append(db);
+	setDatabase(db);
+	stackPushPage(QStringLiteral("PageDatabase.qml"));
 
-	return false;
+	return true;
 }
 
 
@@ -176,10 +271,21 @@ bool Application::dbCreate(const QString &title)
 
 void Application::dbClose()
 {
-	if (m_database) {
-		std::unique_ptr<Database> db;
-		setDatabase(db);
-	}
+	if (!m_database)
+		return;
+
+	Database *db = m_database;
+
+	m_databases.removeAll(db);
+	setDatabase(m_databases.isEmpty() ? nullptr : m_databases.last());
+
+	// Deleted later, after QML has dropped it. An unmodified file stays loaded for the next open,
+	// unsaved changes are dropped.
+
+	if (db->modified())
+		m_databaseManager->close(db);
+	else
+		m_databaseManager->release(db);
 }
 
 
@@ -210,18 +316,136 @@ void Application::import()
 	if (!m_database)
 		return messageError(tr("Nincs megnyitva adatbázis!"));
 
-	if (QFile::exists("/tmp/_import.xlsx")) {
-		const auto &content = Utils::fileContent("/tmp/_import.xlsx");
-		if (!content) {
-			messageError(tr("Érvénytelen fájl"));
-		} else {
-			if (!importData(*content)) {
-				messageError(tr("Hibás fájl"));
-			} else {
-				messageInfo(tr("Az importálás sikerült."));
-			}
+	importTask();
+}
+
+
+
+/**
+ * @brief Application::importTask
+ * @return
+ */
+
+Coro::Task<> Application::importTask()
+{
+	static const QString fileName = QStringLiteral("/tmp/_import.xlsx");
+
+	if (!QFile::exists(fileName))
+		co_return;
+
+	const auto &content = co_await Coro::run(this, []() { return Utils::fileContent(fileName); });
+
+	if (!content) {
+		messageError(tr("Érvénytelen fájl"));
+		co_return;
+	}
+
+	co_await importContent(*content);
+}
+
+
+
+/**
+ * @brief Application::importContent
+ * Parse the spreadsheet on the thread pool, insert the rows on the database thread,
+ * then notify after the models are synchronized
+ * @param content
+ * @return
+ */
+
+Coro::Task<> Application::importContent(const QByteArray content)
+{
+	QPointer<Database> db = m_database;
+
+	const auto &list = co_await Coro::run(this, [content]() { return importParse(content); });
+
+	if (!list || !db || !co_await Coro::await(db->jobAddBatchAsync(*list), this)) {
+		messageError(tr("Hibás fájl"));
+		co_return;
+	}
+
+	// Notify when the imported rows are already in the models
+
+	if (!db)
+		co_return;
+
+	co_await Coro::await(db->syncAsync(), this);
+
+	messageInfo(tr("Az importálás sikerült."));
+}
+
+
+
+/**
+ * @brief Application::jubileeExport
+ * @param path
+ * @param months
+ * @param format
+ */
+
+void Application::jubileeExport(const QString &path, const int &months, const QString &format)
+{
+	if (m_jubileeScheduler && m_jubileeScheduler->isRunning())
+		return messageError(tr("A feldolgozás már folyamatban van!"));
+
+	jubileeExportTask(path, months, format);
+}
+
+
+
+/**
+ * @brief Application::jubileeExportTask
+ * The files are evaluated on the thread pool, the calendar is saved next to them
+ * @param path
+ * @param months
+ * @param format
+ * @return
+ */
+
+Coro::Task<> Application::jubileeExportTask(const QString path, const int months, const QString format)
+{
+	if (!m_jubileeScheduler)
+		m_jubileeScheduler.reset(new JubileeScheduler);
+
+	if (!co_await Coro::await(m_jubileeScheduler->scan(path, QDate::currentDate(), months), this)) {
+		messageError(tr("Sikertelen feldolgozás"));
+		co_return;
+	}
+
+	QByteArray content;
+	QString ext = format;
+
+	if (format == QStringLiteral("csv"))
+		content = m_jubileeScheduler->toCsv();
+	else if (format == QStringLiteral("xlsx"))
+		content = m_jubileeScheduler->toXlsx();
+	else {
+		content = m_jubileeScheduler->toPdf();
+		ext = QStringLiteral("pdf");
+	}
+
+	const QString &fileName = QDir(JubileeScheduler::directory(path))
+							  .absoluteFilePath(QStringLiteral("jubileum_%1.%2")
+												.arg(QDate::currentDate().toString(QStringLiteral("yyyy-MM-dd")), ext));
+
+	const bool success = co_await Coro::run(this, [content, fileName]() {
+		QSaveFile f(fileName);
+
+		if (!f.open(QIODevice::WriteOnly) || f.write(content) != content.size() || !f.commit()) {
+			LOG_CWARNING("app") << "Can't write file:" << f.fileName();
+			return false;
 		}
+
+		return true;
+	});
+
+	if (!success) {
+		messageError(tr("Sikertelen mentés"));
+		co_return;
 	}
+
+	snack(tr("%1 jubileum a következő %2 hónapban: %3")
+		  .arg(m_jubileeScheduler->calendar().size()).arg(months).arg(QDir::toNativeSeparators(fileName)));
 }
 
 
@@ -235,13 +459,7 @@ void Application::import()
 
 int Application::yearsBetween(const QDate &date1, const QDate &date2)
 {
-	QDate d2 = date2.addDays(1);
-	QDate d(d2.year(), date1.month(), date1.day());
-
-	if (d2 < d)
-		return d2.year()-1-date1.year();
-	else
-		return d2.year()-date1.year();
+	return DurationCache::instance()->get(date1, date2).years;
 }
 
 
@@ -254,19 +472,113 @@ int Application::yearsBetween(const QDate &date1, const QDate &date2)
 
 int Application::daysBetween(const QDate &date1, const QDate &date2)
 {
-	QDate d2 = date2.addDays(1);
-	QDate d(d2.year(), date1.month(), date1.day());
+	return DurationCache::instance()->get(date1, date2).days;
+}
 
-	if (d2 < d) {
-		QDate from(d2.year()-1, date1.month(), date1.day());
-		return from.daysTo(d2);
-	} else {
-		return d.daysTo(d2);
+
+
+/**
+ * @brief Application::durationCacheStats
+ * @return
+ */
+
+QVariantMap Application::durationCacheStats()
+{
+	const DurationCache::Stats &stats = DurationCache::instance()->stats();
+	const quint64 total = stats.hits + stats.misses;
+
+	return QVariantMap{
+		{ QStringLiteral("hits"), stats.hits },
+		{ QStringLiteral("misses"), stats.misses },
+		{ QStringLiteral("size"), stats.size },
+		{ QStringLiteral("hitRate"), total > 0 ? (double) stats.hits / total : 0. },
+	};
+}
+
+
+
+/**
+ * @brief Application::queryStats
+ * Statistics of the SQL statements ordered by total time (times in microseconds)
+ * @return
+ */
+
+QVariantList Application::queryStats()
+{
+	QVariantList list;
+
+	for (const QueryStats::Stat &s : QueryStats::instance()->snapshot()) {
+		list.append(QVariantMap{
+						{ QStringLiteral("sql"), QString::fromUtf8(s.sql) },
+						{ QStringLiteral("count"), s.count },
+						{ QStringLiteral("rows"), s.rows },
+						{ QStringLiteral("prepare"), s.prepare / 1000. },
+						{ QStringLiteral("bind"), s.bind / 1000. },
+						{ QStringLiteral("step"), s.step / 1000. },
+						{ QStringLiteral("total"), s.total / 1000. },
+						{ QStringLiteral("mean"), s.mean / 1000. },
+						{ QStringLiteral("p99"), s.p99 / 1000. },
+						{ QStringLiteral("max"), s.max / 1000. },
+					});
 	}
+
+	return list;
 }
 
 
 
+/**
+ * @brief Application::queryStatsReset
+ */
+
+void Application::queryStatsReset()
+{
+	LOG_CDEBUG("app") << "Query statistics:\n" << qPrintable(QueryStats::instance()->dump());
+
+	QueryStats::instance()->reset();
+}
+
+
+
+/**
+ * @brief Application::traceSave
+ * Save the recorded trace events (Chrome trace format)
+ */
+
+void Application::traceSave() const
+{
+	const QString &file = QDir::temp().filePath(QStringLiteral("TimeCalculator-trace.json"));
+
+	if (Tracer::save(file))
+		snack(tr("Nyomkövetés mentve: %1").arg(file));
+	else
+		messageError(tr("Sikertelen mentés"));
+}
+
+
+
+/**
+ * @brief Application::tracing
+ * @return
+ */
+
+bool Application::tracing() const
+{
+	return Tracer::enabled();
+}
+
+void Application::setTracing(const bool &newTracing)
+{
+	if (Tracer::enabled() == newTracing)
+		return;
+
+	if (newTracing)
+		Tracer::clear();
+
+	Tracer::setEnabled(newTracing);
+	emit tracingChanged();
+}
+
 
 
 /**
@@ -285,11 +597,18 @@ void Application::onApplicationStarted()
 
 bool Application::loadResources()
 {
+	TRACE_SCOPE("loadResources");
+
 	loadFonts({
-				  QStringLiteral(":/NotoSans-Italic-VariableFont_wdth,wght.ttf"),
 				  QStringLiteral(":/NotoSans-VariableFont_wdth,wght.ttf"),
 			  });
 
+	// The italic face is not needed for the first page
+
+	loadFontsDeferred({
+						  QStringLiteral(":/NotoSans-Italic-VariableFont_wdth,wght.ttf"),
+					  });
+
 	return true;
 }
 
@@ -301,12 +620,12 @@ bool Application::loadResources()
 
 void Application::registerQmlTypes()
 {
-	LOG_CTRACE("app") << "Register QML types";
+	TRACE_SCOPE("registerQmlTypes");
 
-	qmlRegisterUncreatableType<Application>("TimeCalculator", 1, 0, "Application", "Application is uncreatable");
-	qmlRegisterUncreatableType<Utils>("TimeCalculator", 1, 0, "Utils", "Utils is uncreatable");
+	LOG_CTRACE("app") << "Register QML types";
 
-	qmlRegisterType<Database>("TimeCalculator", 1, 0, "Database");
+	// Application (App), Database, JobProxyModel and Utils are registered declaratively
+	// (QML_ELEMENT, see app.pro), so qmlcachegen knows their types at compile time
 
 	//qmlRegisterType<QSJsonListModel>("QSyncable", 1, 0, "QSJsonListModel");
 	//qmlRegisterType<QSListModel>("QSyncable", 1, 0, "QSListModel");
@@ -322,7 +641,12 @@ void Application::registerQmlTypes()
 
 void Application::setAppContextProperty()
 {
-	m_engine->rootContext()->setContextProperty("App", this);
+	TRACE_SCOPE("setAppContextProperty");
+
+	// App is the singleton of the TimeCalculator module (Application::create): untyped
+	// context properties would prevent the ahead-of-time compilation of the bindings
+
+	QJSEngine::setObjectOwnership(this, QJSEngine::CppOwnership);
 }
 
 
@@ -330,20 +654,30 @@ void Application::setAppContextProperty()
 /**
  * @brief Application::loadFromJson
  * @param data
+ * @param fileName file of the data (an already loaded database of the file is reused)
  * @return
  */
 
-bool Application::loadFromJson(const QJsonObject &data)
+bool Application::loadFromJson(const QJsonObject &data, const QString &fileName)
 {
-	std::unique_ptr<Database> db = nullptr;
+	Database *db = fileName.isEmpty() ? m_databaseManager->load(data) : m_databaseManager->acquire(fileName, data);
 
-	db.reset(Database::fromJson(data));
 	if (!db) {
 		messageError(tr("Érvénytelen adat"));
 		return false;
 	}
 
+	// Already open: only one reference is kept
+
+	if (m_databases.contains(db)) {
+		m_databaseManager->release(db);
+		setDatabase(db);
+		stackPushPage(QStringLiteral("PageDatabase.qml"));
+		return true;
+	}
+
 	db->sync();
+	m_databases.append(db);
 	setDatabase(db);
 	stackPushPage(QStringLiteral("PageDatabase.qml"));
 
@@ -352,14 +686,40 @@ bool Application::loadFromJson(const QJsonObject &data)
 
 
 
+/**
+ * @brief Application::benchmarkDatabaseOpen
+ * Load the file as current database (without pushing its page), ready when the models are synchronized
+ * @param fileName
+ * @return
+ */
+
+QFuture<bool> Application::benchmarkDatabaseOpen(const QString &fileName)
+{
+	const auto &json = Utils::fileToJsonObject(fileName);
+	Database *db = json ? m_databaseManager->load(*json) : nullptr;
+
+	if (!db)
+		return QtFuture::makeReadyFuture(false);
+
+	m_databases.append(db);
+	setDatabase(db);
+
+	return db->syncAsync().then([]() { return true; });
+}
+
+
+
 
 /**
  * @brief Application::toTextDocument
- * @param markdown
+ * @param html
+ * @param title
  */
 
-QByteArray Application::toTextDocument() const
+QByteArray Application::toTextDocument(const QString &html, const QString &title) const
 {
+	TRACE_SCOPE("Application::toTextDocument");
+
 	QTextDocument document;
 
 	document.setPageSize(QPageSize::sizePoints(QPageSize::A4));
@@ -367,7 +727,7 @@ QByteArray Application::toTextDocument() const
 	QFont font(QStringLiteral("Noto Sans"), 7);
 
 	document.setDefaultFont(font);
-	document.setHtml(m_database->toMarkdown());
+	document.setHtml(html);
 
 	QImage img = QImage::fromData(Utils::fileContent(":/piar.png").value_or(QByteArray{}));
 	document.addResource(QTextDocument::ImageResource, QUrl("imgdata://piar.png"), QVariant(img));
@@ -387,7 +747,7 @@ QByteArray Application::toTextDocument() const
 	//layout.setMode(QPageLayout::FullPageMode);
 	pdf.setPageLayout(layout);
 
-	pdf.setTitle(QStringLiteral("Gyakorlati idő kalkulátor – ").append(m_database->title()));
+	pdf.setTitle(QStringLiteral("Gyakorlati idő kalkulátor – ").append(title));
 	pdf.setCreator(QStringLiteral("TimeCalculator"));
 
 	document.print(&pdf);
@@ -476,15 +836,15 @@ QByteArray Application::importTemplate() const
 
 
 /**
- * @brief Application::importData
+ * @brief Application::importParse
+ * Rows of the import spreadsheet
  * @param data
  * @return
  */
 
-bool Application::importData(const QByteArray &data)
+std::optional<QVector<QVariantMap>> Application::importParse(const QByteArray &data)
 {
-	if (!m_database)
-		return false;
+	TRACE_SCOPE("Application::importParse");
 
 	QBuffer buf;
 	buf.setData(data);
@@ -508,7 +868,7 @@ bool Application::importData(const QByteArray &data)
 	}
 
 	if (headers.isEmpty()) {
-		return false;
+		return std::nullopt;
 	}
 
 	QVector<QVariantMap> list;
@@ -522,7 +882,7 @@ bool Application::importData(const QByteArray &data)
 			if (cell.isNull())
 				continue;
 
-			LOG_CINFO("app") << cell.toString() << cell.toDate() << cell.canConvert<QDate>();
+			LOG_CTRACE("app") << cell.toString() << cell.toDate() << cell.canConvert<QDate>();
 
 			if (it.value() == StartDate || it.value() == EndDate) {
 				QDate destDate;
@@ -532,11 +892,11 @@ bool Application::importData(const QByteArray &data)
 				else if (const QDate &d = QDate::fromString(cell.toString(), QStringLiteral("yyyy-MM-dd")); !d.isNull()) {
 					destDate = d;
 				} else {
-					static const QDate refDate(1899, 12, 31);
+					static constexpr std::int64_t minSerial = CivilCalendar::toExcelSerial(CivilCalendar::julianDay(1970, 1, 1));
 					const int cNum = cell.toInt();
 
-					if (cNum > refDate.daysTo(QDate(1970, 1, 1)))
-						destDate = refDate.addDays(cNum-1);				// Excel BUG: Excel dates after 28th February 1900 are actually one day out. Excel behaves as though the date 29th February 1900 existed, which it didn't.
+					if (cNum >= minSerial)
+						destDate = QDate::fromJulianDay(CivilCalendar::fromExcelSerial(cNum));
 				}
 
 				if (it.value() == StartDate && !destDate.isNull())
@@ -561,7 +921,7 @@ bool Application::importData(const QByteArray &data)
 		list.append(map);
 	}
 
-	return m_database->jobAddBatch(list);
+	return list;
 }
 
 
@@ -585,31 +945,20 @@ QStringList Application::jobTypeList()
 
 Database*Application::database() const
 {
-	return m_database.get();
+	return m_database;
 }
 
 
 /**
  * @brief Application::setDatabase
+ * Set the current database (one of the opened ones, owned by the manager)
  * @param newDatabase
  */
 
 void Application::setDatabase(Database *newDatabase)
-{
-	std::unique_ptr<Database> ptr(newDatabase);
-	setDatabase(ptr);
-}
-
-
-/**
- * @brief Application::setDatabase
- * @param newDatabase
- */
-
-void Application::setDatabase(std::unique_ptr<Database> &newDatabase)
 {
 	if (m_database == newDatabase)
 		return;
-	m_database = std::move(newDatabase);
+	m_database = newDatabase;
 	emit databaseChanged();
 }
@@ -29,18 +29,26 @@
 
 #include "abstractapplication.h"
 #include "database.h"
+#include "databasemanager.h"
+#include "jubileescheduler.h"
+#include "task.hpp"
 
 class Application : public AbstractApplication
 {
 	Q_OBJECT
+	QML_NAMED_ELEMENT(App)
+	QML_SINGLETON
 
 	Q_PROPERTY(Database* database READ database NOTIFY databaseChanged FINAL)
 	Q_PROPERTY(QStringList jobTypeList READ jobTypeList CONSTANT FINAL)
+	Q_PROPERTY(bool tracing READ tracing WRITE setTracing NOTIFY tracingChanged FINAL)
 
 public:
 	Application(QGuiApplication *app);
 	virtual ~Application();
 
+	static Application *create(QQmlEngine *, QJSEngine *);
+
 	enum Field {
 		Invalid = 0,
 		StartDate,
@@ -63,34 +71,58 @@ public:
 	Q_INVOKABLE virtual void importTemplateDownload() const;
 	Q_INVOKABLE virtual void import();
 
+	Q_INVOKABLE virtual void jubileeExport(const QString &path, const int &months = 12,
+										   const QString &format = QStringLiteral("pdf"));
+
 	Q_INVOKABLE static int yearsBetween(const QDate &date1, const QDate &date2);
 	Q_INVOKABLE static int daysBetween(const QDate &date1, const QDate &date2);
+	Q_INVOKABLE static QVariantMap durationCacheStats();
+	Q_INVOKABLE static QVariantList queryStats();
+	Q_INVOKABLE static void queryStatsReset();
+
+	Q_INVOKABLE virtual void traceSave() const;
 
 	Database* database() const;
 	void setDatabase(Database *newDatabase);
-	void setDatabase(std::unique_ptr<Database> &newDatabase);
 
 	static QStringList jobTypeList();
 
+	bool tracing() const;
+	void setTracing(const bool &newTracing);
+
 public slots:
 	virtual void onApplicationStarted();
 
 signals:
 	void databaseChanged();
+	void tracingChanged();
 
 protected:
 	virtual bool loadResources();
 	virtual void registerQmlTypes();
 	virtual void setAppContextProperty();
 
-	bool loadFromJson(const QJsonObject &data);
-	QByteArray toTextDocument() const;
+	virtual Coro::Task<> dbOpenTask(const QString accept);
+	virtual Coro::Task<> dbSaveTask();
+	virtual Coro::Task<> dbPrintTask();
+	virtual Coro::Task<> importTask();
+	Coro::Task<> jubileeExportTask(const QString path, const int months, const QString format);
+
+	Coro::Task<> importContent(const QByteArray content);
+	Coro::Task<QByteArray> printContent();
+
+	bool loadFromJson(const QJsonObject &data, const QString &fileName = QString());
+	virtual QFuture<bool> benchmarkDatabaseOpen(const QString &fileName) override;
+	QByteArray toTextDocument(const QString &html, const QString &title) const;
 	QByteArray importTemplate() const;
-	bool importData(const QByteArray &data);
+	static std::optional<QVector<QVariantMap>> importParse(const QByteArray &data);
 
 	static const QHash<Field, QString> m_fieldMap;
 
-	std::unique_ptr<Database> m_database;
+	std::unique_ptr<DatabaseManager> m_databaseManager;
+	QList<Database*> m_databases;
+	Database *m_database = nullptr;
+	std::unique_ptr<JubileeScheduler> m_jubileeScheduler;
 	static const QStringList m_jobTypeList;
 };
 
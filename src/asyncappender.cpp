@@ -0,0 +1,174 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * asyncappender.cpp
+ *
+ * Created on: 2024. 01. 29.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * AsyncAppender
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "asyncappender.h"
+#include <QDateTime>
+#include <algorithm>
+
+
+/**
+ * @brief AsyncAppender::AsyncAppender
+ * @param appender
+ * @param capacity
+ */
+
+AsyncAppender::AsyncAppender(AbstractAppender *appender, const int &capacity)
+	: AbstractAppender()
+	, m_appender(appender)
+	, m_capacity(capacity)
+{
+	Q_ASSERT(m_appender);
+
+	m_thread.reset(QThread::create(&AsyncAppender::run, this));
+	m_thread->setObjectName(QStringLiteral("logger"));
+	m_thread->start(QThread::LowPriority);
+}
+
+
+/**
+ * @brief AsyncAppender::~AsyncAppender
+ */
+
+AsyncAppender::~AsyncAppender()
+{
+	{
+		QMutexLocker locker(&m_mutex);
+		m_stop = true;
+		m_waitNotEmpty.wakeAll();
+	}
+
+	m_thread->wait();
+}
+
+
+
+/**
+ * @brief AsyncAppender::flush
+ * Wait until the queued messages are written
+ */
+
+void AsyncAppender::flush()
+{
+	QMutexLocker locker(&m_mutex);
+
+	while (!m_queue.isEmpty() || m_writing)
+		m_waitDone.wait(&m_mutex);
+}
+
+
+
+/**
+ * @brief AsyncAppender::append
+ * @param timeStamp
+ * @param logLevel
+ * @param file
+ * @param line
+ * @param function
+ * @param category
+ * @param message
+ */
+
+void AsyncAppender::append(const QDateTime &timeStamp, Logger::LogLevel logLevel, const char *file, int line,
+						   const char *function, const QString &category, const QString &message)
+{
+	if (logLevel == Logger::Fatal) {
+		flush();
+		m_appender->write(timeStamp, logLevel, file, line, function, category, message);
+		return;
+	}
+
+	QMutexLocker locker(&m_mutex);
+
+	if (m_queue.size() >= m_capacity) {
+		const auto it = std::find_if(m_queue.begin(), m_queue.end(), [](const Record &r) {
+			return r.logLevel <= Logger::Debug;
+		});
+
+		if (it == m_queue.end() && logLevel <= Logger::Debug) {
+			++m_dropped;
+			return;
+		}
+
+		if (it != m_queue.end()) {
+			m_queue.erase(it);
+			++m_dropped;
+		}
+	}
+
+	m_queue.append(Record{timeStamp, logLevel, file, line, function, category, message});
+	m_waitNotEmpty.wakeOne();
+}
+
+
+
+/**
+ * @brief AsyncAppender::run
+ * Writer thread
+ */
+
+void AsyncAppender::run()
+{
+	QMutexLocker locker(&m_mutex);
+
+	forever {
+		while (m_queue.isEmpty() && !m_stop)
+			m_waitNotEmpty.wait(&m_mutex);
+
+		if (m_queue.isEmpty() && m_stop)
+			break;
+
+		const QList<Record> list = std::exchange(m_queue, {});
+		const quint64 dropped = std::exchange(m_dropped, 0);
+
+		m_writing = true;
+		locker.unlock();
+
+		if (dropped > 0)
+			m_appender->write(QDateTime::currentDateTime(), Logger::Warning, __FILE__, __LINE__, Q_FUNC_INFO,
+							  QStringLiteral("logger"), QStringLiteral("%1 messages dropped").arg(dropped));
+
+		writeRecords(list);
+
+		locker.relock();
+		m_writing = false;
+		m_waitDone.wakeAll();
+	}
+
+	m_waitDone.wakeAll();
+}
+
+
+
+/**
+ * @brief AsyncAppender::writeRecords
+ * @param list
+ */
+
+void AsyncAppender::writeRecords(const QList<Record> &list) const
+{
+	for (const Record &r : list)
+		m_appender->write(r.timeStamp, r.logLevel, r.file, r.line, r.function, r.category, r.message);
+}
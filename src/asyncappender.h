@@ -0,0 +1,86 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * asyncappender.h
+ *
+ * Created on: 2024. 01. 29.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * AsyncAppender
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ASYNCAPPENDER_H
+#define ASYNCAPPENDER_H
+
+#include "AbstractAppender.h"
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include <memory>
+
+
+/**
+ * @brief The AsyncAppender class
+ *
+ * Queues the messages and passes them to the wrapped appender on a background thread,
+ * so formatting and writing don't block the caller. Fatal messages flush the queue and
+ * are written synchronously (the logger aborts after them). The queue is bounded:
+ * if it's full, the oldest trace and debug messages are dropped.
+ */
+
+class AsyncAppender : public AbstractAppender
+{
+public:
+	explicit AsyncAppender(AbstractAppender *appender, const int &capacity = 10000);
+	virtual ~AsyncAppender();
+
+	void flush();
+
+protected:
+	virtual void append(const QDateTime &timeStamp, Logger::LogLevel logLevel, const char *file, int line,
+						const char *function, const QString &category, const QString &message) override;
+
+private:
+	struct Record {
+		QDateTime timeStamp;
+		Logger::LogLevel logLevel;
+		const char *file;
+		int line;
+		const char *function;
+		QString category;
+		QString message;
+	};
+
+	void run();
+	void writeRecords(const QList<Record> &list) const;
+
+	const std::unique_ptr<AbstractAppender> m_appender;
+	const int m_capacity;
+
+	QMutex m_mutex;
+	QWaitCondition m_waitNotEmpty;
+	QWaitCondition m_waitDone;
+	QList<Record> m_queue;
+	bool m_writing = false;
+	bool m_stop = false;
+	quint64 m_dropped = 0;
+
+	std::unique_ptr<QThread> m_thread;
+};
+
+#endif // ASYNCAPPENDER_H
@@ -0,0 +1,74 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * calculationresult.cpp
+ *
+ * Created on: 2024. 01. 31.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * CalculationResult
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "calculationresult.h"
+
+
+/**
+ * @brief CalculationTotals::fromMap
+ * @param map
+ * @return
+ */
+
+CalculationTotals CalculationTotals::fromMap(const QVariantMap &map)
+{
+	CalculationTotals r;
+
+	r.jobYears = map.value(QStringLiteral("jobYears"), 0).toInt();
+	r.jobDays = map.value(QStringLiteral("jobDays"), 0).toInt();
+	r.practiceYears = map.value(QStringLiteral("practiceYears"), 0).toInt();
+	r.practiceDays = map.value(QStringLiteral("practiceDays"), 0).toInt();
+	r.prestigeYears = map.value(QStringLiteral("prestigeYears"), 0).toInt();
+	r.prestigeDays = map.value(QStringLiteral("prestigeDays"), 0).toInt();
+
+	return r;
+}
+
+
+
+/**
+ * @brief CalculationResult::fromMap
+ * @param map
+ * @return
+ */
+
+CalculationResult CalculationResult::fromMap(const QVariantMap &map)
+{
+	CalculationResult r;
+
+	r.jobYears = map.value(QStringLiteral("jobYears"), 0).toInt();
+	r.jobDays = map.value(QStringLiteral("jobDays"), 0).toInt();
+	r.practiceYears = map.value(QStringLiteral("practiceYears"), 0).toInt();
+	r.practiceDays = map.value(QStringLiteral("practiceDays"), 0).toInt();
+	r.prestigeYears = map.value(QStringLiteral("prestigeYears"), 0).toInt();
+	r.prestigeDays = map.value(QStringLiteral("prestigeDays"), 0).toInt();
+	r.nextPrestigeYears = map.value(QStringLiteral("nextPrestigeYears"), 0).toInt();
+	r.nextPrestige = map.value(QStringLiteral("nextPrestige")).toDate();
+	r.raw = CalculationTotals::fromMap(map.value(QStringLiteral("raw")).toMap());
+	r.merged = CalculationTotals::fromMap(map.value(QStringLiteral("union")).toMap());
+
+	return r;
+}
@@ -0,0 +1,112 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * calculationresult.h
+ *
+ * Created on: 2024. 01. 31.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * CalculationResult
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CALCULATIONRESULT_H
+#define CALCULATIONRESULT_H
+
+#include <QDate>
+#include <QVariantMap>
+#include <QtQml/qqmlregistration.h>
+
+
+/**
+ * @brief The CalculationTotals class
+ *
+ * Year/day totals of the categories by one method of summing
+ */
+
+class CalculationTotals
+{
+	Q_GADGET
+	QML_ANONYMOUS
+
+	Q_PROPERTY(int jobYears MEMBER jobYears FINAL)
+	Q_PROPERTY(int jobDays MEMBER jobDays FINAL)
+	Q_PROPERTY(int practiceYears MEMBER practiceYears FINAL)
+	Q_PROPERTY(int practiceDays MEMBER practiceDays FINAL)
+	Q_PROPERTY(int prestigeYears MEMBER prestigeYears FINAL)
+	Q_PROPERTY(int prestigeDays MEMBER prestigeDays FINAL)
+
+public:
+	static CalculationTotals fromMap(const QVariantMap &map);
+
+	bool operator==(const CalculationTotals &other) const = default;
+
+	int jobYears = 0;
+	int jobDays = 0;
+	int practiceYears = 0;
+	int practiceDays = 0;
+	int prestigeYears = 0;
+	int prestigeDays = 0;
+};
+
+
+
+/**
+ * @brief The CalculationResult class
+ *
+ * Summary of the calculation of the database. Exposed to QML as a typed value,
+ * so the bindings of the pages can be compiled ahead of time.
+ * The main totals follow the union mode of the database, raw (every job summed) and
+ * merged (overlapping periods counted once) are both available.
+ */
+
+class CalculationResult
+{
+	Q_GADGET
+	QML_ANONYMOUS
+
+	Q_PROPERTY(int jobYears MEMBER jobYears FINAL)
+	Q_PROPERTY(int jobDays MEMBER jobDays FINAL)
+	Q_PROPERTY(int practiceYears MEMBER practiceYears FINAL)
+	Q_PROPERTY(int practiceDays MEMBER practiceDays FINAL)
+	Q_PROPERTY(int prestigeYears MEMBER prestigeYears FINAL)
+	Q_PROPERTY(int prestigeDays MEMBER prestigeDays FINAL)
+	Q_PROPERTY(int nextPrestigeYears MEMBER nextPrestigeYears FINAL)
+	Q_PROPERTY(QDate nextPrestige MEMBER nextPrestige FINAL)
+	Q_PROPERTY(CalculationTotals raw MEMBER raw FINAL)
+	Q_PROPERTY(CalculationTotals merged MEMBER merged FINAL)
+
+public:
+	static CalculationResult fromMap(const QVariantMap &map);
+
+	bool operator==(const CalculationResult &other) const = default;
+
+	int jobYears = 0;
+	int jobDays = 0;
+	int practiceYears = 0;
+	int practiceDays = 0;
+	int prestigeYears = 0;
+	int prestigeDays = 0;
+
+	int nextPrestigeYears = 0;
+	QDate nextPrestige;
+
+	CalculationTotals raw;
+	CalculationTotals merged;
+};
+
+#endif // CALCULATIONRESULT_H
@@ -0,0 +1,258 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * civilcalendar.hpp
+ *
+ * Created on: 2024. 01. 21.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * CivilCalendar
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef CIVILCALENDAR_HPP
+#define CIVILCALENDAR_HPP
+
+#include <cstdint>
+
+
+/**
+ * Proleptic Gregorian calendar arithmetic on Julian Day Numbers (the day numbers of QDate).
+ * Everything is constexpr, so durations and conversions can be checked at compile time.
+ */
+
+namespace CivilCalendar {
+
+struct Date {
+	int year = 0;
+	int month = 0;
+	int day = 0;
+
+	constexpr bool operator==(const Date &other) const {
+		return year == other.year && month == other.month && day == other.day;
+	}
+};
+
+struct Duration {
+	int years = 0;
+	int days = 0;
+
+	constexpr bool operator==(const Duration &other) const {
+		return years == other.years && days == other.days;
+	}
+};
+
+
+/// Julian Day Number of 1970-01-01
+
+constexpr std::int64_t unixEpochJulianDay = 2440588;
+
+
+/// Excel 1900 date system: serial 1 is 1900-01-01, serial 60 is the non-existent 1900-02-29
+
+constexpr std::int64_t excelLeapBugSerial = 60;
+
+
+
+constexpr bool isLeapYear(const int &year)
+{
+	return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+}
+
+
+constexpr int daysInMonth(const int &year, const int &month)
+{
+	constexpr int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	return month == 2 && isLeapYear(year) ? 29 : days[month-1];
+}
+
+
+constexpr bool isValid(const int &year, const int &month, const int &day)
+{
+	return month >= 1 && month <= 12 && day >= 1 && day <= daysInMonth(year, month);
+}
+
+
+
+/**
+ * @brief julianDay
+ * Days from civil date (H. Hinnant's algorithm, shifted to Julian Day Numbers)
+ * @return
+ */
+
+constexpr std::int64_t julianDay(const int &year, const int &month, const int &day)
+{
+	const std::int64_t y = year - (month <= 2 ? 1 : 0);
+	const std::int64_t era = (y >= 0 ? y : y-399) / 400;
+	const std::int64_t yoe = y - era * 400;
+	const std::int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	const std::int64_t doe = yoe * 365 + yoe/4 - yoe/100 + doy;
+
+	return era * 146097 + doe - 719468 + unixEpochJulianDay;
+}
+
+
+constexpr std::int64_t julianDay(const Date &date)
+{
+	return julianDay(date.year, date.month, date.day);
+}
+
+
+
+/**
+ * @brief fromJulianDay
+ * Civil date from days
+ * @param jd
+ * @return
+ */
+
+constexpr Date fromJulianDay(const std::int64_t &jd)
+{
+	const std::int64_t z = jd - unixEpochJulianDay + 719468;
+	const std::int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+	const std::int64_t doe = z - era * 146097;
+	const std::int64_t yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;
+	const std::int64_t doy = doe - (365*yoe + yoe/4 - yoe/100);
+	const std::int64_t mp = (5*doy + 2) / 153;
+
+	Date d;
+	d.day = int(doy - (153*mp + 2)/5 + 1);
+	d.month = int(mp < 10 ? mp+3 : mp-9);
+	d.year = int(yoe + era * 400 + (d.month <= 2 ? 1 : 0));
+	return d;
+}
+
+
+
+/**
+ * @brief anniversary
+ * The same month and day in another year; a missing day (February 29) falls on the last day of the month
+ * @param date
+ * @param year
+ * @return
+ */
+
+constexpr std::int64_t anniversary(const Date &date, const int &year)
+{
+	const int dim = daysInMonth(year, date.month);
+	return julianDay(year, date.month, date.day < dim ? date.day : dim);
+}
+
+
+constexpr std::int64_t addYears(const std::int64_t &jd, const int &years)
+{
+	const Date &d = fromJulianDay(jd);
+	return anniversary(d, d.year + years);
+}
+
+
+
+/**
+ * @brief between
+ * Whole years and remaining days of the closed interval [jd1, jd2] (both days included)
+ * @param jd1
+ * @param jd2
+ * @return
+ */
+
+constexpr Duration between(const std::int64_t &jd1, const std::int64_t &jd2)
+{
+	const std::int64_t end = jd2 + 1;
+	const Date &d1 = fromJulianDay(jd1);
+	const int year = fromJulianDay(end).year;
+
+	const std::int64_t a = anniversary(d1, year);
+
+	Duration r;
+
+	if (end < a) {
+		r.years = year - 1 - d1.year;
+		r.days = int(end - anniversary(d1, year-1));
+	} else {
+		r.years = year - d1.year;
+		r.days = int(end - a);
+	}
+
+	return r;
+}
+
+
+
+/**
+ * @brief fromExcelSerial
+ * Excel (1900 date system) serial number to Julian Day. Excel treats 1900 as a leap year,
+ * so serials after 60 are one day ahead; serial 60 (1900-02-29) is mapped to 1900-02-28.
+ * @param serial
+ * @return
+ */
+
+constexpr std::int64_t fromExcelSerial(const std::int64_t &serial)
+{
+	if (serial < excelLeapBugSerial)
+		return julianDay(1899, 12, 31) + serial;
+	else if (serial == excelLeapBugSerial)
+		return julianDay(1900, 2, 28);
+	else
+		return julianDay(1899, 12, 30) + serial;
+}
+
+
+constexpr std::int64_t toExcelSerial(const std::int64_t &jd)
+{
+	const std::int64_t serial = jd - julianDay(1899, 12, 31);
+	return serial < excelLeapBugSerial ? serial : serial + 1;
+}
+
+
+
+// Compile-time tests
+
+namespace Test {
+
+static_assert(julianDay(1970, 1, 1) == unixEpochJulianDay);
+static_assert(julianDay(2000, 1, 1) == 2451545);
+static_assert(julianDay(-4713, 11, 24) == 0);
+static_assert(fromJulianDay(2451545) == Date{2000, 1, 1});
+static_assert(fromJulianDay(julianDay(2024, 2, 29)) == Date{2024, 2, 29});
+static_assert(fromJulianDay(julianDay(1600, 3, 1) - 1) == Date{1600, 2, 29});
+
+static_assert(isLeapYear(2000) && isLeapYear(2024) && !isLeapYear(1900) && !isLeapYear(2023));
+static_assert(daysInMonth(2023, 2) == 28 && daysInMonth(2024, 2) == 29 && daysInMonth(2024, 12) == 31);
+static_assert(!isValid(2023, 2, 29) && isValid(2024, 2, 29));
+
+static_assert(addYears(julianDay(2024, 2, 29), 1) == julianDay(2025, 2, 28));
+static_assert(addYears(julianDay(2020, 5, 17), 25) == julianDay(2045, 5, 17));
+
+static_assert(between(julianDay(2020, 1, 1), julianDay(2020, 12, 31)) == Duration{1, 0});
+static_assert(between(julianDay(2020, 1, 1), julianDay(2020, 1, 1)) == Duration{0, 1});
+static_assert(between(julianDay(2020, 3, 15), julianDay(2023, 3, 20)) == Duration{3, 6});
+static_assert(between(julianDay(2020, 3, 15), julianDay(2023, 3, 10)) == Duration{2, 361});
+static_assert(between(julianDay(2024, 2, 29), julianDay(2025, 2, 27)) == Duration{1, 0});
+
+static_assert(fromExcelSerial(1) == julianDay(1900, 1, 1));
+static_assert(fromExcelSerial(59) == julianDay(1900, 2, 28));
+static_assert(fromExcelSerial(61) == julianDay(1900, 3, 1));
+static_assert(fromExcelSerial(25569) == julianDay(1970, 1, 1));
+static_assert(fromExcelSerial(45292) == julianDay(2024, 1, 1));
+static_assert(toExcelSerial(julianDay(2024, 1, 1)) == 45292);
+static_assert(toExcelSerial(julianDay(1900, 1, 1)) == 1);
+
+}
+
+}
+
+#endif // CIVILCALENDAR_HPP
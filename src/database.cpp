@@ -28,38 +28,143 @@
 #include <Logger.h>
 #include <querybuilder.hpp>
 #include "database.h"
+#include "tracer.h"
+#include "databasemanager.h"
 #include "application.h"
+#include "jsonstreamwriter.h"
 #include "qtextdocument.h"
+#include <QRegularExpression>
 #include "utils_.h"
+#include <QBuffer>
+#include <QSaveFile>
+#include <QUrl>
+
+
+
+/**
+ * @brief jobJsonConverter
+ * @return
+ */
+
+static const QMap<QString, FieldConvertFunc> &jobJsonConverter()
+{
+	static const QMap<QString, FieldConvertFunc> converter = {
+		{ QStringLiteral("start"), [](const QVariant &v) -> QJsonValue {
+			  return v.toDate().toString(QStringLiteral("yyyy-MM-dd"));
+		  }
+		},
+		{ QStringLiteral("end"), [](const QVariant &v) -> QJsonValue {
+			  if (v.isNull())
+			  return QJsonValue::Null;
+			  else
+			  return v.toDate().toString(QStringLiteral("yyyy-MM-dd"));
+		  }
+		},
+		{ QStringLiteral("name"), [](const QVariant &v) -> QJsonValue {
+			  if (v.isNull())
+			  return QJsonValue::Null;
+			  else
+			  return v.toString();
+		  }
+		},
+		{ QStringLiteral("master"), [](const QVariant &v) -> QJsonValue {
+			  if (v.isNull())
+			  return QJsonValue::Null;
+			  else
+			  return v.toString();
+		  }
+		},
+		{ QStringLiteral("type"), [](const QVariant &v) -> QJsonValue {
+			  if (v.isNull())
+			  return QJsonValue::Null;
+			  else
+			  return v.toString();
+		  }
+		},
+		{ QStringLiteral("hour"), [](const QVariant &v) -> QJsonValue {
+			  if (v.isNull())
+			  return QJsonValue::Null;
+			  else
+			  return v.toInt();
+		  }
+		},
+		{ QStringLiteral("value"), [](const QVariant &v) -> QJsonValue {
+			  if (v.isNull())
+			  return QJsonValue::Null;
+			  else
+			  return v.toInt();
+		  }
+		},
+	};
+
+	return converter;
+}
+
+
+
+/// Files with more rows use the paged model
+
+const int Database::m_pagedLimit = 2000;
+
+
+
+/**
+ * @brief jobVariantConverter
+ * @return
+ */
+
+static const QMap<QString, FieldConvertVariantFunc> &jobVariantConverter()
+{
+	static const QMap<QString, FieldConvertVariantFunc> converter = {
+		{ QStringLiteral("id"), [](const QVariant &v) -> QVariant { return v.toLongLong(); } },
+		{ QStringLiteral("start"), [](const QVariant &v) -> QVariant { return v.toDate(); } },
+		{ QStringLiteral("end"), [](const QVariant &v) -> QVariant {
+			  if (v.isNull())
+			  return QVariant(QMetaType::fromType<QDate>());
+			  else
+			  return v.toDate();
+		  } },
+		{ QStringLiteral("name"), [](const QVariant &v) -> QVariant { return v.toString(); } },
+		{ QStringLiteral("hour"), [](const QVariant &v) -> QVariant { return v.toInt(); } },
+		{ QStringLiteral("value"), [](const QVariant &v) -> QVariant { return v.toInt(); } },
+		{ QStringLiteral("overlap"), [](const QVariant &v) -> QVariant { return v.toBool(); } },
+	};
+
+	return converter;
+}
+
+
+
+/**
+ * @brief clusterInterval
+ * Overlap interval of a job: open-ended jobs end on asOf, jobs starting later collapse to their start day
+ * @param start
+ * @param end
+ * @param asOf
+ * @return
+ */
+
+static OverlapClusters::Interval clusterInterval(const QDate &start, const QDate &end, const QDate &asOf)
+{
+	return OverlapClusters::Interval{start, start > asOf ? start : (end.isValid() ? end : asOf)};
+}
 
 
 
 Database::Database(QObject *parent)
 	: QObject{parent}
+	, m_databaseName(DatabaseManager::uniqueName())
 	, m_model(new QSListModel)
+	, m_worker(new DatabaseWorker)
 {
-	m_model->setRoleNames(QStringList{
-							  QStringLiteral("id"),
-							  QStringLiteral("start"),
-							  QStringLiteral("end"),
-							  QStringLiteral("name"),
-							  QStringLiteral("master"),
-							  QStringLiteral("type"),
-							  QStringLiteral("hour"),
-							  QStringLiteral("value"),
-							  QStringLiteral("overlap"),
-							  QStringLiteral("durationYears"),
-							  QStringLiteral("durationDays"),
-							  QStringLiteral("jobMode"),
-							  QStringLiteral("jobYears"),
-							  QStringLiteral("jobDays"),
-							  QStringLiteral("practiceMode"),
-							  QStringLiteral("practiceYears"),
-							  QStringLiteral("practiceDays"),
-							  QStringLiteral("prestigeMode"),
-							  QStringLiteral("prestigeYears"),
-							  QStringLiteral("prestigeDays"),
-						  });
+	m_model->setRoleNames(modelRoles());
+
+	m_patcher.reset(new ModelPatcher(m_model.get(), QStringLiteral("id"), QStringLiteral("hash")));
+	m_pagedModel.reset(new JobListModel(this));
+
+	m_proxyModel.reset(new JobProxyModel);
+	m_proxyModel->setSourceModel(m_model.get());
+	m_proxyModel->setTextSearch([this](const QString &text) { return searchAsync(text); });
 }
 
 
@@ -71,8 +176,43 @@ Database::~Database()
 {
 	LOG_CTRACE("app") << "Database closed" << qPrintable(m_databaseName);
 
-	if (QSqlDatabase::contains(m_databaseName))
-		QSqlDatabase::removeDatabase(m_databaseName);
+	// The connection belongs to the worker thread
+
+	m_worker->exec([this]() {
+		DatabaseManager::removeConnections(m_databaseName);
+	});
+
+	m_worker->stop();
+}
+
+
+
+/**
+ * @brief Database::startWorker
+ * Move the SQL work to a dedicated thread. Must be called before the connection is opened.
+ */
+
+void Database::startWorker()
+{
+	if (QSqlDatabase::contains(m_databaseName)) {
+		LOG_CWARNING("app") << "Database already opened:" << qPrintable(m_databaseName);
+		return;
+	}
+
+	m_worker->start(m_databaseName);
+}
+
+
+
+/**
+ * @brief Database::open
+ * Prepare the connection on the thread of the SQL work
+ * @return
+ */
+
+bool Database::open()
+{
+	return m_worker->exec([this]() { return prepare(m_databaseName); });
 }
 
 
@@ -92,8 +232,12 @@ bool Database::prepare(const QString &databaseName)
 
 	LOG_CDEBUG("app") << "Prepare database:" << qPrintable(databaseName);
 
+	// Shared cache: connections of other threads see the same in-memory database
+
 	auto db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), databaseName);
-	db.setDatabaseName(QStringLiteral(":memory:"));
+	db.setDatabaseName(QStringLiteral("file:%1?mode=memory&cache=shared")
+					   .arg(QString::fromLatin1(QUrl::toPercentEncoding(databaseName))));
+	db.setConnectOptions(QStringLiteral("QSQLITE_OPEN_URI"));
 
 	if (!db.open()) {
 		LOG_CERROR("app") << "Can't open database:" << qPrintable(databaseName);
@@ -124,12 +268,7 @@ bool Database::prepare(const QString &databaseName)
 		"years INTEGER, "
 		"days INTEGER, "
 		"UNIQUE(jobid, type)"
-		")",
-
-		"CREATE VIEW overlap AS "
-		"WITH r AS (SELECT id, start, CASE WHEN start > date('now') THEN start ELSE COALESCE(end, date('now')) END AS end FROM job) "
-		"SELECT r1.id AS jobid1, r2.id as jobid2 FROM r AS r1 INNER JOIN r AS r2 "
-		"ON (r1.id <> r2.id AND r1.start <= r2.end AND r2.start <= r1.end)"
+		")"
 	};
 
 
@@ -146,6 +285,51 @@ bool Database::prepare(const QString &databaseName)
 
 	db.commit();
 
+
+	// Full-text index of job name and employer (optional: depends on the SQLite build)
+
+	static const char* const ftsList[] =
+	{
+		"CREATE VIRTUAL TABLE job_fts USING fts5("
+		"name, master, "
+		"content='job', content_rowid='id', "
+		"tokenize='unicode61 remove_diacritics 2', prefix='1 2 3'"
+		")",
+
+		"CREATE TRIGGER job_fts_insert AFTER INSERT ON job BEGIN "
+		"INSERT INTO job_fts(rowid, name, master) VALUES (new.id, new.name, new.master); "
+		"END",
+
+		"CREATE TRIGGER job_fts_delete AFTER DELETE ON job BEGIN "
+		"INSERT INTO job_fts(job_fts, rowid, name, master) VALUES ('delete', old.id, old.name, old.master); "
+		"END",
+
+		"CREATE TRIGGER job_fts_update AFTER UPDATE ON job BEGIN "
+		"INSERT INTO job_fts(job_fts, rowid, name, master) VALUES ('delete', old.id, old.name, old.master); "
+		"INSERT INTO job_fts(rowid, name, master) VALUES (new.id, new.name, new.master); "
+		"END",
+	};
+
+	db.transaction();
+
+	bool ftsReady = true;
+
+	for (const auto &sql : ftsList) {
+		if (!QueryBuilder::q(db).addQuery(sql).exec()) {
+			ftsReady = false;
+			break;
+		}
+	}
+
+	if (ftsReady) {
+		db.commit();
+	} else {
+		LOG_CWARNING("app") << "Full-text search unavailable:" << qPrintable(databaseName);
+		db.rollback();
+	}
+
+	DatabaseManager::registerConnection(databaseName);
+
 	LOG_CDEBUG("app") << "Database prepared";
 
 	return true;
@@ -155,96 +339,116 @@ bool Database::prepare(const QString &databaseName)
 
 /**
  * @brief Database::toJson
+ * @param device
+ * @param format
+ * @return
+ */
+
+bool Database::toJson(QIODevice *device, const QJsonDocument::JsonFormat &format) const
+{
+	const Snapshot &s = snapshot();
+
+	return m_worker->exec([this, device, &format, &s]() { return writeJson(device, format, s); });
+}
+
+
+
+/**
+ * @brief Database::writeJson
+ * Write the database as JSON (on the worker thread)
+ * @param device
+ * @param format
+ * @param snapshot
  * @return
  */
 
-std::optional<QJsonObject> Database::toJson() const
+bool Database::writeJson(QIODevice *device, const QJsonDocument::JsonFormat &format, const Snapshot &snapshot) const
 {
+	Q_ASSERT(device);
+
 	if (!QSqlDatabase::contains(m_databaseName)) {
 		LOG_CWARNING("app") << "Database doesn't exists:" << qPrintable(m_databaseName);
-		return std::nullopt;
+		return false;
 	}
 
-	auto db = QSqlDatabase::database(m_databaseName);
+	auto db = DatabaseManager::connection(m_databaseName);
 
 	if (!db.isOpen()) {
 		LOG_CWARNING("app") << "Database doesn't opened:" << qPrintable(m_databaseName);
-		return std::nullopt;
+		return false;
 	}
 
-	const QMap<QString, FieldConvertFunc> converter = {
-		{ QStringLiteral("start"), [](const QVariant &v) -> QJsonValue {
-			  return v.toDate().toString(QStringLiteral("yyyy-MM-dd"));
-		  }
-		},
-		{ QStringLiteral("end"), [](const QVariant &v) -> QJsonValue {
-			  if (v.isNull())
-			  return QJsonValue::Null;
-			  else
-			  return v.toDate().toString(QStringLiteral("yyyy-MM-dd"));
-		  }
-		},
-		{ QStringLiteral("name"), [](const QVariant &v) -> QJsonValue {
-			  if (v.isNull())
-			  return QJsonValue::Null;
-			  else
-			  return v.toString();
-		  }
-		},
-		{ QStringLiteral("master"), [](const QVariant &v) -> QJsonValue {
-			  if (v.isNull())
-			  return QJsonValue::Null;
-			  else
-			  return v.toString();
-		  }
-		},
-		{ QStringLiteral("type"), [](const QVariant &v) -> QJsonValue {
-			  if (v.isNull())
-			  return QJsonValue::Null;
-			  else
-			  return v.toString();
-		  }
-		},
-		{ QStringLiteral("hour"), [](const QVariant &v) -> QJsonValue {
-			  if (v.isNull())
-			  return QJsonValue::Null;
-			  else
-			  return v.toInt();
-		  }
-		},
-		{ QStringLiteral("value"), [](const QVariant &v) -> QJsonValue {
-			  if (v.isNull())
-			  return QJsonValue::Null;
-			  else
-			  return v.toInt();
-		  }
-		},
-	};
+	JsonStreamWriter writer(device, format);
 
-	const auto &jobList = QueryBuilder::q(db)
-						  .addQuery("SELECT * FROM job")
-						  .execToJsonArray(converter);
+	writer.beginObject()
+			.value(QStringLiteral("_type"), QStringLiteral("TimeCalculator"))
+			.value(QStringLiteral("_version"), 0)
+			.value(QStringLiteral("title"), snapshot.title)
+			.value(QStringLiteral("prestigeCalculationTime"), snapshot.prestigeCalculationTime);
+
+	if (snapshot.asOf.isValid())
+		writer.value(QStringLiteral("asOf"), snapshot.asOf.toString(QStringLiteral("yyyy-MM-dd")));
+
+	if (snapshot.unionMode)
+		writer.value(QStringLiteral("unionMode"), true);
+
+
+	// Rows are written one by one from a forward-only cursor
+
+	const auto writeTable = [&writer, &db](const char *sql, const QMap<QString, FieldConvertFunc> &map) -> bool {
+		QueryBuilder q(db);
+		q.sqlQuery().setForwardOnly(true);
+		q.addQuery(sql);
+
+		if (!q.exec())
+			return false;
+
+		const QSqlRecord &rec = q.sqlQuery().record();
+		const QVector<FieldConvertFunc> &funcs = QueryBuilder::resolveConverters(rec, map);
+
+		writer.beginArray();
+
+		while (q.sqlQuery().next() && !writer.hasError()) {
+			writer.beginObject();
+
+			for (int i=0; i<rec.count(); ++i) {
+				const QVariant &value = q.sqlQuery().value(i);
+
+				if (const FieldConvertFunc &func = funcs.at(i)) {
+					const QJsonValue &v = std::invoke(func, value);
+					if (!v.isNull())
+						writer.value(rec.fieldName(i), v);
+				} else {
+					writer.value(rec.fieldName(i), value.toJsonValue());
+				}
+			}
+
+			writer.endObject();
+		}
+
+		writer.endArray();
+
+		return true;
+	};
 
-	const auto &calcList = QueryBuilder::q(db)
-						   .addQuery("SELECT * FROM calc")
-						   .execToJsonArray();
+	writer.key(QStringLiteral("jobs"));
 
-	if (!jobList || !calcList) {
+	if (!writeTable("SELECT * FROM job", jobJsonConverter())) {
 		LOG_CWARNING("app") << "Sql error:" << qPrintable(m_databaseName);
-		return std::nullopt;
+		return false;
 	}
 
-	return QJsonObject{
-		{ QStringLiteral("_type"), QStringLiteral("TimeCalculator") },
-		{ QStringLiteral("_version"), 0 },
-		{ QStringLiteral("title"), m_title },
-		{ QStringLiteral("prestigeCalculationTime"), m_prestigeCalculationTime },
-		{ QStringLiteral("jobs"), *jobList },
-		{ QStringLiteral("calculations"), *calcList },
-	};
-}
+	writer.key(QStringLiteral("calculations"));
+
+	if (!writeTable("SELECT * FROM calc", {})) {
+		LOG_CWARNING("app") << "Sql error:" << qPrintable(m_databaseName);
+		return false;
+	}
 
+	writer.endObject();
 
+	return !writer.hasError();
+}
 
 
 
@@ -255,8 +459,10 @@ std::optional<QJsonObject> Database::toJson() const
  * @return
  */
 
-Database *Database::fromJson(const QString &databaseName, const QJsonObject &json)
+Database *Database::fromJson(const QString &databaseName, const QJsonObject &json, const bool &threaded)
 {
+	TRACE_SCOPE("Database::fromJson");
+
 	if (json.value(QStringLiteral("_type")).toString() != QStringLiteral("TimeCalculator")) {
 		LOG_CWARNING("app") << "Invalid JSON";
 		return nullptr;
@@ -271,35 +477,56 @@ Database *Database::fromJson(const QString &databaseName, const QJsonObject &jso
 
 	std::unique_ptr<Database> ptr(new Database);
 
-	if (!ptr->prepare(databaseName.isEmpty() ? ptr->databaseName() : databaseName))
-		return nullptr;
-
 	if (!databaseName.isEmpty())
 		ptr->setDatabaseName(databaseName);
 
-	const auto &list = json.value(QStringLiteral("jobs")).toArray();
-	for (auto v : list) {
-		const QJsonObject &obj = v.toObject();
+	if (threaded)
+		ptr->startWorker();
+
+	// Rows are inserted by the SQL-only functions: no history, no model sync (the caller syncs once)
+
+	Snapshot s;
+	s.history = false;
+
+	const bool success = ptr->m_worker->exec([&ptr, &json, &s]() {
+		if (!ptr->open())
+			return false;
+
+		const auto &list = json.value(QStringLiteral("jobs")).toArray();
+		for (auto v : list) {
+			const QJsonObject &obj = v.toObject();
 
-		if (ptr->jobAdd(obj) == -1) {
-			LOG_CWARNING("app") << "SQL error" << obj;
-			return nullptr;
+			if (!ptr->jobAddSql(obj, s).success) {
+				LOG_CWARNING("app") << "SQL error" << obj;
+				return false;
+			}
 		}
-	}
 
-	const auto &cList = json.value(QStringLiteral("calculations")).toArray();
-	for (auto v : cList) {
-		const QJsonObject &obj = v.toObject();
+		const auto &cList = json.value(QStringLiteral("calculations")).toArray();
+		for (auto v : cList) {
+			const QJsonObject &obj = v.toObject();
 
-		if (!ptr->calculationAddFromJson(obj)) {
-			LOG_CWARNING("app") << "SQL error" << obj;
-			return nullptr;
+			if (!ptr->calculationAddFromJson(obj)) {
+				LOG_CWARNING("app") << "SQL error" << obj;
+				return false;
+			}
 		}
 
-	}
+		return true;
+	});
+
+	if (!success)
+		return nullptr;
 
 	ptr->setTitle(json.value(QStringLiteral("title")).toString());
 	ptr->setPrestigeCalculationTime(json.value(QStringLiteral("prestigeCalculationTime")).toInt());
+
+	// Not via setAsOf(): the caller syncs the new database once
+
+	ptr->m_asOf = QDate::fromString(json.value(QStringLiteral("asOf")).toString(), QStringLiteral("yyyy-MM-dd"));
+	ptr->m_proxyModel->setAsOf(ptr->m_asOf);
+
+	ptr->setUnionMode(json.value(QStringLiteral("unionMode")).toBool());
 	ptr->setModified(false);
 
 	return ptr.release();
@@ -313,13 +540,34 @@ Database *Database::fromJson(const QString &databaseName, const QJsonObject &jso
 
 int Database::jobAdd(const QJsonObject &data)
 {
-	auto db = QSqlDatabase::database(m_databaseName);
-	if (!db.isOpen()) {
-		LOG_CERROR("app") << "Database isn't opened";
-		return -1;
-	}
+	const Snapshot &s = snapshot();
+	const Mutation &m = m_worker->exec([this, &data, &s]() { return jobAddSql(data, s); });
 
-	QueryBuilder q(db);
+	mutationApply(m);
+
+	return m.id;
+}
+
+
+
+/**
+ * @brief Database::jobAddSql
+ * @param data
+ * @param snapshot
+ * @return
+ */
+
+Database::Mutation Database::jobAddSql(const QJsonObject &data, const Snapshot &snapshot)
+{
+	Mutation m;
+
+	auto db = DatabaseManager::connection(m_databaseName);
+	if (!db.isOpen()) {
+		LOG_CERROR("app") << "Database isn't opened";
+		return m;
+	}
+
+	QueryBuilder q(db);
 
 	q.addQuery("INSERT INTO job(")
 			.setFieldPlaceholder()
@@ -342,15 +590,19 @@ int Database::jobAdd(const QJsonObject &data)
 
 	const auto &id = q.execInsertAsInt();
 
-	setModified(true);
+	if (!id)
+		return m;
 
-	sync();
+	m.success = true;
+	m.id = *id;
+	m.text = tr("Új munkakör");
 
-	if (!id)
-		return -1;
-	else
-		return *id;
+	if (snapshot.history)
+		m.after = historyRows({*id});
+
+	clusterUpdate(*id, snapshot.asOfDate());
 
+	return m;
 }
 
 
@@ -362,16 +614,35 @@ int Database::jobAdd(const QJsonObject &data)
 
 bool Database::jobAddBatch(const QVector<QVariantMap> &data)
 {
-	auto db = QSqlDatabase::database(m_databaseName);
+	const Snapshot &s = snapshot();
+
+	return mutationApply(m_worker->exec([this, &data, &s]() { return jobAddBatchSql(data, s); }));
+}
+
+
+
+/**
+ * @brief Database::jobAddBatchSql
+ * @param data
+ * @param snapshot
+ * @return
+ */
+
+Database::Mutation Database::jobAddBatchSql(const QVector<QVariantMap> &data, const Snapshot &snapshot)
+{
+	Mutation m;
+
+	auto db = DatabaseManager::connection(m_databaseName);
 	if (!db.isOpen()) {
 		LOG_CERROR("app") << "Database isn't opened";
-		return false;
+		return m;
 	}
 
 	db.transaction();
 
+	QVariantList idList;
 
-	for (const QVariantMap &m : data) {
+	for (const QVariantMap &map : data) {
 		QueryBuilder q(db);
 
 		q.addQuery("INSERT INTO job(")
@@ -380,24 +651,33 @@ bool Database::jobAddBatch(const QVector<QVariantMap> &data)
 				.setValuePlaceholder()
 				.addQuery(")");
 
-		for (const QString &s : m.keys()) {
-			q.addField(s.toUtf8(), m.value(s));
+		for (const QString &s : map.keys()) {
+			q.addField(s.toUtf8(), map.value(s));
 		}
 
-		if (!q.exec()) {
-			LOG_CERROR("app") << "Import error:" << m;
+		const auto &id = q.execInsertAsInt();
+
+		if (!id) {
+			LOG_CERROR("app") << "Import error:" << map;
 			db.rollback();
-			return false;
+			return m;
 		}
+
+		idList.append(*id);
 	}
 
 	db.commit();
 
-	setModified(true);
+	m.success = true;
+	m.text = tr("Importálás");
 
-	sync();
+	if (snapshot.history)
+		m.after = historyRows(idList);
 
-	return true;
+	for (const QVariant &id : std::as_const(idList))
+		clusterUpdate(id.toInt(), snapshot.asOfDate());
+
+	return m;
 }
 
 
@@ -410,10 +690,29 @@ bool Database::jobAddBatch(const QVector<QVariantMap> &data)
 
 bool Database::jobEdit(const int &id, const QJsonObject &data)
 {
-	auto db = QSqlDatabase::database(m_databaseName);
+	const Snapshot &s = snapshot();
+
+	return mutationApply(m_worker->exec([this, &id, &data, &s]() { return jobEditSql(id, data, s); }));
+}
+
+
+
+/**
+ * @brief Database::jobEditSql
+ * @param id
+ * @param data
+ * @param snapshot
+ * @return
+ */
+
+Database::Mutation Database::jobEditSql(const int &id, const QJsonObject &data, const Snapshot &snapshot)
+{
+	Mutation m;
+
+	auto db = DatabaseManager::connection(m_databaseName);
 	if (!db.isOpen()) {
 		LOG_CERROR("app") << "Database isn't opened";
-		return -1;
+		return m;
 	}
 
 	QueryBuilder q(db);
@@ -428,21 +727,29 @@ bool Database::jobEdit(const int &id, const QJsonObject &data)
 
 	if (!q.fieldCount()) {
 		LOG_CERROR("app") << "Missing fields";
-		return false;
+		return m;
 	}
 
 	q.addQuery(" WHERE id=").addValue(id);
 
+	if (snapshot.history)
+		m.before = historyRows({id});
+
 	if (!q.exec()) {
 		LOG_CERROR("app") << "SQL error";
-		return false;
+		return Mutation{};
 	}
 
-	setModified(true);
+	m.success = true;
+	m.id = id;
+	m.text = tr("Munkakör módosítása");
 
-	sync();
+	if (snapshot.history)
+		m.after = historyRows({id});
 
-	return true;
+	clusterUpdate(id, snapshot.asOfDate());
+
+	return m;
 }
 
 
@@ -454,22 +761,71 @@ bool Database::jobEdit(const int &id, const QJsonObject &data)
 
 bool Database::jobDelete(const int &id)
 {
-	auto db = QSqlDatabase::database(m_databaseName);
+	const Snapshot &s = snapshot();
+
+	return mutationApply(m_worker->exec([this, &id, &s]() { return jobDeleteSql(id, s); }));
+}
+
+
+
+/**
+ * @brief Database::jobDeleteSql
+ * @param id
+ * @param snapshot
+ * @return
+ */
+
+Database::Mutation Database::jobDeleteSql(const int &id, const Snapshot &snapshot)
+{
+	Mutation m;
+
+	auto db = DatabaseManager::connection(m_databaseName);
 	if (!db.isOpen()) {
 		LOG_CERROR("app") << "Database isn't opened";
-		return false;
+		return m;
 	}
 
-	bool r = QueryBuilder::q(db)
-			 .addQuery("DELETE FROM job WHERE id=").addValue(id)
-			 .exec();
+	if (snapshot.history)
+		m.before = historyRows({id});
 
-	if (r) {
-		setModified(true);
-		sync();
-	}
+	if (!QueryBuilder::q(db)
+			.addQuery("DELETE FROM job WHERE id=").addValue(id)
+			.exec())
+		return Mutation{};
+
+	m.success = true;
+	m.id = id;
+	m.text = tr("Munkakör törlése");
+
+	if (snapshot.history)
+		m.after = historyRows({id});
+
+	clusterUpdate(id, snapshot.asOfDate());
+
+	return m;
+}
+
+
+
+/**
+ * @brief Database::mutationApply
+ * Record the history step of a mutation and update the models (on the thread of the Database)
+ * @param mutation
+ * @return
+ */
+
+bool Database::mutationApply(const Mutation &mutation)
+{
+	if (!mutation.success)
+		return false;
 
-	return r;
+	historyPush(mutation.text, mutation.before, mutation.after);
+
+	setModified(true);
+
+	sync();
+
+	return true;
 }
 
 
@@ -482,7 +838,10 @@ bool Database::jobDelete(const int &id)
 
 QVariantMap Database::calculationGet(const int &id) const
 {
-	auto db = QSqlDatabase::database(m_databaseName);
+	if (!m_worker->isCurrentThread())
+		return m_worker->exec([&]() { return calculationGet(id); });
+
+	auto db = DatabaseManager::connection(m_databaseName);
 	if (!db.isOpen()) {
 		LOG_CERROR("app") << "Database isn't opened";
 		return {};
@@ -501,529 +860,2276 @@ QVariantMap Database::calculationGet(const int &id) const
 	map.insert(QStringLiteral("prestigeDays"), 0);
 
 
-	QueryBuilder q(db);
-	q.addQuery("SELECT type, mode, years, days FROM calc WHERE jobid=").addValue(id);
+	QueryBuilder q(db);
+	q.addQuery("SELECT type, mode, years, days FROM calc WHERE jobid=").addValue(id);
+
+	q.execForEach([&map](const QueryBuilder::Row &row) {
+		const int &type = row.toInt(0);
+
+		QString prefix;
+
+		if (type == 1) {
+			prefix = QStringLiteral("job");
+		} else if (type == 2) {
+			prefix = QStringLiteral("practice");
+		} else if (type == 3) {
+			prefix = QStringLiteral("prestige");
+		}
+
+		map[prefix+QStringLiteral("Mode")] = row.toInt(1);
+		map[prefix+QStringLiteral("Years")] = row.toInt(2);
+		map[prefix+QStringLiteral("Days")] = row.toInt(3);
+	});
+
+	return map;
+}
+
+
+
+/**
+ * @brief Database::calculationEdit
+ * @param id
+ * @param data
+ * @return
+ */
+
+bool Database::calculationEdit(const int &id, const QJsonObject &data)
+{
+	const Snapshot &s = snapshot();
+
+	return mutationApply(m_worker->exec([this, &id, &data, &s]() { return calculationEditSql(id, data, s); }));
+}
+
+
+
+/**
+ * @brief Database::calculationEditSql
+ * @param id
+ * @param data
+ * @param snapshot
+ * @return
+ */
+
+Database::Mutation Database::calculationEditSql(const int &id, const QJsonObject &data, const Snapshot &snapshot)
+{
+	Mutation m;
+
+	auto db = DatabaseManager::connection(m_databaseName);
+	if (!db.isOpen()) {
+		LOG_CERROR("app") << "Database isn't opened";
+		return m;
+	}
+
+	const QStringList &keys = data.keys();
+
+	if (snapshot.history)
+		m.before = historyRows({id});
+
+	db.transaction();
+
+	for (int type=1; type<=3; ++type) {
+		if (type == 1 && !keys.contains(QStringLiteral("jobMode")))
+			continue;
+
+		if (type == 2 && !keys.contains(QStringLiteral("practiceMode")))
+			continue;
+
+		if (type == 3 && !keys.contains(QStringLiteral("prestigeMode")))
+			continue;
+
+		QueryBuilder q(db);
+		q.addQuery("INSERT OR REPLACE INTO calc(")
+				.setFieldPlaceholder()
+				.addQuery(") VALUES(")
+				.setValuePlaceholder()
+				.addQuery(")");
+
+		q.addField("jobid", id);
+		q.addField("type", type);
+
+		QString prefix;
+		static const QHash<QByteArray, QString> hash = {
+			{ QByteArrayLiteral("mode"), QStringLiteral("Mode") },
+			{ QByteArrayLiteral("years"), QStringLiteral("Years") },
+			{ QByteArrayLiteral("days"), QStringLiteral("Days") },
+		};
+
+		if (type == 1) {
+			prefix = QStringLiteral("job");
+		} else if (type == 2) {
+			prefix = QStringLiteral("practice");
+		} else if (type == 3) {
+			prefix = QStringLiteral("prestige");
+		}
+
+		for (auto it = hash.constBegin(); it != hash.constEnd(); ++it) {
+			const QString &key = prefix+it.value();
+			if (data.contains(key)) {
+				q.addField(it.key(), data.value(key).toVariant());
+			}
+		}
+
+		if (!q.exec()) {
+			db.rollback();
+			return Mutation{};
+		}
+
+		m.success = true;
+	}
+
+	db.commit();
+
+	if (!m.success)
+		return Mutation{};
+
+	m.id = id;
+	m.text = tr("Számítás módosítása");
+
+	if (snapshot.history)
+		m.after = historyRows({id});
+
+	return m;
+}
+
+
+
+/**
+ * @brief Database::overlapGet
+ * @param id
+ * @return
+ */
+
+QVariantList Database::overlapGet(const int &id) const
+{
+	const QDate &asOf = asOfDate();
+
+	return m_worker->exec([this, &id, &asOf]() { return overlapList(id, asOf); });
+}
+
+
+
+/**
+ * @brief Database::overlapList
+ * Jobs overlapping the job (on the worker thread)
+ * @param id
+ * @param asOf
+ * @return
+ */
+
+QVariantList Database::overlapList(const int &id, const QDate &asOf) const
+{
+	clustersEnsure(asOf);
+
+	if (!m_clusters.contains(id))
+		return {};
+
+	// Overlapping jobs are members of the same cluster: filter them with the same interval rule
+
+	const QVariantList &members = clusterList(m_clusters.clusterId(id), asOf);
+
+	OverlapClusters::Interval interval;
+
+	for (const QVariant &v : members) {
+		const QVariantMap &m = v.toMap();
+
+		if (m.value(QStringLiteral("id")).toLongLong() == id) {
+			interval = clusterInterval(m.value(QStringLiteral("start")).toDate(), m.value(QStringLiteral("end")).toDate(), asOf);
+			break;
+		}
+	}
+
+	QVariantList list;
+
+	for (const QVariant &v : members) {
+		const QVariantMap &m = v.toMap();
+
+		if (m.value(QStringLiteral("id")).toLongLong() == id)
+			continue;
+
+		const auto &i = clusterInterval(m.value(QStringLiteral("start")).toDate(), m.value(QStringLiteral("end")).toDate(), asOf);
+
+		if (interval.start <= i.end && i.start <= interval.end)
+			list.append(v);
+	}
+
+	return list;
+}
+
+
+
+/**
+ * @brief Database::clusterGet
+ * @param clusterId
+ * @return
+ */
+
+QVariantList Database::clusterGet(const int &clusterId) const
+{
+	const QDate &asOf = asOfDate();
+
+	return m_worker->exec([this, &clusterId, &asOf]() { return clusterList(clusterId, asOf); });
+}
+
+
+
+/**
+ * @brief Database::clusterList
+ * Jobs of an overlap cluster (on the worker thread)
+ * @param clusterId
+ * @param asOf
+ * @return
+ */
+
+QVariantList Database::clusterList(const int &clusterId, const QDate &asOf) const
+{
+	auto db = DatabaseManager::connection(m_databaseName);
+	if (!db.isOpen()) {
+		LOG_CERROR("app") << "Database isn't opened";
+		return {};
+	}
+
+	clustersEnsure(asOf);
+
+	QVariantList ids;
+
+	for (const qint64 &id : m_clusters.members(clusterId))
+		ids.append(id);
+
+	if (ids.isEmpty())
+		return {};
+
+	const auto &jobList = QueryBuilder::q(db)
+						  .addQuery("SELECT id, start, end, name, master, type, hour, value FROM job WHERE id IN (")
+						  .addList(ids)
+						  .addQuery(") ORDER BY start")
+						  .execToVariantList(jobVariantConverter());
+
+	if (!jobList) {
+		LOG_CWARNING("app") << "Sql error:" << qPrintable(m_databaseName);
+		return {};
+	}
+
+	return *jobList;
+}
+
+
+
+/**
+ * @brief Database::clustersEnsure
+ * @param asOf
+ */
+
+void Database::clustersEnsure(const QDate &asOf) const
+{
+	if (m_clustersDate == asOf)
+		return;
+
+	auto db = DatabaseManager::connection(m_databaseName);
+	if (!db.isOpen()) {
+		LOG_CERROR("app") << "Database isn't opened";
+		return;
+	}
+
+	QueryBuilder q(db);
+	q.addQuery("SELECT id, start, end FROM job");
+
+	QHash<qint64, OverlapClusters::Interval> intervals;
+
+	if (!q.execForEach([&intervals, &asOf](const QueryBuilder::Row &row) {
+		intervals.insert(row.toLongLong(0), clusterInterval(row.toDate(1), row.toDate(2), asOf));
+	})) {
+		LOG_CWARNING("app") << "Sql error:" << qPrintable(m_databaseName);
+		return;
+	}
+
+	m_clusters.rebuild(intervals);
+	m_clustersDate = asOf;
+}
+
+
+
+/**
+ * @brief Database::clusterUpdate
+ * @param id
+ * @param asOf
+ */
+
+void Database::clusterUpdate(const int &id, const QDate &asOf)
+{
+	// Not built yet (or built for another day): rebuilt on the next use
+
+	if (m_clustersDate != asOf) {
+		m_clustersDate = QDate();
+		return;
+	}
+
+	auto db = DatabaseManager::connection(m_databaseName);
+	if (!db.isOpen()) {
+		LOG_CERROR("app") << "Database isn't opened";
+		return;
+	}
+
+	QueryBuilder q(db);
+	q.addQuery("SELECT start, end FROM job WHERE id=").addValue(id);
+
+	if (!q.exec()) {
+		m_clustersDate = QDate();
+		return;
+	}
+
+	if (q.sqlQuery().next())
+		m_clusters.insert(id, clusterInterval(q.value("start").toDate(), q.value("end").toDate(), m_clustersDate));
+	else
+		m_clusters.remove(id);
+}
+
+
+
+/**
+ * @brief Database::clusterFill
+ * @param map
+ */
+
+void Database::clusterFill(QVariantMap *map) const
+{
+	Q_ASSERT(map);
+
+	const qint64 &id = map->value(QStringLiteral("id")).toLongLong();
+	const bool overlap = m_clusters.size(id) > 1;
+
+	map->insert(QStringLiteral("overlap"), overlap);
+	map->insert(QStringLiteral("cluster"), overlap ? m_clusters.clusterId(id) : 0);
+}
+
+
+
+/**
+ * @brief Database::search
+ * @param query
+ * @return
+ */
+
+QVariantList Database::search(const QString &query) const
+{
+	if (!m_worker->isCurrentThread())
+		return m_worker->exec([&]() { return search(query); });
+
+	auto db = DatabaseManager::connection(m_databaseName);
+	if (!db.isOpen()) {
+		LOG_CERROR("app") << "Database isn't opened";
+		return {};
+	}
+
+	static const QRegularExpression split(QStringLiteral("[^\\w]+"), QRegularExpression::UseUnicodePropertiesOption);
+
+	const QStringList &words = query.split(split, Qt::SkipEmptyParts);
+
+	if (words.isEmpty())
+		return {};
+
+	if (!m_ftsAvailable.has_value())
+		m_ftsAvailable = QueryBuilder::q(db)
+						 .addQuery("SELECT name FROM sqlite_master WHERE type='table' AND name='job_fts'")
+						 .execCheckExists();
+
+	QueryBuilder q(db);
+
+	if (*m_ftsAvailable) {
+		// Every word is a prefix query, diacritics are folded by the tokenizer
+
+		QStringList terms;
+
+		for (const QString &w : words)
+			terms.append(QStringLiteral("\"%1\"*").arg(w));
+
+		q.addQuery("SELECT rowid AS id FROM job_fts WHERE job_fts MATCH ").addValue(terms.join(' '))
+				.addQuery(" ORDER BY rank");
+	} else {
+		q.addQuery("SELECT id FROM job WHERE 1");
+
+		for (const QString &w : words) {
+			const QString &pattern = QStringLiteral("%%1%").arg(w);
+			q.addQuery(" AND (name LIKE ").addValue(pattern)
+					.addQuery(" OR master LIKE ").addValue(pattern)
+					.addQuery(")");
+		}
+
+		q.addQuery(" ORDER BY id");
+	}
+
+	QVariantList list;
+
+	if (q.exec()) {
+		while (q.sqlQuery().next())
+			list.append(q.sqlQuery().value(0).toLongLong());
+	}
+
+	return list;
+}
+
+
+
+/**
+ * @brief Database::databaseName
+ * @return
+ */
+
+QString Database::databaseName() const
+{
+	return m_databaseName;
+}
+
+void Database::setDatabaseName(const QString &newDatabaseName)
+{
+	if (m_databaseName == newDatabaseName)
+		return;
+	m_databaseName = newDatabaseName;
+	emit databaseNameChanged();
+}
+
+
+/**
+ * @brief Database::title
+ * @return
+ */
+
+QString Database::title() const
+{
+	return m_title;
+}
+
+void Database::setTitle(const QString &newTitle)
+{
+	if (m_title == newTitle)
+		return;
+	m_title = newTitle;
+	emit titleChanged();
+	setModified(true);
+}
+
+
+QSListModel*Database::model() const
+{
+	return m_model.get();
+}
+
+
+/**
+ * @brief Database::pagedModel
+ * @return
+ */
+
+JobListModel *Database::pagedModel() const
+{
+	return m_pagedModel.get();
+}
+
+
+/**
+ * @brief Database::proxyModel
+ * @return
+ */
+
+JobProxyModel *Database::proxyModel() const
+{
+	return m_proxyModel.get();
+}
+
+
+/**
+ * @brief Database::paged
+ * @return
+ */
+
+bool Database::paged() const
+{
+	return m_paged;
+}
+
+void Database::setPaged(bool newPaged)
+{
+	if (m_paged == newPaged)
+		return;
+	m_paged = newPaged;
+	emit pagedChanged();
+}
+
+
+
+/**
+ * @brief Database::modelRoles
+ * @return
+ */
+
+const QStringList &Database::modelRoles()
+{
+	static const QStringList roles = {
+		QStringLiteral("id"),
+		QStringLiteral("start"),
+		QStringLiteral("end"),
+		QStringLiteral("name"),
+		QStringLiteral("master"),
+		QStringLiteral("type"),
+		QStringLiteral("hour"),
+		QStringLiteral("value"),
+		QStringLiteral("overlap"),
+		QStringLiteral("cluster"),
+		QStringLiteral("durationYears"),
+		QStringLiteral("durationDays"),
+		QStringLiteral("jobMode"),
+		QStringLiteral("jobYears"),
+		QStringLiteral("jobDays"),
+		QStringLiteral("practiceMode"),
+		QStringLiteral("practiceYears"),
+		QStringLiteral("practiceDays"),
+		QStringLiteral("prestigeMode"),
+		QStringLiteral("prestigeYears"),
+		QStringLiteral("prestigeDays"),
+	};
+
+	return roles;
+}
+
+
+/**
+ * @brief Database::jobWindowAsync
+ * Rows of the job table (with the calculated values) from offset
+ * @param offset
+ * @param limit
+ * @return
+ */
+
+QFuture<QVariantList> Database::jobWindowAsync(const int &offset, const int &limit) const
+{
+	return m_worker->run([this, offset, limit, s = snapshot()]() -> QVariantList {
+		auto db = DatabaseManager::connection(m_databaseName);
+		if (!db.isOpen()) {
+			LOG_CERROR("app") << "Database isn't opened";
+			return {};
+		}
+
+		const auto &jobList = QueryBuilder::q(db)
+							  .addQuery("SELECT id, start, end, name, master, type, hour, value "
+										"FROM job "
+										"ORDER BY id LIMIT ").addValue(limit)
+							  .addQuery(" OFFSET ").addValue(offset)
+							  .execToVariantList(jobVariantConverter());
+
+		if (!jobList) {
+			LOG_CWARNING("app") << "Sql error:" << qPrintable(m_databaseName);
+			return {};
+		}
+
+		clustersEnsure(s.asOfDate());
+
+		QVariantList list;
+		list.reserve(jobList->size());
+
+		for (const QVariant &v : *jobList) {
+			QVariantMap map = v.toMap();
+			calculateRow(db, &map, s.asOf, s.cutoff);
+			clusterFill(&map);
+			list.append(map);
+		}
+
+		return list;
+	});
+}
+
+
+
+/**
+ * @brief Database::jobIdsAsync
+ * Ids of the job table in the order of the rows
+ * @return
+ */
+
+QFuture<QVector<qint64>> Database::jobIdsAsync() const
+{
+	return m_worker->run([this]() -> QVector<qint64> {
+		auto db = DatabaseManager::connection(m_databaseName);
+		if (!db.isOpen()) {
+			LOG_CERROR("app") << "Database isn't opened";
+			return {};
+		}
+
+		QueryBuilder q(db);
+		q.addQuery("SELECT id FROM job ORDER BY id");
+
+		QVector<qint64> list;
+
+		if (q.exec()) {
+			while (q.sqlQuery().next())
+				list.append(q.sqlQuery().value(0).toLongLong());
+		}
+
+		return list;
+	});
+}
+
+
+
+/**
+ * @brief Database::sqlMainView
+ * @param dest
+ * @param snapshot
+ * @return
+ */
+
+QVariantList Database::sqlMainView(QVariantMap *dest, const Snapshot &snapshot) const
+{
+	TRACE_SCOPE("Database::sqlMainView");
+
+	if (!QSqlDatabase::contains(m_databaseName)) {
+		LOG_CWARNING("app") << "Database doesn't exists:" << qPrintable(m_databaseName);
+		return {};
+	}
+
+	auto db = DatabaseManager::connection(m_databaseName);
+
+	if (!db.isOpen()) {
+		LOG_CWARNING("app") << "Database doesn't opened:" << qPrintable(m_databaseName);
+		return {};
+	}
+
+	QueryBuilder q(db);
+
+	q.addQuery("SELECT id, start, end, name, master, type, hour, value FROM job ORDER BY id");
+
+	const auto &jobList = q.execToVariantList(jobVariantConverter());
+
+	if (!jobList) {
+		LOG_CWARNING("app") << "Sql error:" << qPrintable(m_databaseName);
+		return {};
+	}
+
+	const QDate &asOf = snapshot.asOfDate();
+	const QDate &cutoff = snapshot.cutoff;
+
+	QVariantList list;
+	list.reserve(jobList->size());
+
+	clustersEnsure(asOf);
+
+	// Calculated (mode 1) intervals of the categories for the union
+
+	QVector<std::pair<QDate, QDate>> counted[3];
+
+	Calc calc;
+	Calc merged;
+
+	static const QString prefixList[3] = {
+		QStringLiteral("job"),
+		QStringLiteral("practice"),
+		QStringLiteral("prestige")
+	};
+
+	for (const auto &v : *jobList) {
+		QVariantMap map = v.toMap();
+
+		calculateRow(db, &map, snapshot.asOf, cutoff);
+
+		const QDate &start = map.value(QStringLiteral("start")).toDate();
+		const QDate &end = map.value(QStringLiteral("end")).toDate();
+
+		clusterFill(&map);
+
+		QDate countedEnd = end.isValid() ? end : asOf;
+
+		if (snapshot.asOf.isValid() && countedEnd > snapshot.asOf)
+			countedEnd = snapshot.asOf;
+
+		for (int i=0; i<3; ++i) {
+			const QString &prefix = prefixList[i];
+			const int &mode = map.value(prefix+QStringLiteral("Mode")).toInt();
+			const int &years = map.value(prefix+QStringLiteral("Years")).toInt();
+			const int &days = map.value(prefix+QStringLiteral("Days")).toInt();
+
+			calc.add(i+1, years, days);
+
+			if (mode == 2) {
+				merged.add(i+1, years, days);
+			} else if (mode == 1) {
+				const QDate &e = i > 0 && cutoff.isValid() && countedEnd > cutoff ? cutoff : countedEnd;
+
+				if (start <= e)
+					counted[i].append({start, e});
+			}
+		}
+
+		map.insert(QStringLiteral("hash"), Utils::rowHash(map));
+
+		list.append(map);
+	}
+
+
+	calculationUnion(counted, &merged);
+
+	calculationFinish(&calc, asOf, cutoff);
+	calculationFinish(&merged, asOf, cutoff);
+
+	if (dest) {
+		*dest = snapshot.unionMode ? merged.toMap() : calc.toMap();
+		dest->insert(QStringLiteral("raw"), calc.toMap());
+		dest->insert(QStringLiteral("union"), merged.toMap());
+	}
+
+	return list;
+}
+
+
+
+/**
+ * @brief Database::sqlView
+ * Rows and totals for a sync. Above the paged limit only the totals and the number of rows
+ * are calculated, the paged model calculates its windows.
+ * @param snapshot
+ * @return
+ */
+
+Database::View Database::sqlView(const Snapshot &snapshot) const
+{
+	View view;
+
+	auto db = DatabaseManager::connection(m_databaseName);
+
+	if (!db.isOpen()) {
+		LOG_CWARNING("app") << "Database doesn't opened:" << qPrintable(m_databaseName);
+		return view;
+	}
+
+	view.count = QueryBuilder::q(db)
+				 .addQuery("SELECT COUNT(*) AS cnt FROM job")
+				 .execToValue("cnt", 0)
+				 .value_or(0).toInt();
+
+	if (view.count > m_pagedLimit)
+		sqlTotals(&view.calculation, snapshot);
+	else
+		view.list = sqlMainView(&view.calculation, snapshot);
+
+	return view;
+}
+
+
+
+/**
+ * @brief Database::sqlRows
+ * Calculated rows of the jobs (as in sqlMainView())
+ * @param ids
+ * @param snapshot
+ * @return
+ */
+
+QVariantList Database::sqlRows(const QVector<qint64> &ids, const Snapshot &snapshot) const
+{
+	if (ids.isEmpty())
+		return {};
+
+	auto db = DatabaseManager::connection(m_databaseName);
+
+	if (!db.isOpen()) {
+		LOG_CWARNING("app") << "Database doesn't opened:" << qPrintable(m_databaseName);
+		return {};
+	}
+
+	QVariantList idList;
+	idList.reserve(ids.size());
+
+	for (const qint64 &id : ids)
+		idList.append(id);
+
+	const auto &jobList = QueryBuilder::q(db)
+						  .addQuery("SELECT id, start, end, name, master, type, hour, value FROM job WHERE id IN (")
+						  .addList(idList)
+						  .addQuery(") ORDER BY id")
+						  .execToVariantList(jobVariantConverter());
+
+	if (!jobList) {
+		LOG_CWARNING("app") << "Sql error:" << qPrintable(m_databaseName);
+		return {};
+	}
+
+	clustersEnsure(snapshot.asOfDate());
+
+	QVariantList list;
+	list.reserve(jobList->size());
+
+	for (const auto &v : *jobList) {
+		QVariantMap map = v.toMap();
+		calculateRow(db, &map, snapshot.asOf, snapshot.cutoff);
+		clusterFill(&map);
+		map.insert(QStringLiteral("hash"), Utils::rowHash(map));
+		list.append(map);
+	}
+
+	return list;
+}
+
+
+
+/**
+ * @brief Database::sqlTotals
+ * Totals of sqlMainView() in one scan of the calculations, without the rows
+ * @param dest
+ * @param snapshot
+ * @return
+ */
+
+bool Database::sqlTotals(QVariantMap *dest, const Snapshot &snapshot) const
+{
+	TRACE_SCOPE("Database::sqlTotals");
+
+	Q_ASSERT(dest);
+
+	auto db = DatabaseManager::connection(m_databaseName);
+
+	if (!db.isOpen()) {
+		LOG_CWARNING("app") << "Database doesn't opened:" << qPrintable(m_databaseName);
+		return false;
+	}
+
+	QueryBuilder q(db);
+	q.sqlQuery().setForwardOnly(true);
+	q.addQuery("SELECT start, end, calc.type AS type, mode, years, days "
+			   "FROM calc INNER JOIN job ON (job.id=calc.jobid) "
+			   "WHERE mode<>0 AND calc.type BETWEEN 1 AND 3");
+
+	if (!q.exec()) {
+		LOG_CWARNING("app") << "Sql error:" << qPrintable(m_databaseName);
+		return false;
+	}
+
+	const QDate &asOf = snapshot.asOfDate();
+	const QDate &cutoff = snapshot.cutoff;
+
+	QVector<std::pair<QDate, QDate>> counted[3];
+
+	Calc calc;
+	Calc merged;
+
+	// Same rules as calculateRow()
+
+	while (q.sqlQuery().next()) {
+		const QDate &start = q.value(0).toDate();
+		const int &type = q.value(2).toInt();
+		const bool isCut = type != 1;
+
+		if (snapshot.asOf.isValid() && start > snapshot.asOf)
+			continue;
+
+		if (isCut && cutoff.isValid() && start > cutoff)
+			continue;
+
+		if (q.value(3).toInt() == 2) {
+			const int &years = q.value(4).toInt();
+			const int &days = q.value(5).toInt();
+			calc.add(type, years, days);
+			merged.add(type, years, days);
+			continue;
+		}
+
+		QDate end = q.value(1).toDate();
+
+		if (!end.isValid())
+			end = asOf;
+		else if (snapshot.asOf.isValid() && end > snapshot.asOf)
+			end = snapshot.asOf;
+
+		if (isCut && cutoff.isValid() && end > cutoff)
+			end = cutoff;
+
+		calc.add(type, Application::yearsBetween(start, end), Application::daysBetween(start, end));
+
+		if (start <= end)
+			counted[type-1].append({start, end});
+	}
+
+	calculationUnion(counted, &merged);
+
+	calculationFinish(&calc, asOf, cutoff);
+	calculationFinish(&merged, asOf, cutoff);
+
+	*dest = snapshot.unionMode ? merged.toMap() : calc.toMap();
+	dest->insert(QStringLiteral("raw"), calc.toMap());
+	dest->insert(QStringLiteral("union"), merged.toMap());
+
+	return true;
+}
+
+
+
+/**
+ * @brief Database::calculationUnion
+ * Union of the calculated intervals of the categories: overlapping periods are counted once
+ * @param counted
+ * @param calc
+ */
+
+void Database::calculationUnion(QVector<std::pair<QDate, QDate>> *counted, Calc *calc)
+{
+	Q_ASSERT(counted);
+	Q_ASSERT(calc);
+
+	for (int i=0; i<3; ++i) {
+		auto &list = counted[i];
+
+		std::sort(list.begin(), list.end());
+
+		QDate from;
+		QDate to;
+
+		for (const auto &p : list) {
+			if (from.isValid() && p.first <= to) {
+				if (p.second > to)
+					to = p.second;
+				continue;
+			}
+
+			if (from.isValid())
+				calc->add(i+1, Application::yearsBetween(from, to), Application::daysBetween(from, to));
+
+			from = p.first;
+			to = p.second;
+		}
+
+		if (from.isValid())
+			calc->add(i+1, Application::yearsBetween(from, to), Application::daysBetween(from, to));
+	}
+}
+
+
+
+/**
+ * @brief Database::calculationFinish
+ * @param calc
+ * @param asOf
+ * @param cutoff
+ */
+
+void Database::calculationFinish(Calc *calc, const QDate &asOf, const QDate &cutoff)
+{
+	Q_ASSERT(calc);
+
+	// Practice and prestige are already clipped at the cutoff date
+
+	calc->prestigeBase = cutoff.isValid() && cutoff < asOf ? cutoff : asOf;
+
+	calc->normalize();
+	calc->getNextPrestige();
+}
+
+
+
+/**
+ * @brief Database::Calc::toMap
+ * @return
+ */
+
+QVariantMap Database::Calc::toMap() const
+{
+	QVariantMap m;
+	m[QStringLiteral("jobYears")] = jobYears;
+	m[QStringLiteral("jobDays")] = jobDays;
+	m[QStringLiteral("practiceYears")] = practiceYears;
+	m[QStringLiteral("practiceDays")] = practiceDays;
+	m[QStringLiteral("prestigeYears")] = prestigeYears;
+	m[QStringLiteral("prestigeDays")] = prestigeDays;
+	m[QStringLiteral("nextPrestigeYears")] = nextPrestigeYears;
+	m[QStringLiteral("nextPrestige")] = nextPrestige;
+	return m;
+}
+
+
+
+/**
+ * @brief Database::Calc::add
+ * @param type
+ * @param years
+ * @param days
+ */
+
+void Database::Calc::add(const int &type, const int &years, const int &days)
+{
+	if (type == 1) {
+		jobYears += years;
+		jobDays += days;
+	} else if (type == 2) {
+		practiceYears += years;
+		practiceDays += days;
+	} else if (type == 3) {
+		prestigeYears += years;
+		prestigeDays += days;
+	}
+}
+
+
+
+/**
+ * @brief Database::Calc::normalize
+ */
+
+void Database::Calc::normalize()
+{
+	int jy = qFloor((float)jobDays/365.);
+	jobYears += jy;
+	jobDays -= 365*jy;
+
+	int pay = qFloor((float)practiceDays/365.);
+	practiceYears += pay;
+	practiceDays -= 365*pay;
+
+	int pey = qFloor((float)prestigeDays/365.);
+	prestigeYears += pey;
+	prestigeDays -= 365*pey;
+}
+
+
+
+/**
+ * @brief Database::Calc::getNextPrestige
+ */
+
+void Database::Calc::getNextPrestige()
+{
+	QDate d = prestigeBase
+			  .addDays(-prestigeDays)
+			  .addYears(-prestigeYears);
+
+	if (prestigeYears < 25) {
+		nextPrestige = d.addYears(25);
+		nextPrestigeYears = 25;
+	} else if (prestigeYears < 30) {
+		nextPrestige = d.addYears(30);
+		nextPrestigeYears = 30;
+	} else if (prestigeYears < 40) {
+		nextPrestige = d.addYears(40);
+		nextPrestigeYears = 40;
+	} else {
+		nextPrestige = QDate();
+		nextPrestigeYears = 0;
+	}
+}
+
+
+
+/**
+ * @brief Database::calculateRow
+ * @param db
+ * @param map
+ * @param asOf (invalid: open-ended jobs end today, nothing is clipped)
+ * @param cutoff (practice and prestige are counted up to this date)
+ */
+
+void Database::calculateRow(const QSqlDatabase &db, QVariantMap *map, const QDate &asOf, const QDate &cutoff)
+{
+	Q_ASSERT(map);
+
+	const int &id = map->value(QStringLiteral("id"), 0).toInt();
+	const QDate &date1 = map->value(QStringLiteral("start")).toDate();
+	QDate date2 = map->value(QStringLiteral("end")).toDate();
+
+	if (date2.isNull()) {
+		map->remove(QStringLiteral("end"));
+		date2 = asOf.isValid() ? asOf : QDate::currentDate();
+	} else if (asOf.isValid() && date2 > asOf) {
+		date2 = asOf;
+	}
+
+	// Jobs starting after asOf don't count at all
+
+	const bool notStarted = asOf.isValid() && date1 > asOf;
+
+	const int &defYears = notStarted ? 0 : Application::yearsBetween(date1, date2);
+	const int &defDays = notStarted ? 0 : Application::daysBetween(date1, date2);
+
+	map->insert(QStringLiteral("durationYears"), defYears);
+	map->insert(QStringLiteral("durationDays"), defDays);
+
+	const bool cutAway = cutoff.isValid() && date1 > cutoff;
+	const QDate &cutEnd = cutoff.isValid() && date2 > cutoff ? cutoff : date2;
+
+	const int &cutYears = notStarted || cutAway ? 0 : Application::yearsBetween(date1, cutEnd);
+	const int &cutDays = notStarted || cutAway ? 0 : Application::daysBetween(date1, cutEnd);
+
+
+	map->insert(QStringLiteral("jobMode"), -1);
+	map->insert(QStringLiteral("jobYears"), 0);
+	map->insert(QStringLiteral("jobDays"), 0);
+	map->insert(QStringLiteral("practiceMode"), -1);
+	map->insert(QStringLiteral("practiceYears"), 0);
+	map->insert(QStringLiteral("practiceDays"), 0);
+	map->insert(QStringLiteral("prestigeMode"), -1);
+	map->insert(QStringLiteral("prestigeYears"), 0);
+	map->insert(QStringLiteral("prestigeDays"), 0);
+
+
+	QueryBuilder q(db);
+	q.addQuery("SELECT type, mode, years, days FROM calc WHERE jobid=").addValue(id);
+
+
+	q.execForEach([&](const QueryBuilder::Row &row) {
+		const int &type = row.toInt(0);
+		const int &mode = row.toInt(1);
+		int years = row.toInt(2);
+		int days = row.toInt(3);
+
+		QString prefix;
+
+		if (type == 1) {
+			prefix = QStringLiteral("job");
+		} else if (type == 2) {
+			prefix = QStringLiteral("practice");
+		} else if (type == 3) {
+			prefix = QStringLiteral("prestige");
+		} else {
+			return;
+		}
+
+		const bool isCut = type != 1;
+
+		if (mode == 0 || notStarted || (isCut && cutAway)) {
+			years = 0;
+			days = 0;
+		} else if (mode == 1) {
+			years = isCut ? cutYears : defYears;
+			days = isCut ? cutDays : defDays;
+		}
+
+		map->insert(prefix+QStringLiteral("Mode"), mode);
+		map->insert(prefix+QStringLiteral("Years"), years);
+		map->insert(prefix+QStringLiteral("Days"), days);
+	});
+}
+
+
+
+/**
+ * @brief Database::totalsAt
+ * @param dates
+ * @return
+ */
+
+QVariantList Database::totalsAt(const QVariantList &dates) const
+{
+	QVector<QDate> list;
+	list.reserve(dates.size());
+
+	for (const QVariant &v : dates) {
+		if (const QDate &d = v.toDate(); d.isValid())
+			list.append(d);
+	}
+
+	std::sort(list.begin(), list.end());
+
+	QVariantList ret;
+
+	for (const QVariantMap &m : totalsSeries(list))
+		ret.append(m);
+
+	return ret;
+}
+
+
+
+/**
+ * @brief Database::totalsSeries
+ * @param dates
+ * @return
+ */
+
+QVector<QVariantMap> Database::totalsSeries(const QVector<QDate> &dates) const
+{
+	const QDate &cutoff = prestigeCutoff();
+
+	return m_worker->exec([this, &dates, &cutoff]() -> QVector<QVariantMap> {
+		auto db = DatabaseManager::connection(m_databaseName);
+		if (!db.isOpen()) {
+			LOG_CERROR("app") << "Database isn't opened";
+			return {};
+		}
+
+		return totalsSeries(db, dates, cutoff);
+	});
+}
+
+
+
+/**
+ * @brief Database::totalsSeries
+ * Evaluate the totals for every date of an ascending date list in one sweep:
+ * closed intervals and manual values are accumulated as prefix sums over the
+ * start/end events, only the jobs still running are measured at each date.
+ * @param db
+ * @param dates
+ * @param cutoff
+ * @return
+ */
+
+QVector<QVariantMap> Database::totalsSeries(const QSqlDatabase &db, const QVector<QDate> &dates, const QDate &cutoff)
+{
+	if (!std::is_sorted(dates.constBegin(), dates.constEnd())) {
+		LOG_CWARNING("app") << "Dates must be in ascending order";
+		return {};
+	}
+
+	QueryBuilder q(db);
+	q.sqlQuery().setForwardOnly(true);
+	q.addQuery("SELECT start, end, calc.type AS type, mode, years, days "
+			   "FROM calc INNER JOIN job ON (job.id=calc.jobid) "
+			   "WHERE mode<>0 AND calc.type BETWEEN 1 AND 3");
+
+	if (!q.exec()) {
+		LOG_CWARNING("app") << "Sql error:" << qPrintable(db.connectionName());
+		return {};
+	}
+
+	struct Interval {
+		int type = 0;
+		bool manual = false;
+		QDate start;
+		QDate end;
+		int years = 0;
+		int days = 0;
+	};
+
+	struct Event {
+		QDate date;
+		bool isEnd = false;
+		int index = 0;
+	};
+
+	QVector<Interval> intervals;
+	QVector<Event> events;
+
+	while (q.sqlQuery().next()) {
+		Interval i;
+		i.type = q.value(2).toInt();
+		i.start = q.value(0).toDate();
+
+		if (!i.start.isValid())
+			continue;
+
+		// Practice and prestige stop at the cutoff date
+
+		const bool isCut = cutoff.isValid() && i.type != 1;
+
+		if (isCut && i.start > cutoff)
+			continue;
+
+		if (q.value(3).toInt() == 2) {
+			// Manual values count from the first day of the job
+			i.manual = true;
+			i.years = q.value(4).toInt();
+			i.days = q.value(5).toInt();
+		} else {
+			i.end = q.value(1).toDate();
+
+			if (isCut && (!i.end.isValid() || i.end > cutoff))
+				i.end = cutoff;
+
+			if (i.end.isValid() && i.end < i.start)
+				i.end = i.start;
+
+			if (i.end.isValid()) {
+				i.years = Application::yearsBetween(i.start, i.end);
+				i.days = Application::daysBetween(i.start, i.end);
+				events.append(Event{i.end, true, (int) intervals.size()});
+			}
+		}
+
+		events.append(Event{i.start, false, (int) intervals.size()});
+		intervals.append(i);
+	}
+
+	std::sort(events.begin(), events.end(), [](const Event &e1, const Event &e2) {
+		if (e1.date != e2.date)
+			return e1.date < e2.date;
+		return !e1.isEnd && e2.isEnd;
+	});
+
+
+	QVector<QVariantMap> ret;
+	ret.reserve(dates.size());
+
+	Calc closed;
+	QSet<int> running;
+	auto it = events.constBegin();
+
+	for (const QDate &date : dates) {
+		for (; it != events.constEnd() && it->date <= date; ++it) {
+			const Interval &i = intervals.at(it->index);
+
+			if (it->isEnd) {
+				running.remove(it->index);
+				closed.add(i.type, i.years, i.days);
+			} else if (i.manual) {
+				closed.add(i.type, i.years, i.days);
+			} else {
+				running.insert(it->index);
+			}
+		}
+
+		Calc calc = closed;
+
+		for (const int &index : running) {
+			const Interval &i = intervals.at(index);
+			calc.add(i.type, Application::yearsBetween(i.start, date), Application::daysBetween(i.start, date));
+		}
+
+		calculationFinish(&calc, date, cutoff);
+
+		QVariantMap m = calc.toMap();
+		m.insert(QStringLiteral("date"), date);
+		ret.append(m);
+	}
+
+	return ret;
+}
+
+
+
+int Database::prestigeCalculationTime() const
+{
+	return m_prestigeCalculationTime;
+}
+
+void Database::setPrestigeCalculationTime(int newPrestigeCalculationTime)
+{
+	if (m_prestigeCalculationTime == newPrestigeCalculationTime)
+		return;
+	m_prestigeCalculationTime = newPrestigeCalculationTime;
+	emit prestigeCalculationTimeChanged();
+}
+
+
+
+/**
+ * @brief Database::prestigeCutoff
+ * @return
+ */
+
+QDate Database::prestigeCutoff() const
+{
+	return cutoffDate(m_prestigeCalculationTime);
+}
+
+
+
+/**
+ * @brief Database::cutoffDate
+ * @param prestigeCalculationTime (yyyymmdd, <= 0 if not set)
+ * @return
+ */
+
+QDate Database::cutoffDate(const int &prestigeCalculationTime)
+{
+	if (prestigeCalculationTime <= 0)
+		return {};
+
+	return QDate(prestigeCalculationTime / 10000,
+				 (prestigeCalculationTime / 100) % 100,
+				 prestigeCalculationTime % 100);
+}
+
+
+void Database::setPrestigeCutoff(const QDate &newPrestigeCutoff)
+{
+	if (newPrestigeCutoff.isValid())
+		setPrestigeCalculationTime(newPrestigeCutoff.year() * 10000 + newPrestigeCutoff.month() * 100 + newPrestigeCutoff.day());
+	else
+		setPrestigeCalculationTime(-1);
+}
+
+
+/**
+ * @brief Database::asOf
+ * @return
+ */
+
+QDate Database::asOf() const
+{
+	return m_asOf;
+}
+
+void Database::setAsOf(const QDate &newAsOf)
+{
+	if (m_asOf == newAsOf)
+		return;
+	m_asOf = newAsOf;
+	m_proxyModel->setAsOf(m_asOf);
+	emit asOfChanged();
+
+	sync();
+}
+
+
+/**
+ * @brief Database::unionMode
+ * @return
+ */
+
+bool Database::unionMode() const
+{
+	return m_unionMode;
+}
+
+void Database::setUnionMode(bool newUnionMode)
+{
+	if (m_unionMode == newUnionMode)
+		return;
+	m_unionMode = newUnionMode;
+	emit unionModeChanged();
+}
+
+bool Database::modified() const
+{
+	return m_modified;
+}
+
+void Database::setModified(bool newModified)
+{
+	if (m_modified == newModified)
+		return;
+	m_modified = newModified;
+	emit modifiedChanged();
+}
+
+
+
+/**
+ * @brief Database::snapshot
+ * @return
+ */
+
+Database::Snapshot Database::snapshot() const
+{
+	Snapshot s;
+	s.title = m_title;
+	s.prestigeCalculationTime = m_prestigeCalculationTime;
+	s.asOf = m_asOf;
+	s.cutoff = prestigeCutoff();
+	s.unionMode = m_unionMode;
+	return s;
+}
+
+
+
+/**
+ * @brief Database::sync
+ */
+
+void Database::sync()
+{
+	TRACE_SCOPE("Database::sync");
+
+	if (m_worker->isStarted()) {
+		syncAsync();
+		return;
+	}
+
+	syncApply(sqlView(snapshot()));
+}
+
+
+
+/**
+ * @brief Database::syncAsync
+ * Query the main view on the worker thread and update the models on the thread of the Database.
+ * Results of an outdated request are dropped.
+ * @return
+ */
+
+QFuture<void> Database::syncAsync()
+{
+	const quint64 sequence = ++m_syncSequence;
+
+	++m_syncPending;
+
+	return m_worker->run([this, s = snapshot()]() {
+		return sqlView(s);
+	}).then(this, [this, sequence](const View &view) {
+		--m_syncPending;
+
+		if (sequence == m_syncSequence)
+			syncApply(view);
+	});
+}
+
+
+
+/**
+ * @brief Database::syncApply
+ * @param view
+ */
+
+void Database::syncApply(const View &view)
+{
+	TRACE_SCOPE("Database::syncApply");
+
+	// A partial view is merged into the rows of the model: if those are not final yet
+	// or the paged mode changes, everything is synchronized
+
+	if (view.partial && (m_syncPending > 0 || m_patcher->isBusy() || m_paged != (view.count > m_pagedLimit))) {
+		sync();
+		return;
+	}
+
+	const bool wasPaged = m_paged;
+
+	setPaged(view.count > m_pagedLimit);
+
+	if (m_paged) {
+		if (!wasPaged)
+			m_patcher->patch({});
+
+		m_pagedModel->reload(view.count, view.partial ? std::optional(view.ids) : std::nullopt);
+	} else if (view.partial) {
+		m_patcher->patch(syncMerge(view));
+	} else {
+		m_pagedModel->clear();
+		m_patcher->patch(view.list);
+	}
+
+	// The full-text matches are queried once for the whole sync
+
+	m_proxyModel->refreshTextMatch();
+
+	setCalculation(CalculationResult::fromMap(view.calculation));
+}
+
+
+
+/**
+ * @brief Database::syncMerge
+ * Replace the rows of the ids of a partial view in the rows of the model (both ordered by id)
+ * @param view
+ * @return
+ */
+
+QVariantList Database::syncMerge(const View &view) const
+{
+	const QSet<qint64> ids(view.ids.constBegin(), view.ids.constEnd());
+	const QVariantList &storage = m_model->storage();
+
+	const auto idOf = [](const QVariant &v) { return v.toMap().value(QStringLiteral("id")).toLongLong(); };
+
+	QVariantList list;
+	list.reserve(storage.size() + view.list.size());
+
+	auto it = view.list.constBegin();
+
+	for (const QVariant &v : storage) {
+		const qint64 &id = idOf(v);
+
+		for (; it != view.list.constEnd() && idOf(*it) < id; ++it)
+			list.append(*it);
+
+		if (!ids.contains(id))
+			list.append(v);
+	}
+
+	for (; it != view.list.constEnd(); ++it)
+		list.append(*it);
+
+	return list;
+}
+
+
+
+/**
+ * @brief Database::jobAddAsync
+ * @param data
+ * @return
+ */
+
+QFuture<int> Database::jobAddAsync(const QJsonObject &data)
+{
+	return m_worker->run([this, data, s = snapshot()]() { return jobAddSql(data, s); })
+			.then(this, [this](const Mutation &m) { return mutationApply(m) ? m.id : -1; });
+}
+
+
+/**
+ * @brief Database::jobAddBatchAsync
+ * @param data
+ * @return
+ */
+
+QFuture<bool> Database::jobAddBatchAsync(const QVector<QVariantMap> &data)
+{
+	return m_worker->run([this, data, s = snapshot()]() { return jobAddBatchSql(data, s); })
+			.then(this, [this](const Mutation &m) { return mutationApply(m); });
+}
+
+
+/**
+ * @brief Database::jobEditAsync
+ * @param id
+ * @param data
+ * @return
+ */
+
+QFuture<bool> Database::jobEditAsync(const int &id, const QJsonObject &data)
+{
+	return m_worker->run([this, id, data, s = snapshot()]() { return jobEditSql(id, data, s); })
+			.then(this, [this](const Mutation &m) { return mutationApply(m); });
+}
+
+
+/**
+ * @brief Database::jobDeleteAsync
+ * @param id
+ * @return
+ */
+
+QFuture<bool> Database::jobDeleteAsync(const int &id)
+{
+	return m_worker->run([this, id, s = snapshot()]() { return jobDeleteSql(id, s); })
+			.then(this, [this](const Mutation &m) { return mutationApply(m); });
+}
+
+
+/**
+ * @brief Database::calculationEditAsync
+ * @param id
+ * @param data
+ * @return
+ */
+
+QFuture<bool> Database::calculationEditAsync(const int &id, const QJsonObject &data)
+{
+	return m_worker->run([this, id, data, s = snapshot()]() { return calculationEditSql(id, data, s); })
+			.then(this, [this](const Mutation &m) { return mutationApply(m); });
+}
+
+
+/**
+ * @brief Database::undoAsync
+ * @return
+ */
+
+QFuture<bool> Database::undoAsync()
+{
+	return historyStepAsync(true);
+}
+
+
+/**
+ * @brief Database::redoAsync
+ * @return
+ */
+
+QFuture<bool> Database::redoAsync()
+{
+	return historyStepAsync(false);
+}
+
+
+/**
+ * @brief Database::toMarkdownAsync
+ * @return
+ */
+
+QFuture<QString> Database::toMarkdownAsync() const
+{
+	return m_worker->run([this, s = snapshot()]() { return writeMarkdown(s); });
+}
+
+
+/**
+ * @brief Database::saveAsync
+ * @param fileName
+ * @return
+ */
+
+QFuture<bool> Database::saveAsync(const QString &fileName) const
+{
+	return m_worker->run([this, fileName, s = snapshot()]() {
+		QSaveFile f(fileName);
+
+		if (!f.open(QIODevice::WriteOnly)) {
+			LOG_CWARNING("app") << "Can't write file:" << f.fileName();
+			return false;
+		}
+
+		return writeJson(&f, QJsonDocument::Indented, s) && f.commit();
+	});
+}
+
+
+
+/**
+ * @brief Database::toJsonAsync
+ * @param format
+ * @return
+ */
+
+QFuture<std::optional<QByteArray>> Database::toJsonAsync(const QJsonDocument::JsonFormat &format) const
+{
+	return m_worker->run([this, format, s = snapshot()]() -> std::optional<QByteArray> {
+		QByteArray content;
+		QBuffer buffer(&content);
+		buffer.open(QIODevice::WriteOnly);
+
+		if (!writeJson(&buffer, format, s))
+			return std::nullopt;
+
+		buffer.close();
+		return content;
+	});
+}
+
+
+
+/**
+ * @brief Database::calculationGetAsync
+ * @param id
+ * @return
+ */
+
+QFuture<QVariantMap> Database::calculationGetAsync(const int &id) const
+{
+	return m_worker->run([this, id]() { return calculationGet(id); });
+}
+
+
+/**
+ * @brief Database::overlapGetAsync
+ * @param id
+ * @return
+ */
+
+QFuture<QVariantList> Database::overlapGetAsync(const int &id) const
+{
+	return m_worker->run([this, id, asOf = asOfDate()]() { return overlapList(id, asOf); });
+}
+
+
+/**
+ * @brief Database::clusterGetAsync
+ * @param clusterId
+ * @return
+ */
+
+QFuture<QVariantList> Database::clusterGetAsync(const int &clusterId) const
+{
+	return m_worker->run([this, clusterId, asOf = asOfDate()]() { return clusterList(clusterId, asOf); });
+}
+
+
+/**
+ * @brief Database::searchAsync
+ * @param query
+ * @return
+ */
+
+QFuture<QVariantList> Database::searchAsync(const QString &query) const
+{
+	return m_worker->run([this, query]() { return search(query); });
+}
+
+
+
+/**
+ * @brief Database::request
+ * Asynchronous call for QML: the result is delivered by requestFinished() with the returned id
+ * @param method
+ * @param args
+ * @return request id (-1 on invalid method)
+ */
+
+int Database::request(const QString &method, const QVariantList &args)
+{
+	const int id = ++m_requestId;
+
+	const auto finished = [this, id](const QVariant &result) { emit requestFinished(id, result); };
+
+	const auto &arg = [&args](const int &index) { return QJsonObject::fromVariantMap(args.value(index).toMap()); };
+
+	if (method == QStringLiteral("sync"))
+		syncAsync().then(this, [finished]() { finished(QVariant()); });
+	else if (method == QStringLiteral("jobAdd"))
+		jobAddAsync(arg(0)).then(this, [finished](int r) { finished(r); });
+	else if (method == QStringLiteral("jobEdit"))
+		jobEditAsync(args.value(0).toInt(), arg(1)).then(this, [finished](bool r) { finished(r); });
+	else if (method == QStringLiteral("jobDelete"))
+		jobDeleteAsync(args.value(0).toInt()).then(this, [finished](bool r) { finished(r); });
+	else if (method == QStringLiteral("calculationEdit"))
+		calculationEditAsync(args.value(0).toInt(), arg(1)).then(this, [finished](bool r) { finished(r); });
+	else if (method == QStringLiteral("undo"))
+		undoAsync().then(this, [finished](bool r) { finished(r); });
+	else if (method == QStringLiteral("redo"))
+		redoAsync().then(this, [finished](bool r) { finished(r); });
+	else if (method == QStringLiteral("save"))
+		saveAsync(args.value(0).toString()).then(this, [finished](bool r) { finished(r); });
+	else if (method == QStringLiteral("calculationGet"))
+		calculationGetAsync(args.value(0).toInt()).then(this, [finished](const QVariantMap &r) { finished(r); });
+	else if (method == QStringLiteral("overlapGet"))
+		overlapGetAsync(args.value(0).toInt()).then(this, [finished](const QVariantList &r) { finished(r); });
+	else if (method == QStringLiteral("clusterGet"))
+		clusterGetAsync(args.value(0).toInt()).then(this, [finished](const QVariantList &r) { finished(r); });
+	else if (method == QStringLiteral("search"))
+		searchAsync(args.value(0).toString()).then(this, [finished](const QVariantList &r) { finished(r); });
+	else {
+		LOG_CWARNING("app") << "Invalid request:" << method;
+		return -1;
+	}
+
+	return id;
+}
+
+
+
+/**
+ * @brief Database::undo
+ * @return
+ */
+
+bool Database::undo()
+{
+	return historyStep(true);
+}
+
+
+
+/**
+ * @brief Database::redo
+ * @return
+ */
+
+bool Database::redo()
+{
+	return historyStep(false);
+}
+
 
-	if (q.exec()) {
-		while (q.sqlQuery().next()) {
-			const int &type = q.value("type").toInt(0);
-			const int &mode = q.value("mode").toInt(0);
-			const int &years = q.value("years").toInt(0);
-			const int &days = q.value("days").toInt(0);
-
-			QString prefix;
-
-			if (type == 1) {
-				prefix = QStringLiteral("job");
-			} else if (type == 2) {
-				prefix = QStringLiteral("practice");
-			} else if (type == 3) {
-				prefix = QStringLiteral("prestige");
-			}
 
-			map[prefix+QStringLiteral("Mode")] = mode;
-			map[prefix+QStringLiteral("Years")] = years;
-			map[prefix+QStringLiteral("Days")] = days;
-		}
-	}
+/**
+ * @brief Database::historyClear
+ */
 
-	return map;
+void Database::historyClear()
+{
+	m_history.clear();
+	emit historyChanged();
 }
 
 
 
 /**
- * @brief Database::calculationEdit
- * @param id
- * @param data
+ * @brief Database::historyStep
+ * @param isUndo
  * @return
  */
 
-bool Database::calculationEdit(const int &id, const QJsonObject &data)
+bool Database::historyStep(const bool &isUndo)
 {
-	auto db = QSqlDatabase::database(m_databaseName);
-	if (!db.isOpen()) {
-		LOG_CERROR("app") << "Database isn't opened";
-		return -1;
-	}
-
-	const QStringList &keys = data.keys();
+	const auto &step = isUndo ? m_history.undo() : m_history.redo();
 
-	bool ret = false;
+	if (!step)
+		return false;
 
-	for (int type=1; type<=3; ++type) {
-		if (type == 1 && !keys.contains(QStringLiteral("jobMode")))
-			continue;
+	LOG_CDEBUG("app") << (isUndo ? "Undo:" : "Redo:") << qPrintable(step->text);
 
-		if (type == 2 && !keys.contains(QStringLiteral("practiceMode")))
-			continue;
+	emit historyChanged();
 
-		if (type == 3 && !keys.contains(QStringLiteral("prestigeMode")))
-			continue;
+	const Snapshot &s = snapshot();
 
-		QueryBuilder q(db);
-		q.addQuery("INSERT OR REPLACE INTO calc(")
-				.setFieldPlaceholder()
-				.addQuery(") VALUES(")
-				.setValuePlaceholder()
-				.addQuery(")");
+	return historyFinish(m_worker->exec([this, &step, &isUndo, &s]() { return historyApply(*step, isUndo, s); }));
+}
 
-		q.addField("jobid", id);
-		q.addField("type", type);
 
-		QString prefix;
-		static const QHash<QByteArray, QString> hash = {
-			{ QByteArrayLiteral("mode"), QStringLiteral("Mode") },
-			{ QByteArrayLiteral("years"), QStringLiteral("Years") },
-			{ QByteArrayLiteral("days"), QStringLiteral("Days") },
-		};
 
-		if (type == 1) {
-			prefix = QStringLiteral("job");
-		} else if (type == 2) {
-			prefix = QStringLiteral("practice");
-		} else if (type == 3) {
-			prefix = QStringLiteral("prestige");
-		}
+/**
+ * @brief Database::historyStepAsync
+ * @param isUndo
+ * @return
+ */
 
-		for (auto it = hash.constBegin(); it != hash.constEnd(); ++it) {
-			const QString &key = prefix+it.value();
-			if (data.contains(key)) {
-				q.addField(it.key(), data.value(key).toVariant());
-			}
-		}
+QFuture<bool> Database::historyStepAsync(const bool &isUndo)
+{
+	const auto &step = isUndo ? m_history.undo() : m_history.redo();
 
-		if (!q.exec())
-			return false;
-		else
-			ret = true;
-	}
+	if (!step)
+		return QtFuture::makeReadyFuture(false);
 
-	setModified(true);
+	LOG_CDEBUG("app") << (isUndo ? "Undo:" : "Redo:") << qPrintable(step->text);
 
-	sync();
+	emit historyChanged();
 
-	return ret;
+	return m_worker->run([this, step = *step, isUndo, s = snapshot()]() { return historyApply(step, isUndo, s); })
+			.then(this, [this](const std::optional<View> &view) { return historyFinish(view); });
 }
 
 
 
 /**
- * @brief Database::overlapGet
- * @param id
+ * @brief Database::historyRows
+ * @param jobIds
  * @return
  */
 
-QVariantList Database::overlapGet(const int &id) const
+Database::HistoryRows Database::historyRows(const QVariantList &jobIds) const
 {
-	auto db = QSqlDatabase::database(m_databaseName);
+	HistoryRows rows;
+
+	if (jobIds.isEmpty())
+		return rows;
+
+	auto db = DatabaseManager::connection(m_databaseName);
 	if (!db.isOpen()) {
 		LOG_CERROR("app") << "Database isn't opened";
-		return {};
+		return rows;
 	}
 
-	const QMap<QString, FieldConvertVariantFunc> converter = {
-		{ QStringLiteral("id"), [](const QVariant &v) -> QVariant { return v.toLongLong(); } },
-		{ QStringLiteral("start"), [](const QVariant &v) -> QVariant { return v.toDate(); } },
-		{ QStringLiteral("end"), [](const QVariant &v) -> QVariant {
-			  if (v.isNull())
-			  return QVariant(QMetaType::fromType<QDate>());
-			  else
-			  return v.toDate();
-		  } },
-		{ QStringLiteral("name"), [](const QVariant &v) -> QVariant { return v.toString(); } },
-		{ QStringLiteral("hour"), [](const QVariant &v) -> QVariant { return v.toInt(); } },
-		{ QStringLiteral("value"), [](const QVariant &v) -> QVariant { return v.toInt(); } },
+	const auto readRows = [](QueryBuilder &q, QHash<int, QVariantMap> *dest) {
+		if (!q.exec())
+			return;
+
+		while (q.sqlQuery().next()) {
+			const QSqlRecord &rec = q.sqlQuery().record();
+			QVariantMap map;
+
+			for (int i=0; i<rec.count(); ++i)
+				map.insert(rec.fieldName(i), rec.value(i));
+
+			dest->insert(map.value(QStringLiteral("id")).toInt(), map);
+		}
 	};
 
-	const auto &jobList = QueryBuilder::q(db)
-						  .addQuery("SELECT id, start, end, name, master, type, hour, value "
-									"FROM overlap LEFT JOIN job ON (job.id=overlap.jobid2) "
-									"WHERE jobid1=").addValue(id)
-						  .addQuery(" ORDER BY start")
-						  .execToVariantList(converter);
+	// Keep the number of bound parameters below the SQLite limit
 
-	if (!jobList) {
-		LOG_CWARNING("app") << "Sql error:" << qPrintable(m_databaseName);
-		return {};
+	static const int chunkSize = 500;
+
+	for (int i=0; i<jobIds.size(); i += chunkSize) {
+		const QVariantList &chunk = jobIds.mid(i, chunkSize);
+
+		QueryBuilder q(db);
+		q.addQuery("SELECT * FROM job WHERE id IN (").addList(chunk).addQuery(")");
+		readRows(q, &rows.job);
+
+		QueryBuilder q2(db);
+		q2.addQuery("SELECT * FROM calc WHERE jobid IN (").addList(chunk).addQuery(")");
+		readRows(q2, &rows.calc);
 	}
 
-	return *jobList;
+	return rows;
 }
 
 
 
 /**
- * @brief Database::databaseName
- * @return
+ * @brief Database::historyPush
+ * @param text
+ * @param before
+ * @param after
  */
 
-QString Database::databaseName() const
+void Database::historyPush(const QString &text, const HistoryRows &before, const HistoryRows &after)
 {
-	return m_databaseName;
-}
+	UndoStack::Step step;
+	step.text = text;
 
-void Database::setDatabaseName(const QString &newDatabaseName)
-{
-	if (m_databaseName == newDatabaseName)
-		return;
-	m_databaseName = newDatabaseName;
-	emit databaseNameChanged();
-}
+	const auto diff = [this, &step](const UndoStack::Table &table,
+							  const QHash<int, QVariantMap> &from, const QHash<int, QVariantMap> &to) {
+		QSet<int> ids;
 
+		for (auto it = from.constBegin(); it != from.constEnd(); ++it)
+			ids.insert(it.key());
 
-/**
- * @brief Database::title
- * @return
- */
+		for (auto it = to.constBegin(); it != to.constEnd(); ++it)
+			ids.insert(it.key());
 
-QString Database::title() const
-{
-	return m_title;
-}
+		for (const int &id : ids) {
+			const auto fit = from.constFind(id);
+			const auto tit = to.constFind(id);
 
-void Database::setTitle(const QString &newTitle)
-{
-	if (m_title == newTitle)
-		return;
-	m_title = newTitle;
-	emit titleChanged();
-	setModified(true);
-}
+			if (fit != from.constEnd() && tit != to.constEnd() && *fit == *tit)
+				continue;
 
+			UndoStack::Change change;
+			change.table = table;
+			change.id = id;
 
-QSListModel*Database::model() const
-{
-	return m_model.get();
+			if (fit != from.constEnd())
+				change.before = m_history.share(table, id, *fit);
+
+			if (tit != to.constEnd())
+				change.after = m_history.share(table, id, *tit);
+
+			step.changes.append(change);
+		}
+	};
+
+	diff(UndoStack::Job, before.job, after.job);
+	diff(UndoStack::Calc, before.calc, after.calc);
+
+	if (step.changes.isEmpty())
+		return;
+
+	m_history.push(std::move(step));
+	emit historyChanged();
 }
 
 
+
 /**
- * @brief Database::sqlMainView
- * @return
+ * @brief Database::historyApply
+ * Write the rows of the step (on the worker thread)
+ * @param step
+ * @param isUndo
+ * @param snapshot
+ * @return partial view of the changed jobs and the jobs sharing an overlap cluster with them
  */
 
-QVariantList Database::sqlMainView(QVariantMap *dest) const
+std::optional<Database::View> Database::historyApply(const UndoStack::Step &step, const bool &isUndo, const Snapshot &snapshot)
 {
-	if (!QSqlDatabase::contains(m_databaseName)) {
-		LOG_CWARNING("app") << "Database doesn't exists:" << qPrintable(m_databaseName);
-		return {};
-	}
-
-	auto db = QSqlDatabase::database(m_databaseName);
-
+	auto db = DatabaseManager::connection(m_databaseName);
 	if (!db.isOpen()) {
-		LOG_CWARNING("app") << "Database doesn't opened:" << qPrintable(m_databaseName);
-		return {};
+		LOG_CERROR("app") << "Database isn't opened";
+		return std::nullopt;
 	}
 
-	const QMap<QString, FieldConvertVariantFunc> converter = {
-		{ QStringLiteral("id"), [](const QVariant &v) -> QVariant { return v.toLongLong(); } },
-		{ QStringLiteral("start"), [](const QVariant &v) -> QVariant { return v.toDate(); } },
-		{ QStringLiteral("end"), [](const QVariant &v) -> QVariant {
-			  if (v.isNull())
-			  return QVariant(QMetaType::fromType<QDate>());
-			  else
-			  return v.toDate();
-		  } },
-		{ QStringLiteral("name"), [](const QVariant &v) -> QVariant { return v.toString(); } },
-		{ QStringLiteral("hour"), [](const QVariant &v) -> QVariant { return v.toInt(); } },
-		{ QStringLiteral("value"), [](const QVariant &v) -> QVariant { return v.toInt(); } },
-		{ QStringLiteral("overlap"), [](const QVariant &v) -> QVariant { return v.toBool(); } },
-	};
+	const QDate &asOf = snapshot.asOfDate();
 
-	const auto &jobList = QueryBuilder::q(db)
-						  .addQuery("SELECT id, start, end, name, master, type, hour, value, "
-									"EXISTS(SELECT * FROM overlap WHERE jobid1=job.id) AS overlap "
-									"FROM job "
-									"ORDER BY id")
-						  .execToVariantList(converter);
+	QSet<qint64> jobIds;
 
-	if (!jobList) {
-		LOG_CWARNING("app") << "Sql error:" << qPrintable(m_databaseName);
-		return {};
+	for (const UndoStack::Change &change : step.changes) {
+		if (change.table == UndoStack::Job)
+			jobIds.insert(change.id);
+		else if (const UndoStack::Row &row = change.before ? change.before : change.after; row)
+			jobIds.insert(row->value(QStringLiteral("jobid")).toLongLong());
 	}
 
-	QVariantList list;
+	// The overlap flag of the other members of the clusters (before and after) may change
 
-	struct Calc {
-		int jobYears = 0;
-		int jobDays = 0;
-		int practiceYears = 0;
-		int practiceDays = 0;
-		int prestigeYears = 0;
-		int prestigeDays = 0;
-
-		int nextPrestigeYears = 0;
-		QDate nextPrestige;
-
-		QDate prestigeBase = QDate::currentDate();
-
-		QVariantMap toMap() const {
-			QVariantMap m;
-			m[QStringLiteral("jobYears")] = jobYears;
-			m[QStringLiteral("jobDays")] = jobDays;
-			m[QStringLiteral("practiceYears")] = practiceYears;
-			m[QStringLiteral("practiceDays")] = practiceDays;
-			m[QStringLiteral("prestigeYears")] = prestigeYears;
-			m[QStringLiteral("prestigeDays")] = prestigeDays;
-			m[QStringLiteral("nextPrestigeYears")] = nextPrestigeYears;
-			m[QStringLiteral("nextPrestige")] = nextPrestige;
-			return m;
-		}
+	QSet<qint64> ids = jobIds;
 
-		void normalize() {
-			int jy = qFloor((float)jobDays/365.);
-			jobYears += jy;
-			jobDays -= 365*jy;
+	const auto addClusters = [this, &jobIds, &ids]() {
+		for (const qint64 &id : std::as_const(jobIds)) {
+			for (const qint64 &member : m_clusters.members(m_clusters.clusterId(id)))
+				ids.insert(member);
+		}
+	};
 
-			int pay = qFloor((float)practiceDays/365.);
-			practiceYears += pay;
-			practiceDays -= 365*pay;
+	clustersEnsure(asOf);
+	addClusters();
 
-			int pey = qFloor((float)prestigeDays/365.);
-			prestigeYears += pey;
-			prestigeDays -= 365*pey;
-		}
+	db.transaction();
 
-		void getNextPrestige() {
-			QDate d = prestigeBase
-					  .addDays(-prestigeDays)
-					  .addYears(-prestigeYears);
-
-			if (prestigeYears < 25) {
-				nextPrestige = d.addYears(25);
-				nextPrestigeYears = 25;
-			} else if (prestigeYears < 30) {
-				nextPrestige = d.addYears(30);
-				nextPrestigeYears = 30;
-			} else if (prestigeYears < 40) {
-				nextPrestige = d.addYears(40);
-				nextPrestigeYears = 40;
-			} else {
-				nextPrestige = QDate();
-				nextPrestigeYears = 0;
-			}
-		}
+	const int size = step.changes.size();
 
-		void truncatePrestigeAndPractice(const int &days) {
-			if (days <= 0)
-				return;
+	for (int i=0; i<size; ++i) {
+		const UndoStack::Change &change = step.changes.at(isUndo ? size-1-i : i);
+		const UndoStack::Row &row = isUndo ? change.before : change.after;
+		const bool isJob = change.table == UndoStack::Job;
 
-			prestigeBase = prestigeBase.addDays(-days);
+		bool success = false;
 
-			if (days>prestigeDays) {
-				--prestigeYears;
-				prestigeDays += 365;
-			}
-			prestigeDays -= days;
+		if (!row) {
+			success = QueryBuilder::q(db)
+					  .addQuery(isJob ? "DELETE FROM job WHERE id=" : "DELETE FROM calc WHERE id=").addValue(change.id)
+					  .exec();
+		} else {
+			// Existing rows are updated: REPLACE would delete them without firing the delete
+			// triggers (recursive_triggers is off), leaving the old text in the full-text index
 
-			if (prestigeYears < 0) {
-				prestigeYears = 0;
-				prestigeDays = 0;
-			}
+			QueryBuilder q(db);
+			q.addQuery(isJob ? "UPDATE job SET " : "UPDATE calc SET ")
+					.setCombinedPlaceholder();
 
-			if (days>practiceDays) {
-				--practiceYears;
-				practiceDays += 365;
+			for (auto it = row->constBegin(); it != row->constEnd(); ++it) {
+				if (it.key() != QStringLiteral("id"))
+					q.addField(it.key().toUtf8(), it.value());
 			}
-			practiceDays -= days;
 
-			if (practiceYears < 0) {
-				practiceYears = 0;
-				practiceDays = 0;
-			}
-		}
+			q.addQuery(" WHERE id=").addValue(change.id);
 
-	};
+			success = q.exec();
 
-	Calc calc;
+			if (success && q.sqlQuery().numRowsAffected() == 0) {
+				QueryBuilder qi(db);
+				qi.addQuery(isJob ? "INSERT INTO job(" : "INSERT INTO calc(")
+						.setFieldPlaceholder()
+						.addQuery(") VALUES (")
+						.setValuePlaceholder()
+						.addQuery(")");
 
-	for (const auto &v : *jobList) {
-		QVariantMap map = v.toMap();
+				for (auto it = row->constBegin(); it != row->constEnd(); ++it)
+					qi.addField(it.key().toUtf8(), it.value());
 
-		const int &id = map.value(QStringLiteral("id"), 0).toInt();
-		const QDate &date1 = map.value(QStringLiteral("start")).toDate();
-		QDate date2 = map.value(QStringLiteral("end")).toDate();
+				success = qi.exec();
+			}
+		}
 
-		if (date2.isNull()) {
-			map.remove(QStringLiteral("end"));
-			date2 = QDate::currentDate();
+		if (!success) {
+			LOG_CERROR("app") << "History error:" << qPrintable(step.text);
+			db.rollback();
+			m_clustersDate = QDate();
+			return std::nullopt;
 		}
+	}
 
-		const int &defYears = Application::yearsBetween(date1, date2);
-		const int &defDays = Application::daysBetween(date1, date2);
+	db.commit();
 
-		map.insert(QStringLiteral("durationYears"), defYears);
-		map.insert(QStringLiteral("durationDays"), defDays);
+	for (const UndoStack::Change &change : step.changes) {
+		if (change.table == UndoStack::Job)
+			clusterUpdate(change.id, asOf);
+	}
 
+	addClusters();
 
-		map.insert(QStringLiteral("jobMode"), -1);
-		map.insert(QStringLiteral("jobYears"), 0);
-		map.insert(QStringLiteral("jobDays"), 0);
-		map.insert(QStringLiteral("practiceMode"), -1);
-		map.insert(QStringLiteral("practiceYears"), 0);
-		map.insert(QStringLiteral("practiceDays"), 0);
-		map.insert(QStringLiteral("prestigeMode"), -1);
-		map.insert(QStringLiteral("prestigeYears"), 0);
-		map.insert(QStringLiteral("prestigeDays"), 0);
+	View view;
+	view.partial = true;
+	view.ids = QVector<qint64>(ids.constBegin(), ids.constEnd());
+	std::sort(view.ids.begin(), view.ids.end());
 
+	view.count = QueryBuilder::q(db)
+				 .addQuery("SELECT COUNT(*) AS cnt FROM job")
+				 .execToValue("cnt", 0)
+				 .value_or(0).toInt();
 
-		QueryBuilder q(db);
-		q.addQuery("SELECT type, mode, years, days FROM calc WHERE jobid=").addValue(id);
+	sqlTotals(&view.calculation, snapshot);
 
+	if (view.count <= m_pagedLimit)
+		view.list = sqlRows(view.ids, snapshot);
 
-		if (q.exec()) {
-			while (q.sqlQuery().next()) {
-				const int &type = q.value("type").toInt(0);
-				const int &mode = q.value("mode").toInt(0);
-				int years = q.value("years").toInt(0);
-				int days = q.value("days").toInt(0);
-
-				if (mode == 0) {
-					years = 0;
-					days = 0;
-				} else if (mode == 1) {
-					years = defYears;
-					days = defDays;
-				}
+	return view;
+}
 
-				QString prefix;
-
-				if (type == 1) {
-					prefix = QStringLiteral("job");
-					calc.jobDays += days;
-					calc.jobYears += years;
-				} else if (type == 2) {
-					prefix = QStringLiteral("practice");
-					calc.practiceDays += days;
-					calc.practiceYears += years;
-				} else if (type == 3) {
-					prefix = QStringLiteral("prestige");
-					calc.prestigeDays += days;
-					calc.prestigeYears += years;
-				}
 
-				map[prefix+QStringLiteral("Mode")] = mode;
-				map[prefix+QStringLiteral("Years")] = years;
-				map[prefix+QStringLiteral("Days")] = days;
-			}
-		}
 
-		list.append(map);
-	}
+/**
+ * @brief Database::historyFinish
+ * @param view
+ * @return
+ */
 
-	if (m_prestigeCalculationTime == 20240101) {			// Ezt még lehetne állíthatóvá tenni
-		const int &diff = QDate(2024, 1, 1).daysTo(QDate::currentDate());
-		calc.truncatePrestigeAndPractice(diff);
+bool Database::historyFinish(const std::optional<View> &view)
+{
+	if (!view) {
+		m_history.clear();
+		emit historyChanged();
+		sync();
+		return false;
 	}
 
+	setModified(true);
 
-	calc.normalize();
-	calc.getNextPrestige();
-
-	if (dest)
-		*dest = calc.toMap();
+	syncApply(*view);
 
-	return list;
+	return true;
 }
 
-int Database::prestigeCalculationTime() const
-{
-	return m_prestigeCalculationTime;
-}
 
-void Database::setPrestigeCalculationTime(int newPrestigeCalculationTime)
-{
-	if (m_prestigeCalculationTime == newPrestigeCalculationTime)
-		return;
-	m_prestigeCalculationTime = newPrestigeCalculationTime;
-	emit prestigeCalculationTimeChanged();
-}
 
-bool Database::modified() const
+/**
+ * @brief Database::undoLimit
+ * @return
+ */
+
+int Database::undoLimit() const
 {
-	return m_modified;
+	return m_history.limit();
 }
 
-void Database::setModified(bool newModified)
+void Database::setUndoLimit(int newUndoLimit)
 {
-	if (m_modified == newModified)
+	if (m_history.limit() == newUndoLimit)
 		return;
-	m_modified = newModified;
-	emit modifiedChanged();
+	m_history.setLimit(newUndoLimit);
+	emit undoLimitChanged();
+	emit historyChanged();
 }
 
 
 
 /**
- * @brief Database::sync
+ * @brief Database::toMarkdown
  */
 
-void Database::sync()
+QString Database::toMarkdown() const
 {
-	QVariantMap map;
-	Utils::patchSListModel(m_model.get(), sqlMainView(&map), QStringLiteral("id"));
-	setCalculation(map);
+	const Snapshot &s = snapshot();
+
+	return m_worker->exec([this, &s]() { return writeMarkdown(s); });
 }
 
 
 
 /**
- * @brief Database::toMarkdown
+ * @brief Database::writeMarkdown
+ * The rows and the totals are computed here from the same state (the model may still be
+ * waiting for its patch)
+ * @param snapshot
+ * @return
  */
 
-QString Database::toMarkdown() const
+QString Database::writeMarkdown(const Snapshot &snapshot) const
 {
+	QVariantMap totals;
+
+	const QVariantList &list = sqlMainView(&totals, snapshot);
+	const CalculationResult &calculation = CalculationResult::fromMap(totals);
+
 	QString txt;
 
 	txt.append(QStringLiteral("<html><body>\n"));
 
 	txt.append(QStringLiteral("<h1>"))
-			.append(m_title)
+			.append(snapshot.title)
 			.append(QStringLiteral("</h1>"));
 
-	txt.append(QStringLiteral("<h4>Jelenlegi jogviszony - piarista (a nyomtatás napján): <i>%1 év %2 nap</i><br/>")
-			   .arg(m_calculation.value(QStringLiteral("jobYears"), 0).toInt())
-			   .arg(m_calculation.value(QStringLiteral("jobDays"), 0).toInt())
+	const QString &asOfText = snapshot.asOf.isValid() ?
+								  QLocale().toString(snapshot.asOf, QStringLiteral("yyyy. MMMM d.")).append(QStringLiteral(" állapot")) :
+								  QStringLiteral("a nyomtatás napján");
+
+	txt.append(QStringLiteral("<h4>Jelenlegi jogviszony - piarista (%3): <i>%1 év %2 nap</i><br/>")
+			   .arg(calculation.jobYears)
+			   .arg(calculation.jobDays)
+			   .arg(asOfText)
 			   );
 
 
+	const QDate &cutoff = snapshot.cutoff;
+
 	txt.append(QStringLiteral("Gyakorlati idő"));
 
-	if (m_prestigeCalculationTime == 20240101)			// TODO
+	if (cutoff.isValid())
 		txt.append(QStringLiteral(" ("))
-				.append(QLocale().toString(QDate(2024, 1, 1), QStringLiteral("yyyy. MMMM d")))
+				.append(QLocale().toString(cutoff, QStringLiteral("yyyy. MMMM d")))
 				.append(QStringLiteral("-ig)"));
 
 	txt.append(QStringLiteral(": <i>%1 év %2 nap</i><br/>")
-			   .arg(m_calculation.value(QStringLiteral("practiceYears"), 0).toInt())
-			   .arg(m_calculation.value(QStringLiteral("practiceDays"), 0).toInt())
+			   .arg(calculation.practiceYears)
+			   .arg(calculation.practiceDays)
 			   );
 
 	txt.append(QStringLiteral("Jubileumi jutalom"));
 
-	if (m_prestigeCalculationTime == 20240101)			// TODO
+	if (cutoff.isValid())
 		txt.append(QStringLiteral(" ("))
-				.append(QLocale().toString(QDate(2024, 1, 1), QStringLiteral("yyyy. MMMM d")))
+				.append(QLocale().toString(cutoff, QStringLiteral("yyyy. MMMM d")))
 				.append(QStringLiteral("-ig)"));
 
 
 	txt.append(QStringLiteral(": <i>%1 év %2 nap</i></h4>")
-			   .arg(m_calculation.value(QStringLiteral("prestigeYears"), 0).toInt())
-			   .arg(m_calculation.value(QStringLiteral("prestigeDays"), 0).toInt())
+			   .arg(calculation.prestigeYears)
+			   .arg(calculation.prestigeDays)
 			   );
 
-	if (const int nextY = m_calculation.value(QStringLiteral("nextPrestigeYears"), 0).toInt(); nextY > 0) {
+	if (const int nextY = calculation.nextPrestigeYears; nextY > 0) {
 		txt.append(QStringLiteral("<h4>Következő jubileumi jutalom időpontja: <i>%1</i> (%2 év)</h4>")
-				   .arg(QLocale().toString(m_calculation.value(QStringLiteral("nextPrestige")).toDate(), QStringLiteral("yyyy. MMMM d.")))
-				   .arg(m_calculation.value(QStringLiteral("nextPrestigeYears"), 0).toInt())
+				   .arg(QLocale().toString(calculation.nextPrestige, QStringLiteral("yyyy. MMMM d.")))
+				   .arg(calculation.nextPrestigeYears)
 				   );
 	}
 
-	txt.append(QStringLiteral("<h3>&nbsp;</h3>"));
+	if (snapshot.unionMode)
+		txt.append(QStringLiteral("<p><i>Az egymással átfedő időszakok egyszer számítva.</i></p>"));
 
-	const QVariantList &list = m_model->storage();
+	txt.append(QStringLiteral("<h3>&nbsp;</h3>"));
 
 	for (const auto &v : list) {
 		const QVariantMap &map = v.toMap();
@@ -1091,12 +3197,12 @@ QString Database::toMarkdown() const
  * @return
  */
 
-QVariantMap Database::calculation() const
+CalculationResult Database::calculation() const
 {
 	return m_calculation;
 }
 
-void Database::setCalculation(const QVariantMap &newCalculation)
+void Database::setCalculation(const CalculationResult &newCalculation)
 {
 	if (m_calculation == newCalculation)
 		return;
@@ -1113,7 +3219,7 @@ void Database::setCalculation(const QVariantMap &newCalculation)
 
 bool Database::calculationAddFromJson(const QJsonObject &data)
 {
-	auto db = QSqlDatabase::database(m_databaseName);
+	auto db = DatabaseManager::connection(m_databaseName);
 	if (!db.isOpen()) {
 		LOG_CERROR("app") << "Database isn't opened";
 		return false;
@@ -1132,10 +3238,5 @@ bool Database::calculationAddFromJson(const QJsonObject &data)
 
 	const auto &id = q.execInsert();
 
-	if (!id)
-		return false;
-	else {
-		sync();
-		return true;
-	}
+	return id.has_value();
 }
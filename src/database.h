@@ -28,27 +28,57 @@
 #define DATABASE_H
 
 #include "qslistmodel.h"
+#include "modelpatcher.h"
+#include "joblistmodel.h"
+#include "jobproxymodel.h"
+#include "undostack.h"
+#include "overlapclusters.h"
+#include "databaseworker.h"
+#include "calculationresult.h"
 #include <QObject>
+#include <QIODevice>
+#include <QJsonDocument>
+#include <QSqlDatabase>
+#include <QDate>
+#include <QtQml/qqmlregistration.h>
+#include <atomic>
 
 class Database : public QObject
 {
 	Q_OBJECT
+	QML_ELEMENT
 
 	Q_PROPERTY(QString databaseName READ databaseName WRITE setDatabaseName NOTIFY databaseNameChanged FINAL)
 	Q_PROPERTY(QString title READ title WRITE setTitle NOTIFY titleChanged FINAL)
 	Q_PROPERTY(QSListModel* model READ model CONSTANT FINAL)
-	Q_PROPERTY(QVariantMap calculation READ calculation WRITE setCalculation NOTIFY calculationChanged FINAL)
+	Q_PROPERTY(JobListModel* pagedModel READ pagedModel CONSTANT FINAL)
+	Q_PROPERTY(JobProxyModel* proxyModel READ proxyModel CONSTANT FINAL)
+	Q_PROPERTY(bool paged READ paged NOTIFY pagedChanged FINAL)
+	Q_PROPERTY(CalculationResult calculation READ calculation NOTIFY calculationChanged FINAL)
 	Q_PROPERTY(int prestigeCalculationTime READ prestigeCalculationTime WRITE setPrestigeCalculationTime NOTIFY prestigeCalculationTimeChanged FINAL)
+	Q_PROPERTY(QDate prestigeCutoff READ prestigeCutoff WRITE setPrestigeCutoff NOTIFY prestigeCalculationTimeChanged FINAL)
+	Q_PROPERTY(QDate asOf READ asOf WRITE setAsOf NOTIFY asOfChanged FINAL)
+	Q_PROPERTY(bool unionMode READ unionMode WRITE setUnionMode NOTIFY unionModeChanged FINAL)
 	Q_PROPERTY(bool modified READ modified WRITE setModified NOTIFY modifiedChanged FINAL)
+	Q_PROPERTY(bool canUndo READ canUndo NOTIFY historyChanged FINAL)
+	Q_PROPERTY(bool canRedo READ canRedo NOTIFY historyChanged FINAL)
+	Q_PROPERTY(QString undoText READ undoText NOTIFY historyChanged FINAL)
+	Q_PROPERTY(QString redoText READ redoText NOTIFY historyChanged FINAL)
+	Q_PROPERTY(int undoLimit READ undoLimit WRITE setUndoLimit NOTIFY undoLimitChanged FINAL)
 
 public:
 	explicit Database(QObject *parent = nullptr);
 	virtual ~Database();
 
 	static bool prepare(const QString &databaseName);
-	std::optional<QJsonObject> toJson() const;
-	static Database *fromJson(const QString &databaseName, const QJsonObject &json);
-	static Database *fromJson(const QJsonObject &json) { return fromJson(QStringLiteral(""), json); }
+	void startWorker();
+	bool open();
+
+	bool toJson(QIODevice *device, const QJsonDocument::JsonFormat &format = QJsonDocument::Indented) const;
+	static Database *fromJson(const QString &databaseName, const QJsonObject &json, const bool &threaded = false);
+	static Database *fromJson(const QJsonObject &json, const bool &threaded = false) {
+		return fromJson(QStringLiteral(""), json, threaded);
+	}
 
 	Q_INVOKABLE int jobAdd(const QJsonObject &data);
 	bool jobAddBatch(const QVector<QVariantMap> &data);
@@ -58,12 +88,47 @@ public:
 	Q_INVOKABLE QVariantMap calculationGet(const int &id) const;
 	Q_INVOKABLE bool calculationEdit(const int &id, const QJsonObject &data);
 	Q_INVOKABLE QVariantList overlapGet(const int &id) const;
+	Q_INVOKABLE QVariantList clusterGet(const int &clusterId) const;
+
+	Q_INVOKABLE QVariantList totalsAt(const QVariantList &dates) const;
+	QVector<QVariantMap> totalsSeries(const QVector<QDate> &dates) const;
+	static QVector<QVariantMap> totalsSeries(const QSqlDatabase &db, const QVector<QDate> &dates, const QDate &cutoff);
+
+	Q_INVOKABLE QVariantList search(const QString &query) const;
 
 	Q_INVOKABLE void sync();
 
+	QFuture<void> syncAsync();
+	QFuture<int> jobAddAsync(const QJsonObject &data);
+	QFuture<bool> jobAddBatchAsync(const QVector<QVariantMap> &data);
+	QFuture<bool> jobEditAsync(const int &id, const QJsonObject &data);
+	QFuture<bool> jobDeleteAsync(const int &id);
+	QFuture<bool> calculationEditAsync(const int &id, const QJsonObject &data);
+	QFuture<bool> undoAsync();
+	QFuture<bool> redoAsync();
+	QFuture<QString> toMarkdownAsync() const;
+	QFuture<bool> saveAsync(const QString &fileName) const;
+	QFuture<std::optional<QByteArray>> toJsonAsync(const QJsonDocument::JsonFormat &format = QJsonDocument::Indented) const;
+	QFuture<QVariantMap> calculationGetAsync(const int &id) const;
+	QFuture<QVariantList> overlapGetAsync(const int &id) const;
+	QFuture<QVariantList> clusterGetAsync(const int &clusterId) const;
+	QFuture<QVariantList> searchAsync(const QString &query) const;
+
+	Q_INVOKABLE int request(const QString &method, const QVariantList &args = {});
+
+	Q_INVOKABLE bool undo();
+	Q_INVOKABLE bool redo();
+	Q_INVOKABLE void historyClear();
+
 
 	Q_INVOKABLE QString toMarkdown() const;
 
+	QFuture<QVariantList> jobWindowAsync(const int &offset, const int &limit) const;
+	QFuture<QVector<qint64>> jobIdsAsync() const;
+
+	static void calculateRow(const QSqlDatabase &db, QVariantMap *map, const QDate &asOf = QDate(), const QDate &cutoff = QDate());
+	static const QStringList &modelRoles();
+
 	QString databaseName() const;
 	void setDatabaseName(const QString &newDatabaseName);
 
@@ -71,9 +136,13 @@ public:
 	void setTitle(const QString &newTitle);
 
 	QSListModel* model() const;
+	JobListModel* pagedModel() const;
+	JobProxyModel* proxyModel() const;
 
-	QVariantMap calculation() const;
-	void setCalculation(const QVariantMap &newCalculation);
+	bool paged() const;
+
+	CalculationResult calculation() const;
+	void setCalculation(const CalculationResult &newCalculation);
 
 	bool modified() const;
 	void setModified(bool newModified);
@@ -81,6 +150,25 @@ public:
 	int prestigeCalculationTime() const;
 	void setPrestigeCalculationTime(int newPrestigeCalculationTime);
 
+	QDate prestigeCutoff() const;
+	void setPrestigeCutoff(const QDate &newPrestigeCutoff);
+	static QDate cutoffDate(const int &prestigeCalculationTime);
+
+	QDate asOf() const;
+	void setAsOf(const QDate &newAsOf);
+	QDate asOfDate() const { return m_asOf.isValid() ? m_asOf : QDate::currentDate(); }
+
+	bool unionMode() const;
+	void setUnionMode(bool newUnionMode);
+
+	bool canUndo() const { return m_history.canUndo(); }
+	bool canRedo() const { return m_history.canRedo(); }
+	QString undoText() const { return m_history.undoText(); }
+	QString redoText() const { return m_history.redoText(); }
+
+	int undoLimit() const;
+	void setUndoLimit(int newUndoLimit);
+
 signals:
 	void databaseNameChanged();
 	void titleChanged();
@@ -88,18 +176,138 @@ signals:
 	void modifiedChanged();
 
 	void prestigeCalculationTimeChanged();
+	void asOfChanged();
+	void unionModeChanged();
+	void historyChanged();
+	void undoLimitChanged();
+	void pagedChanged();
+	void requestFinished(int request, const QVariant &result);
 
 private:
+	struct Calc {
+		int jobYears = 0;
+		int jobDays = 0;
+		int practiceYears = 0;
+		int practiceDays = 0;
+		int prestigeYears = 0;
+		int prestigeDays = 0;
+
+		int nextPrestigeYears = 0;
+		QDate nextPrestige;
+
+		QDate prestigeBase;
+
+		QVariantMap toMap() const;
+		void add(const int &type, const int &years, const int &days);
+		void normalize();
+		void getNextPrestige();
+	};
+
+	struct HistoryRows {
+		QHash<int, QVariantMap> job;
+		QHash<int, QVariantMap> calc;
+	};
+
+	// Settings of the database copied for a task of the worker thread
+
+	struct Snapshot {
+		QString title;
+		int prestigeCalculationTime = -1;
+		QDate asOf;
+		QDate cutoff;
+		bool unionMode = false;
+		bool history = true;
+
+		QDate asOfDate() const { return asOf.isValid() ? asOf : QDate::currentDate(); }
+	};
+
+	// Result of a mutator on the worker thread, applied on the thread of the Database
+
+	struct Mutation {
+		bool success = false;
+		int id = -1;
+		QString text;
+		HistoryRows before;
+		HistoryRows after;
+	};
+
+	// Result of a sync: the rows are omitted in paged mode. A partial view holds
+	// only the rows of ids (missing rows are removed).
+
+	struct View {
+		QVariantList list;
+		QVariantMap calculation;
+		int count = 0;
+		bool partial = false;
+		QVector<qint64> ids;
+	};
+
+	Snapshot snapshot() const;
+
+	Mutation jobAddSql(const QJsonObject &data, const Snapshot &snapshot);
+	Mutation jobAddBatchSql(const QVector<QVariantMap> &data, const Snapshot &snapshot);
+	Mutation jobEditSql(const int &id, const QJsonObject &data, const Snapshot &snapshot);
+	Mutation jobDeleteSql(const int &id, const Snapshot &snapshot);
+	Mutation calculationEditSql(const int &id, const QJsonObject &data, const Snapshot &snapshot);
+	bool mutationApply(const Mutation &mutation);
+
 	bool calculationAddFromJson(const QJsonObject &data);
-	QVariantList sqlMainView(QVariantMap *dest) const;
+	bool writeJson(QIODevice *device, const QJsonDocument::JsonFormat &format, const Snapshot &snapshot) const;
+	QString writeMarkdown(const Snapshot &snapshot) const;
+	View sqlView(const Snapshot &snapshot) const;
+	QVariantList sqlMainView(QVariantMap *dest, const Snapshot &snapshot) const;
+	bool sqlTotals(QVariantMap *dest, const Snapshot &snapshot) const;
+	QVariantList sqlRows(const QVector<qint64> &ids, const Snapshot &snapshot) const;
+	QVariantList overlapList(const int &id, const QDate &asOf) const;
+	QVariantList clusterList(const int &clusterId, const QDate &asOf) const;
+	static void calculationFinish(Calc *calc, const QDate &asOf, const QDate &cutoff);
+	static void calculationUnion(QVector<std::pair<QDate, QDate>> *counted, Calc *calc);
 
-	QString m_databaseName = QStringLiteral("mainDb");
+	void clustersEnsure(const QDate &asOf) const;
+	void clusterUpdate(const int &id, const QDate &asOf);
+	void clusterFill(QVariantMap *map) const;
+
+	void setPaged(bool newPaged);
+	void syncApply(const View &view);
+	QVariantList syncMerge(const View &view) const;
+
+	HistoryRows historyRows(const QVariantList &jobIds) const;
+	void historyPush(const QString &text, const HistoryRows &before, const HistoryRows &after);
+	bool historyStep(const bool &isUndo);
+	QFuture<bool> historyStepAsync(const bool &isUndo);
+	std::optional<View> historyApply(const UndoStack::Step &step, const bool &isUndo, const Snapshot &snapshot);
+	bool historyFinish(const std::optional<View> &view);
+
+	QString m_databaseName;
 	QString m_title;
 	int m_prestigeCalculationTime = -1;
+	QDate m_asOf;
+	bool m_unionMode = false;
 	bool m_modified = false;
 
 	std::unique_ptr<QSListModel> m_model;
-	QVariantMap m_calculation;
+	std::unique_ptr<ModelPatcher> m_patcher;
+	std::unique_ptr<JobListModel> m_pagedModel;
+	std::unique_ptr<JobProxyModel> m_proxyModel;
+	bool m_paged = false;
+	CalculationResult m_calculation;
+
+	UndoStack m_history;
+
+	// Used only on the worker thread
+
+	mutable std::optional<bool> m_ftsAvailable;
+	mutable OverlapClusters m_clusters;
+	mutable QDate m_clustersDate;
+
+	std::unique_ptr<DatabaseWorker> m_worker;
+	std::atomic<quint64> m_syncSequence = 0;
+	int m_syncPending = 0;
+	int m_requestId = 0;
+
+	static const int m_pagedLimit;
+
+	friend class DatabaseBench;
 };
 
 #endif // DATABASE_H
@@ -0,0 +1,579 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * databasemanager.cpp
+ *
+ * Created on: 2024. 01. 24.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * DatabaseManager
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "databasemanager.h"
+#include "database.h"
+#include "logfilter.h"
+#include "utils_.h"
+#include <QFileInfo>
+#include <QSqlQuery>
+#include <QThread>
+
+
+/// Thread owning the connection of each database, clones of the connection for other threads
+
+static QMutex s_connectionMutex;
+static QHash<QString, QThread*> s_connectionOwner;
+static QHash<QString, QStringList> s_connectionClones;
+
+
+
+/**
+ * @brief DatabaseManager::DatabaseManager
+ * @param idleLimit
+ */
+
+DatabaseManager::DatabaseManager(const int &idleLimit)
+	: m_idleLimit(idleLimit)
+{
+
+}
+
+
+/**
+ * @brief DatabaseManager::~DatabaseManager
+ */
+
+DatabaseManager::~DatabaseManager()
+{
+	for (auto &[key, entry] : m_entries) {
+		if (entry.refs > 0)
+			LOG_CWARNING("app") << "Database still in use:" << qPrintable(key) << entry.refs;
+
+		// Nothing can use them any more: the ones of this thread are deleted at once
+
+		if (entry.database->thread() == QThread::currentThread())
+			entry.database.reset();
+		else
+			entry.database.release()->deleteLater();
+	}
+}
+
+
+
+/**
+ * @brief DatabaseManager::uniqueName
+ * @param prefix
+ * @return
+ */
+
+QString DatabaseManager::uniqueName(const QString &prefix)
+{
+	static QAtomicInt counter;
+
+	return QStringLiteral("%1_%2").arg(prefix).arg(counter.fetchAndAddRelaxed(1));
+}
+
+
+
+/**
+ * @brief DatabaseManager::registerConnection
+ * Register the connection opened on the current thread
+ * @param name
+ */
+
+void DatabaseManager::registerConnection(const QString &name)
+{
+	QMutexLocker locker(&s_connectionMutex);
+	s_connectionOwner.insert(name, QThread::currentThread());
+}
+
+
+
+/**
+ * @brief DatabaseManager::connection
+ * Connection of the database usable on the current thread (a shared cache clone on foreign threads,
+ * removed when the thread finishes)
+ * @param name
+ * @return
+ */
+
+QSqlDatabase DatabaseManager::connection(const QString &name)
+{
+	QThread *thread = QThread::currentThread();
+
+	{
+		QMutexLocker locker(&s_connectionMutex);
+
+		const auto it = s_connectionOwner.constFind(name);
+
+		if (it == s_connectionOwner.constEnd() || it.value() == thread)
+			return QSqlDatabase::database(name);
+	}
+
+	const QString &clone = QStringLiteral("%1@%2").arg(name).arg(quintptr(thread), 0, 16);
+
+	if (QSqlDatabase::contains(clone))
+		return QSqlDatabase::database(clone);
+
+	LOG_CTRACE("app") << "Clone connection" << qPrintable(clone);
+
+	{
+		QSqlDatabase db = QSqlDatabase::cloneDatabase(name, clone);
+
+		if (!db.open()) {
+			LOG_CERROR("app") << "Can't open connection:" << qPrintable(clone);
+			db = QSqlDatabase();
+			QSqlDatabase::removeDatabase(clone);
+			return QSqlDatabase();
+		}
+
+		// Don't wait for the table locks of the shared cache (SQLITE_LOCKED isn't retried)
+
+		QSqlQuery(db).exec(QStringLiteral("PRAGMA read_uncommitted = 1"));
+	}
+
+	{
+		QMutexLocker locker(&s_connectionMutex);
+		s_connectionClones[name].append(clone);
+	}
+
+	QObject::connect(thread, &QThread::finished, thread, [name, clone]() {
+		{
+			QMutexLocker locker(&s_connectionMutex);
+
+			if (auto it = s_connectionClones.find(name); it != s_connectionClones.end())
+				it->removeAll(clone);
+		}
+
+		QSqlDatabase::removeDatabase(clone);
+	}, Qt::DirectConnection);
+
+	return QSqlDatabase::database(clone);
+}
+
+
+
+/**
+ * @brief DatabaseManager::removeConnections
+ * Remove the connection and its clones
+ * @param name
+ */
+
+void DatabaseManager::removeConnections(const QString &name)
+{
+	QStringList list;
+
+	{
+		QMutexLocker locker(&s_connectionMutex);
+		list = s_connectionClones.take(name);
+		s_connectionOwner.remove(name);
+	}
+
+	list.append(name);
+
+	for (const QString &n : std::as_const(list)) {
+		if (QSqlDatabase::contains(n))
+			QSqlDatabase::removeDatabase(n);
+	}
+}
+
+
+
+/**
+ * @brief DatabaseManager::acquire
+ * Database of the file (loaded or from the already opened ones)
+ * @param fileName
+ * @param json content of the file already read by the caller (the file is read if not set)
+ * @return nullptr on error
+ */
+
+Database *DatabaseManager::acquire(const QString &fileName, const std::optional<QJsonObject> &json)
+{
+	const QFileInfo info(fileName);
+
+	if (!info.exists()) {
+		LOG_CWARNING("app") << "File doesn't exist:" << qPrintable(fileName);
+		return nullptr;
+	}
+
+	const QString &key = info.canonicalFilePath();
+
+	QMutexLocker locker(&m_mutex);
+
+	const bool threaded = m_threaded;
+
+	std::vector<std::unique_ptr<Database>> list;
+
+	if (auto it = m_entries.find(key); it != m_entries.end()) {
+		Entry &e = it->second;
+
+		if ((e.modified == info.lastModified() && e.size == info.size()) || e.refs > 0) {
+			++e.refs;
+			e.lastUsed = ++m_clock;
+			return e.database.get();
+		}
+
+		LOG_CDEBUG("app") << "Reload changed file:" << qPrintable(key);
+		list.push_back(std::move(e.database));
+		m_entries.erase(it);
+	}
+
+	// Load without holding the lock
+
+	locker.unlock();
+
+	destroy(std::move(list));
+
+	const auto &content = json ? json : Utils::fileToJsonObject(key);
+
+	if (!content) {
+		LOG_CWARNING("app") << "Invalid file:" << qPrintable(key);
+		return nullptr;
+	}
+
+	std::unique_ptr<Database> db(Database::fromJson(uniqueName(), *content, threaded));
+
+	if (!db)
+		return nullptr;
+
+	locker.relock();
+
+	// Loaded by an other thread meanwhile
+
+	if (auto it = m_entries.find(key); it != m_entries.end()) {
+		++it->second.refs;
+		it->second.lastUsed = ++m_clock;
+		return it->second.database.get();
+	}
+
+	Entry &e = m_entries[key];
+	e.database = std::move(db);
+	e.modified = info.lastModified();
+	e.size = info.size();
+	e.refs = 1;
+	e.lastUsed = ++m_clock;
+
+	return e.database.get();
+}
+
+
+
+/**
+ * @brief DatabaseManager::create
+ * New empty database
+ * @param title
+ * @return
+ */
+
+Database *DatabaseManager::create(const QString &title)
+{
+	std::unique_ptr<Database> db(new Database);
+
+	if (m_threaded)
+		db->startWorker();
+
+	if (!db->open())
+		return nullptr;
+
+	db->setTitle(title);
+
+	return insert(std::move(db));
+}
+
+
+
+/**
+ * @brief DatabaseManager::load
+ * Database loaded from JSON data (without file)
+ * @param json
+ * @return nullptr on error
+ */
+
+Database *DatabaseManager::load(const QJsonObject &json)
+{
+	std::unique_ptr<Database> db(Database::fromJson(uniqueName(), json, threaded()));
+
+	if (!db)
+		return nullptr;
+
+	return insert(std::move(db));
+}
+
+
+
+/**
+ * @brief DatabaseManager::insert
+ * Add the database without file, acquired once
+ * @param database
+ * @return
+ */
+
+Database *DatabaseManager::insert(std::unique_ptr<Database> database)
+{
+	QMutexLocker locker(&m_mutex);
+
+	Entry &e = m_entries[database->databaseName()];
+	e.database = std::move(database);
+	e.refs = 1;
+	e.lastUsed = ++m_clock;
+
+	return e.database.get();
+}
+
+
+
+/**
+ * @brief DatabaseManager::release
+ * @param database
+ * @return
+ */
+
+bool DatabaseManager::release(Database *database)
+{
+	QMutexLocker locker(&m_mutex);
+
+	const auto it = std::find_if(m_entries.begin(), m_entries.end(),
+								 [database](const auto &p) { return p.second.database.get() == database; });
+
+	if (it == m_entries.end()) {
+		LOG_CWARNING("app") << "Unknown database";
+		return false;
+	}
+
+	Entry &e = it->second;
+
+	if (e.refs <= 0) {
+		LOG_CWARNING("app") << "Database already released:" << qPrintable(it->first);
+		return false;
+	}
+
+	--e.refs;
+	e.lastUsed = ++m_clock;
+
+	std::vector<std::unique_ptr<Database>> list;
+
+	// Without a file it can't be acquired again
+
+	if (e.refs == 0 && e.modified.isNull()) {
+		LOG_CTRACE("app") << "Close database:" << qPrintable(it->first);
+		list.push_back(std::move(e.database));
+		m_entries.erase(it);
+	}
+
+	for (auto &db : evict())
+		list.push_back(std::move(db));
+
+	locker.unlock();
+
+	destroy(std::move(list));
+
+	return true;
+}
+
+
+
+/**
+ * @brief DatabaseManager::close
+ * Release the database and close it if it isn't used any more (even if it is modified)
+ * @param database
+ * @return
+ */
+
+bool DatabaseManager::close(Database *database)
+{
+	QMutexLocker locker(&m_mutex);
+
+	const auto it = std::find_if(m_entries.begin(), m_entries.end(),
+								 [database](const auto &p) { return p.second.database.get() == database; });
+
+	if (it == m_entries.end()) {
+		LOG_CWARNING("app") << "Unknown database";
+		return false;
+	}
+
+	Entry &e = it->second;
+
+	if (e.refs <= 0) {
+		LOG_CWARNING("app") << "Database already released:" << qPrintable(it->first);
+		return false;
+	}
+
+	if (--e.refs > 0) {
+		e.lastUsed = ++m_clock;
+		return true;
+	}
+
+	LOG_CTRACE("app") << "Close database:" << qPrintable(it->first);
+
+	std::vector<std::unique_ptr<Database>> list;
+	list.push_back(std::move(e.database));
+	m_entries.erase(it);
+
+	locker.unlock();
+
+	destroy(std::move(list));
+
+	return true;
+}
+
+
+
+/**
+ * @brief DatabaseManager::evict
+ * Take the least recently used idle databases above the limit (modified ones are kept).
+ * The mutex must be locked, the databases have to be destroyed after unlocking it.
+ * @return
+ */
+
+std::vector<std::unique_ptr<Database>> DatabaseManager::evict()
+{
+	std::vector<std::unique_ptr<Database>> list;
+
+	int idle = 0;
+
+	for (const auto &[key, e] : m_entries) {
+		if (e.refs == 0 && !e.database->modified())
+			++idle;
+	}
+
+	while (idle > m_idleLimit) {
+		auto lru = m_entries.end();
+
+		for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+			const Entry &e = it->second;
+
+			if (e.refs == 0 && !e.database->modified() && (lru == m_entries.end() || e.lastUsed < lru->second.lastUsed))
+				lru = it;
+		}
+
+		if (lru == m_entries.end())
+			break;
+
+		LOG_CTRACE("app") << "Evict database:" << qPrintable(lru->first);
+
+		list.push_back(std::move(lru->second.database));
+		m_entries.erase(lru);
+		--idle;
+	}
+
+	return list;
+}
+
+
+
+/**
+ * @brief DatabaseManager::destroy
+ * Delete the databases on their own thread (the models and the worker belong to it)
+ * @param list
+ */
+
+void DatabaseManager::destroy(std::vector<std::unique_ptr<Database>> list)
+{
+	for (auto &db : list)
+		db.release()->deleteLater();
+}
+
+
+
+/**
+ * @brief DatabaseManager::idleLimit
+ * @return
+ */
+
+int DatabaseManager::idleLimit() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_idleLimit;
+}
+
+void DatabaseManager::setIdleLimit(const int &idleLimit)
+{
+	QMutexLocker locker(&m_mutex);
+	m_idleLimit = std::max(0, idleLimit);
+
+	auto list = evict();
+
+	locker.unlock();
+
+	destroy(std::move(list));
+}
+
+
+
+/**
+ * @brief DatabaseManager::threaded
+ * @return
+ */
+
+bool DatabaseManager::threaded() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_threaded;
+}
+
+void DatabaseManager::setThreaded(const bool &threaded)
+{
+	QMutexLocker locker(&m_mutex);
+	m_threaded = threaded;
+}
+
+
+
+/**
+ * @brief DatabaseManager::size
+ * @return
+ */
+
+int DatabaseManager::size() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_entries.size();
+}
+
+
+
+/**
+ * @brief DatabaseManager::idleCount
+ * @return
+ */
+
+int DatabaseManager::idleCount() const
+{
+	QMutexLocker locker(&m_mutex);
+	return std::count_if(m_entries.cbegin(), m_entries.cend(), [](const auto &p) { return p.second.refs == 0; });
+}
+
+
+
+/**
+ * @brief DatabaseManager::files
+ * @return
+ */
+
+QStringList DatabaseManager::files() const
+{
+	QMutexLocker locker(&m_mutex);
+
+	QStringList list;
+
+	for (const auto &[key, e] : m_entries) {
+		if (!e.modified.isNull())
+			list.append(key);
+	}
+
+	return list;
+}
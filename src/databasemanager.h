@@ -0,0 +1,109 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * databasemanager.h
+ *
+ * Created on: 2024. 01. 24.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * DatabaseManager
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASEMANAGER_H
+#define DATABASEMANAGER_H
+
+#include <QDateTime>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSqlDatabase>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+class Database;
+
+
+/**
+ * @brief The DatabaseManager class
+ *
+ * Keeps many employee databases open at the same time. Databases are acquired by file name and
+ * reference counted; released (idle) databases stay loaded until more than idleLimit of them are
+ * idle, then the least recently used unmodified ones are closed. A file changed on disk is reloaded
+ * on the next acquire (if it is idle). The content of the file can be read by the caller in advance (e.g.
+ * on a pool thread), it is used only if the file isn't loaded yet. Databases without a file (create(), load()) can't be acquired
+ * again, so they are closed on their last release; close() drops any database at once.
+ *
+ * Connection names are unique in the process. The in-memory databases use shared cache, so other
+ * threads get their own connection to the same data with connection(). Shared cache uses table
+ * locks: a clone would fail with SQLITE_LOCKED (not retried by the busy timeout) while the owner
+ * writes, so clones are opened with read_uncommitted and are meant for reading only; writes belong
+ * to the owner thread (the worker of the Database).
+ *
+ * Databases are created on the thread calling acquire()/create()/load() and are deleted on that
+ * thread (deleteLater), so the event loop of that thread must run.
+ */
+
+class DatabaseManager
+{
+public:
+	explicit DatabaseManager(const int &idleLimit = 16);
+	~DatabaseManager();
+
+	static QString uniqueName(const QString &prefix = QStringLiteral("db"));
+	static void registerConnection(const QString &name);
+	static QSqlDatabase connection(const QString &name);
+	static void removeConnections(const QString &name);
+
+	Database *acquire(const QString &fileName, const std::optional<QJsonObject> &json = std::nullopt);
+	Database *create(const QString &title);
+	Database *load(const QJsonObject &json);
+	bool release(Database *database);
+	bool close(Database *database);
+
+	int idleLimit() const;
+	void setIdleLimit(const int &idleLimit);
+
+	bool threaded() const;
+	void setThreaded(const bool &threaded);
+
+	int size() const;
+	int idleCount() const;
+	QStringList files() const;
+
+private:
+	struct Entry {
+		std::unique_ptr<Database> database;
+		QDateTime modified;
+		qint64 size = -1;
+		int refs = 0;
+		quint64 lastUsed = 0;
+	};
+
+	Database *insert(std::unique_ptr<Database> database);
+	std::vector<std::unique_ptr<Database>> evict();
+	static void destroy(std::vector<std::unique_ptr<Database>> list);
+
+	mutable QMutex m_mutex;
+	std::map<QString, Entry> m_entries;
+	quint64 m_clock = 0;
+	int m_idleLimit = 16;
+	bool m_threaded = false;
+};
+
+#endif // DATABASEMANAGER_H
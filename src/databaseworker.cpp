@@ -0,0 +1,90 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * databaseworker.cpp
+ *
+ * Created on: 2024. 01. 22.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * DatabaseWorker
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "databaseworker.h"
+#include "logfilter.h"
+
+
+
+/**
+ * @brief DatabaseWorker::~DatabaseWorker
+ */
+
+DatabaseWorker::~DatabaseWorker()
+{
+	stop();
+}
+
+
+
+/**
+ * @brief DatabaseWorker::start
+ * @param name
+ */
+
+void DatabaseWorker::start(const QString &name)
+{
+#ifdef DATABASE_WORKER_THREADED
+	if (m_thread)
+		return;
+
+	LOG_CTRACE("app") << "Start database worker" << qPrintable(name);
+
+	m_thread = new QThread;
+	m_thread->setObjectName(QStringLiteral("db_")+name);
+
+	m_context = new QObject;
+	m_context->moveToThread(m_thread);
+
+	QObject::connect(m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+
+	m_thread->start();
+#else
+	Q_UNUSED(name);
+#endif
+}
+
+
+
+/**
+ * @brief DatabaseWorker::stop
+ * Wait for the queued tasks and stop the thread
+ */
+
+void DatabaseWorker::stop()
+{
+	if (!m_thread)
+		return;
+
+	QMetaObject::invokeMethod(m_context, []() {}, Qt::BlockingQueuedConnection);
+
+	m_thread->quit();
+	m_thread->wait();
+
+	delete m_thread;
+	m_thread = nullptr;
+	m_context = nullptr;
+}
@@ -0,0 +1,133 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * databaseworker.h
+ *
+ * Created on: 2024. 01. 22.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * DatabaseWorker
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASEWORKER_H
+#define DATABASEWORKER_H
+
+#include <QObject>
+#include <QFuture>
+#include <QPromise>
+#include <QThread>
+#include <type_traits>
+
+#if QT_CONFIG(thread) && !defined(NO_LAMBDA_THREAD)
+#define DATABASE_WORKER_THREADED
+#endif
+
+
+/**
+ * @brief The DatabaseWorker class
+ *
+ * Serial executor of the SQL work of one Database. After start() every task runs on a dedicated
+ * thread (which owns the QSqlDatabase connection) in the order of submission; before start()
+ * (or without thread support) tasks run on the calling thread.
+ */
+
+class DatabaseWorker
+{
+public:
+	DatabaseWorker() = default;
+	~DatabaseWorker();
+
+	void start(const QString &name);
+	void stop();
+
+	bool isStarted() const { return m_thread; }
+	bool isCurrentThread() const { return !m_thread || QThread::currentThread() == m_thread; }
+
+	template <typename Func>
+	std::invoke_result_t<Func> exec(Func func);
+
+	template <typename Func>
+	QFuture<std::invoke_result_t<Func>> run(Func func);
+
+private:
+	QThread *m_thread = nullptr;
+	QObject *m_context = nullptr;
+};
+
+
+
+/**
+ * @brief DatabaseWorker::exec
+ * Run func on the worker thread and wait for its result
+ * @param func
+ * @return
+ */
+
+template<typename Func>
+std::invoke_result_t<Func> DatabaseWorker::exec(Func func)
+{
+	if (isCurrentThread())
+		return func();
+
+	if constexpr (std::is_void_v<std::invoke_result_t<Func>>) {
+		QMetaObject::invokeMethod(m_context, func, Qt::BlockingQueuedConnection);
+	} else {
+		std::invoke_result_t<Func> r{};
+		QMetaObject::invokeMethod(m_context, [&r, &func]() { r = func(); }, Qt::BlockingQueuedConnection);
+		return r;
+	}
+}
+
+
+
+/**
+ * @brief DatabaseWorker::run
+ * Queue func on the worker thread
+ * @param func
+ * @return
+ */
+
+template<typename Func>
+QFuture<std::invoke_result_t<Func>> DatabaseWorker::run(Func func)
+{
+	using T = std::invoke_result_t<Func>;
+
+	auto promise = std::make_shared<QPromise<T>>();
+	QFuture<T> future = promise->future();
+
+	promise->start();
+
+	auto task = [promise, func]() mutable {
+		if constexpr (std::is_void_v<T>)
+			func();
+		else
+			promise->addResult(func());
+
+		promise->finish();
+	};
+
+	if (m_thread)
+		QMetaObject::invokeMethod(m_context, std::move(task), Qt::QueuedConnection);
+	else
+		task();
+
+	return future;
+}
+
+
+#endif // DATABASEWORKER_H
@@ -25,8 +25,9 @@
  */
 
 #include "desktopapplication.h"
+#include "asyncappender.h"
 #include "ColorConsoleAppender.h"
-#include "Logger.h"
+#include "logfilter.h"
 
 /**
  * @brief DesktopApplication::DesktopApplication
@@ -35,8 +36,21 @@
 DesktopApplication::DesktopApplication(QGuiApplication *app)
 	: Application(app)
 {
-	auto appender = new ColorConsoleAppender;
+	// Levels are filtered by LogFilter before the message is built, the appender writes everything it gets
 
+#ifdef QT_NO_DEBUG
+	LogFilter::setLevel(LogFilter::Info);
+#else
+	LogFilter::setLevel(LogFilter::Trace);
+#endif
+
+	if (const QString &spec = qEnvironmentVariable("TIMECALCULATOR_LOG"); !spec.isEmpty() && !LogFilter::configure(spec))
+		LOG_CWARNING("app") << "Invalid log level specification:" << spec;
+
+	auto console = new ColorConsoleAppender;
+	console->setDetailsLevel(Logger::Trace);
+
+	auto appender = new AsyncAppender(console);
 	appender->setDetailsLevel(Logger::Trace);
 
 	cuteLogger->registerAppender(appender);
@@ -0,0 +1,141 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * durationcache.cpp
+ *
+ * Created on: 2024. 01. 20.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * DurationCache
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "durationcache.h"
+#include "civilcalendar.hpp"
+#include <QMutexLocker>
+
+
+/**
+ * @brief DurationCache::DurationCache
+ * @param capacity
+ */
+
+DurationCache::DurationCache(const int &capacity)
+	: m_cache(capacity)
+{
+
+}
+
+
+/**
+ * @brief DurationCache::instance
+ * @return
+ */
+
+DurationCache *DurationCache::instance()
+{
+	static DurationCache cache;
+	return &cache;
+}
+
+
+
+/**
+ * @brief DurationCache::get
+ * @param date1
+ * @param date2
+ * @return
+ */
+
+DurationCache::Duration DurationCache::get(const QDate &date1, const QDate &date2)
+{
+	if (!date1.isValid() || !date2.isValid())
+		return Duration();
+
+	const quint64 &k = key(date1.toJulianDay(), date2.toJulianDay());
+
+	{
+		QMutexLocker locker(&m_mutex);
+
+		if (const Duration *d = m_cache.object(k)) {
+			++m_hits;
+			return *d;
+		}
+	}
+
+	++m_misses;
+
+	const Duration &d = calculate(date1, date2);
+
+	QMutexLocker locker(&m_mutex);
+
+	m_cache.insert(k, new Duration(d));
+
+	return d;
+}
+
+
+
+/**
+ * @brief DurationCache::clear
+ */
+
+void DurationCache::clear()
+{
+	QMutexLocker locker(&m_mutex);
+	m_cache.clear();
+	m_hits = 0;
+	m_misses = 0;
+}
+
+
+
+/**
+ * @brief DurationCache::stats
+ * @return
+ */
+
+DurationCache::Stats DurationCache::stats() const
+{
+	QMutexLocker locker(&m_mutex);
+
+	Stats s;
+	s.hits = m_hits;
+	s.misses = m_misses;
+	s.size = m_cache.size();
+	return s;
+}
+
+
+
+/**
+ * @brief DurationCache::calculate
+ * @param date1
+ * @param date2
+ * @return
+ */
+
+DurationCache::Duration DurationCache::calculate(const QDate &date1, const QDate &date2)
+{
+	const CivilCalendar::Duration &d = CivilCalendar::between(date1.toJulianDay(), date2.toJulianDay());
+
+	Duration r;
+	r.years = d.years;
+	r.days = d.days;
+	return r;
+}
+
@@ -0,0 +1,79 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * durationcache.h
+ *
+ * Created on: 2024. 01. 20.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * DurationCache
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DURATIONCACHE_H
+#define DURATIONCACHE_H
+
+#include <QDate>
+#include <QCache>
+#include <QMutex>
+#include <atomic>
+
+
+/**
+ * @brief The DurationCache class
+ *
+ * Memo cache of the years/days between two dates (keyed by the packed pair of day numbers).
+ * The cache is bounded (least recently used entries are dropped) and thread-safe.
+ * The value is a pure function of the two dates, so entries never go stale.
+ */
+
+class DurationCache
+{
+public:
+	struct Duration {
+		int years = 0;
+		int days = 0;
+	};
+
+	struct Stats {
+		quint64 hits = 0;
+		quint64 misses = 0;
+		int size = 0;
+	};
+
+	explicit DurationCache(const int &capacity = 8192);
+
+	static DurationCache *instance();
+
+	Duration get(const QDate &date1, const QDate &date2);
+	void clear();
+	Stats stats() const;
+
+	static Duration calculate(const QDate &date1, const QDate &date2);
+
+private:
+	static quint64 key(const qint64 &day1, const qint64 &day2) {
+		return (quint64(quint32(day1)) << 32) | quint32(day2);
+	}
+
+	mutable QMutex m_mutex;
+	QCache<quint64, Duration> m_cache;
+	std::atomic<quint64> m_hits = 0;
+	std::atomic<quint64> m_misses = 0;
+};
+
+#endif // DURATIONCACHE_H
@@ -0,0 +1,484 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * joblistmodel.cpp
+ *
+ * Created on: 2024. 01. 15.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * JobListModel
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "joblistmodel.h"
+#include "database.h"
+#include "logfilter.h"
+
+
+const int JobListModel::m_windowSize = 200;
+
+
+/**
+ * @brief JobListModel::JobListModel
+ * @param database
+ */
+
+JobListModel::JobListModel(Database *database)
+	: QAbstractListModel()
+	, m_database(database)
+{
+	Q_ASSERT(m_database);
+
+	const QStringList &roles = Database::modelRoles();
+
+	for (int i=0; i<roles.size(); ++i)
+		m_roleNames.insert(Qt::UserRole+i, roles.at(i).toUtf8());
+}
+
+
+/**
+ * @brief JobListModel::~JobListModel
+ */
+
+JobListModel::~JobListModel()
+{
+
+}
+
+
+
+/**
+ * @brief JobListModel::rowCount
+ * @param parent
+ * @return
+ */
+
+int JobListModel::rowCount(const QModelIndex &parent) const
+{
+	if (parent.isValid())
+		return 0;
+
+	return m_rows.size();
+}
+
+
+/**
+ * @brief JobListModel::data
+ * @param index
+ * @param role
+ * @return
+ */
+
+QVariant JobListModel::data(const QModelIndex &index, int role) const
+{
+	if (!index.isValid() || index.row() >= m_rows.size())
+		return QVariant();
+
+	const auto it = m_roleNames.constFind(role);
+
+	if (it == m_roleNames.constEnd())
+		return QVariant();
+
+	return m_rows.at(index.row()).value(QString::fromUtf8(*it));
+}
+
+
+
+/**
+ * @brief JobListModel::roleNames
+ * @return
+ */
+
+QHash<int, QByteArray> JobListModel::roleNames() const
+{
+	return m_roleNames;
+}
+
+
+
+/**
+ * @brief JobListModel::canFetchMore
+ * @param parent
+ * @return
+ */
+
+bool JobListModel::canFetchMore(const QModelIndex &parent) const
+{
+	if (parent.isValid() || m_fetching)
+		return false;
+
+	return m_rows.size() < m_total;
+}
+
+
+
+/**
+ * @brief JobListModel::fetchMore
+ * @param parent
+ */
+
+void JobListModel::fetchMore(const QModelIndex &parent)
+{
+	if (parent.isValid() || m_fetching)
+		return;
+
+	const int offset = m_rows.size();
+	const int limit = qMin(m_windowSize, m_total-offset);
+
+	if (limit <= 0)
+		return;
+
+	m_fetching = true;
+
+	m_database->jobWindowAsync(offset, limit).then(this, [this, offset, generation = m_generation](const QVariantList &list) {
+		if (generation != m_generation)
+			return;
+
+		m_fetching = false;
+
+		if (list.isEmpty()) {
+			LOG_CWARNING("app") << "Missing rows from offset" << offset;
+			setTotal(offset);
+			return;
+		}
+
+		LOG_CTRACE("app") << "Fetch rows" << offset << "-" << offset+list.size()-1;
+
+		beginInsertRows(QModelIndex(), offset, offset+list.size()-1);
+		m_rows.append(toRows(list));
+		endInsertRows();
+
+		for (int i=offset; i<m_rows.size(); ++i)
+			m_stale.remove(rowId(i));
+
+		emit countChanged();
+
+		refreshVisible();
+	});
+}
+
+
+
+/**
+ * @brief JobListModel::get
+ * @param row
+ * @return
+ */
+
+QVariantMap JobListModel::get(int row) const
+{
+	return m_rows.value(row);
+}
+
+
+
+/**
+ * @brief JobListModel::setVisibleRange
+ * Rows shown by the view: the stale ones are fetched again
+ * @param first
+ * @param last
+ */
+
+void JobListModel::setVisibleRange(int first, int last)
+{
+	m_visibleFirst = first;
+	m_visibleLast = last;
+
+	refreshVisible();
+}
+
+
+
+/**
+ * @brief JobListModel::reload
+ * @param total
+ * @param changed ids of the changed jobs (all rows changed if not set)
+ */
+
+void JobListModel::reload(const int &total, const std::optional<QVector<qint64>> &changed)
+{
+	++m_generation;
+	m_fetching = false;
+
+	if (m_rows.isEmpty()) {
+		reset(total);
+		return;
+	}
+
+	// The fetched rows are matched to the ids of the jobs, no fetch meanwhile
+
+	m_fetching = true;
+
+	m_database->jobIdsAsync().then(this, [this, total, changed, generation = m_generation](const QVector<qint64> &ids) {
+		if (generation != m_generation)
+			return;
+
+		m_fetching = false;
+
+		if (ids.isEmpty()) {
+			reset(total);
+			return;
+		}
+
+		merge(ids, changed);
+
+		// New rows at the end of a view scrolled to the bottom
+
+		if (m_visibleLast >= m_rows.size()-1 && canFetchMore(QModelIndex()))
+			fetchMore(QModelIndex());
+		else
+			refreshVisible();
+	});
+}
+
+
+
+/**
+ * @brief JobListModel::merge
+ * Remove the rows of the deleted jobs, insert (stale) rows for the new jobs between the fetched rows
+ * and mark the changed rows stale. Both the rows and the ids are ordered by id.
+ * @param ids
+ * @param changed
+ */
+
+void JobListModel::merge(const QVector<qint64> &ids, const std::optional<QVector<qint64>> &changed)
+{
+	if (changed) {
+		for (const qint64 &id : *changed)
+			m_stale.insert(id);
+	} else {
+		for (int i=0; i<m_rows.size(); ++i)
+			m_stale.insert(rowId(i));
+	}
+
+	const int count = m_rows.size();
+
+	int row = 0;
+	int next = 0;
+
+	while (row < m_rows.size()) {
+		const qint64 id = rowId(row);
+
+		const int from = next;
+
+		while (next < ids.size() && ids.at(next) < id)
+			++next;
+
+		if (next > from) {
+			beginInsertRows(QModelIndex(), row, row+next-from-1);
+
+			m_rows.insert(row, next-from, QVariantMap());
+
+			for (int i=from; i<next; ++i, ++row) {
+				m_rows[row].insert(QStringLiteral("id"), ids.at(i));
+				m_stale.insert(ids.at(i));
+			}
+
+			endInsertRows();
+		}
+
+		if (next < ids.size() && ids.at(next) == id) {
+			++row;
+			++next;
+			continue;
+		}
+
+		// Deleted jobs up to the next existing one
+
+		int last = row;
+
+		while (last+1 < m_rows.size() && (next >= ids.size() || rowId(last+1) < ids.at(next)))
+			++last;
+
+		beginRemoveRows(QModelIndex(), row, last);
+
+		for (int i=row; i<=last; ++i)
+			m_stale.remove(rowId(i));
+
+		m_rows.remove(row, last-row+1);
+
+		endRemoveRows();
+	}
+
+	LOG_CTRACE("app") << "Merge rows" << count << "->" << m_rows.size() << "stale:" << m_stale.size();
+
+	if (m_rows.size() != count)
+		emit countChanged();
+
+	setTotal(ids.size());
+}
+
+
+
+/**
+ * @brief JobListModel::refreshVisible
+ * Fetch the stale rows of the visible range again
+ */
+
+void JobListModel::refreshVisible()
+{
+	if (m_fetching || m_stale.isEmpty() || m_rows.isEmpty())
+		return;
+
+	const int last = qMin(m_visibleLast, m_rows.size()-1);
+	int first = qMax(m_visibleFirst, 0);
+
+	while (first <= last && !m_stale.contains(rowId(first)))
+		++first;
+
+	if (first > last)
+		return;
+
+	int end = qMin(last, first+m_windowSize-1);
+
+	while (end > first && !m_stale.contains(rowId(end)))
+		--end;
+
+	m_fetching = true;
+
+	m_database->jobWindowAsync(first, end-first+1).then(this, [this, first, generation = m_generation](const QVariantList &list) {
+		if (generation != m_generation)
+			return;
+
+		m_fetching = false;
+
+		const QVector<QVariantMap> &rows = toRows(list);
+
+		int changedFirst = -1;
+		int changedLast = -1;
+
+		for (int i=0; i<rows.size() && first+i<m_rows.size(); ++i) {
+			const qint64 id = rows.at(i).value(QStringLiteral("id")).toLongLong();
+
+			// Written meanwhile: refreshed by the next reload
+
+			if (id != rowId(first+i))
+				continue;
+
+			m_rows[first+i] = rows.at(i);
+			m_stale.remove(id);
+
+			if (changedFirst < 0)
+				changedFirst = first+i;
+
+			changedLast = first+i;
+		}
+
+		if (changedFirst < 0)
+			return;
+
+		LOG_CTRACE("app") << "Refresh rows" << changedFirst << "-" << changedLast;
+
+		emit dataChanged(index(changedFirst), index(changedLast));
+
+		refreshVisible();
+	});
+}
+
+
+
+/**
+ * @brief JobListModel::clear
+ */
+
+void JobListModel::clear()
+{
+	++m_generation;
+	m_fetching = false;
+
+	if (m_rows.isEmpty() && m_total == 0)
+		return;
+
+	reset(0);
+}
+
+
+
+/**
+ * @brief JobListModel::reset
+ * @param total
+ */
+
+void JobListModel::reset(const int &total)
+{
+	beginResetModel();
+	m_rows.clear();
+	m_stale.clear();
+	m_total = total;
+	endResetModel();
+
+	emit countChanged();
+	emit totalChanged();
+}
+
+
+
+/**
+ * @brief JobListModel::toRows
+ * @param list
+ * @return
+ */
+
+QVector<QVariantMap> JobListModel::toRows(const QVariantList &list)
+{
+	QVector<QVariantMap> rows;
+	rows.reserve(list.size());
+
+	for (const QVariant &v : list) {
+		QVariantMap map = v.toMap();
+
+		if (map.value(QStringLiteral("end")).isNull())
+			map.remove(QStringLiteral("end"));
+
+		rows.append(map);
+	}
+
+	return rows;
+}
+
+
+
+/**
+ * @brief JobListModel::total
+ * @return
+ */
+
+int JobListModel::total() const
+{
+	return m_total;
+}
+
+void JobListModel::setTotal(const int &total)
+{
+	if (m_total == total)
+		return;
+	m_total = total;
+	emit totalChanged();
+}
+
+
+
+/**
+ * @brief JobListModel::rowId
+ * @param row
+ * @return
+ */
+
+qint64 JobListModel::rowId(const int &row) const
+{
+	return m_rows.at(row).value(QStringLiteral("id")).toLongLong();
+}
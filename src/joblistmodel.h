@@ -0,0 +1,103 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * joblistmodel.h
+ *
+ * Created on: 2024. 01. 15.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * JobListModel
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOBLISTMODEL_H
+#define JOBLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QSet>
+#include <optional>
+
+class Database;
+
+
+/**
+ * @brief The JobListModel class
+ *
+ * Paged list model for large files: job rows are loaded in windows by fetchMore(). The rows
+ * of a window (with the calculated roles) are computed on the worker thread of the Database
+ * and inserted when ready.
+ *
+ * A reload keeps the fetched rows: rows of deleted or inserted jobs are removed or inserted,
+ * the changed rows are marked stale and only the stale rows of the visible range (set by the
+ * view) are fetched again.
+ */
+
+class JobListModel : public QAbstractListModel
+{
+	Q_OBJECT
+
+	Q_PROPERTY(int count READ rowCount NOTIFY countChanged FINAL)
+	Q_PROPERTY(int total READ total NOTIFY totalChanged FINAL)
+
+public:
+	explicit JobListModel(Database *database);
+	virtual ~JobListModel();
+
+	int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+	QHash<int, QByteArray> roleNames() const override;
+
+	bool canFetchMore(const QModelIndex &parent) const override;
+	void fetchMore(const QModelIndex &parent) override;
+
+	Q_INVOKABLE QVariantMap get(int row) const;
+	Q_INVOKABLE void setVisibleRange(int first, int last);
+
+	void reload(const int &total, const std::optional<QVector<qint64>> &changed = std::nullopt);
+	void clear();
+
+	int total() const;
+
+	static const int m_windowSize;
+
+signals:
+	void countChanged();
+	void totalChanged();
+
+private:
+	static QVector<QVariantMap> toRows(const QVariantList &list);
+	void reset(const int &total);
+	void merge(const QVector<qint64> &ids, const std::optional<QVector<qint64>> &changed);
+	void refreshVisible();
+	void setTotal(const int &total);
+	qint64 rowId(const int &row) const;
+
+	Database *const m_database;
+	QHash<int, QByteArray> m_roleNames;
+	QVector<QVariantMap> m_rows;
+	QSet<qint64> m_stale;
+	int m_total = 0;
+	int m_visibleFirst = 0;
+	int m_visibleLast = -1;
+
+	// Results of the windows requested before the last reload are dropped
+
+	quint64 m_generation = 0;
+	bool m_fetching = false;
+};
+
+#endif // JOBLISTMODEL_H
@@ -0,0 +1,518 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * jobproxymodel.cpp
+ *
+ * Created on: 2024. 01. 17.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * JobProxyModel
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "jobproxymodel.h"
+#include "application.h"
+#include "logfilter.h"
+#include <QCollator>
+#include <limits>
+
+
+/**
+ * @brief JobProxyModel::JobProxyModel
+ * @param parent
+ */
+
+JobProxyModel::JobProxyModel(QObject *parent)
+	: QSortFilterProxyModel(parent)
+{
+	std::fill(std::begin(m_roles), std::end(m_roles), -1);
+
+	setDynamicSortFilter(true);
+	sort(0, Qt::AscendingOrder);
+
+	connect(this, &QAbstractItemModel::rowsInserted, this, &JobProxyModel::countChanged);
+	connect(this, &QAbstractItemModel::rowsRemoved, this, &JobProxyModel::countChanged);
+	connect(this, &QAbstractItemModel::modelReset, this, &JobProxyModel::countChanged);
+	connect(this, &QAbstractItemModel::layoutChanged, this, &JobProxyModel::countChanged);
+}
+
+
+/**
+ * @brief JobProxyModel::~JobProxyModel
+ */
+
+JobProxyModel::~JobProxyModel()
+{
+
+}
+
+
+
+/**
+ * @brief JobProxyModel::setSourceModel
+ * @param sourceModel
+ */
+
+void JobProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+	if (QAbstractItemModel *prev = this->sourceModel())
+		disconnect(prev, nullptr, this, nullptr);
+
+	// Cached keys must be invalidated before QSortFilterProxyModel handles the change,
+	// so these connections are made before the base class connects its own handlers
+
+	if (sourceModel) {
+		connect(sourceModel, &QAbstractItemModel::dataChanged, this, &JobProxyModel::invalidateRows);
+		connect(sourceModel, &QAbstractItemModel::rowsInserted, this, [this, sourceModel](const QModelIndex &parent, int first, int last) {
+			invalidateRows(sourceModel->index(first, 0, parent), sourceModel->index(last, 0, parent));
+		});
+		connect(sourceModel, &QAbstractItemModel::modelReset, this, [this]() {
+			updateRoles();
+			invalidateKeys();
+		});
+		connect(sourceModel, &QAbstractItemModel::layoutChanged, this, &JobProxyModel::invalidateKeys);
+	}
+
+	QSortFilterProxyModel::setSourceModel(sourceModel);
+
+	updateRoles();
+	invalidateKeys();
+}
+
+
+
+/**
+ * @brief JobProxyModel::clearFilters
+ */
+
+void JobProxyModel::clearFilters()
+{
+	setFilterType(QString());
+	setFilterFrom(QDate());
+	setFilterTo(QDate());
+	setFilterOverlap(false);
+	setFilterText(QString());
+}
+
+
+
+/**
+ * @brief JobProxyModel::setTextSearch
+ * @param func
+ */
+
+void JobProxyModel::setTextSearch(const std::function<QFuture<QVariantList> (const QString &)> &func)
+{
+	m_textSearch = func;
+	refreshTextMatch();
+}
+
+
+
+/**
+ * @brief JobProxyModel::setAsOf
+ * @param asOf
+ */
+
+void JobProxyModel::setAsOf(const QDate &asOf)
+{
+	if (m_asOf == asOf)
+		return;
+
+	m_asOf = asOf;
+
+	if (m_filterFrom.isValid() || m_filterTo.isValid())
+		invalidateFilter();
+}
+
+
+
+/**
+ * @brief JobProxyModel::refreshTextMatch
+ * Query the ids matching the text filter, the filter is applied when they arrive
+ * (results of an outdated query are dropped)
+ */
+
+void JobProxyModel::refreshTextMatch()
+{
+	const quint64 generation = ++m_textGeneration;
+
+	if (!m_textSearch || m_filterText.isEmpty()) {
+		if (!m_textMatch.isEmpty()) {
+			m_textMatch.clear();
+			invalidateFilter();
+		}
+		return;
+	}
+
+	std::invoke(m_textSearch, m_filterText).then(this, [this, generation](const QVariantList &list) {
+		if (generation != m_textGeneration)
+			return;
+
+		m_textMatch.clear();
+
+		for (const QVariant &v : list)
+			m_textMatch.insert(v.toLongLong());
+
+		invalidateFilter();
+	});
+}
+
+
+
+/**
+ * @brief JobProxyModel::filterAcceptsRow
+ * @param source_row
+ * @param source_parent
+ * @return
+ */
+
+bool JobProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
+{
+	if (source_parent.isValid())
+		return false;
+
+	if (m_filterOverlap && !sourceData(source_row, RoleOverlap).toBool())
+		return false;
+
+	if (!m_filterType.isEmpty() && sourceData(source_row, RoleType).toString() != m_filterType)
+		return false;
+
+	if (m_filterFrom.isValid() || m_filterTo.isValid()) {
+		const QDate &start = sourceData(source_row, RoleStart).toDate();
+		QDate end = sourceData(source_row, RoleEnd).toDate();
+
+		if (end.isNull())
+			end = m_asOf.isValid() ? m_asOf : QDate::currentDate();
+
+		if (m_filterFrom.isValid() && end < m_filterFrom)
+			return false;
+
+		if (m_filterTo.isValid() && start > m_filterTo)
+			return false;
+	}
+
+	if (!m_filterText.isEmpty()) {
+		if (m_textSearch) {
+			if (!m_textMatch.contains(sourceData(source_row, RoleId).toLongLong()))
+				return false;
+		} else if (!sourceData(source_row, RoleName).toString().contains(m_filterText, Qt::CaseInsensitive) &&
+				   !sourceData(source_row, RoleMaster).toString().contains(m_filterText, Qt::CaseInsensitive)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+
+/**
+ * @brief JobProxyModel::lessThan
+ * @param source_left
+ * @param source_right
+ * @return
+ */
+
+bool JobProxyModel::lessThan(const QModelIndex &source_left, const QModelIndex &source_right) const
+{
+	const qint64 left = sortKey(source_left.row());
+	const qint64 right = sortKey(source_right.row());
+
+	if (left != right)
+		return left < right;
+
+	return sourceData(source_left.row(), RoleId).toLongLong() < sourceData(source_right.row(), RoleId).toLongLong();
+}
+
+
+
+/**
+ * @brief JobProxyModel::updateRoles
+ */
+
+void JobProxyModel::updateRoles()
+{
+	std::fill(std::begin(m_roles), std::end(m_roles), -1);
+
+	if (!sourceModel())
+		return;
+
+	static const QHash<QByteArray, Role> names = {
+		{ QByteArrayLiteral("id"), RoleId },
+		{ QByteArrayLiteral("start"), RoleStart },
+		{ QByteArrayLiteral("end"), RoleEnd },
+		{ QByteArrayLiteral("name"), RoleName },
+		{ QByteArrayLiteral("master"), RoleMaster },
+		{ QByteArrayLiteral("type"), RoleType },
+		{ QByteArrayLiteral("overlap"), RoleOverlap },
+		{ QByteArrayLiteral("durationYears"), RoleDurationYears },
+		{ QByteArrayLiteral("durationDays"), RoleDurationDays },
+	};
+
+	const QHash<int, QByteArray> &roles = sourceModel()->roleNames();
+
+	for (auto it = roles.constBegin(); it != roles.constEnd(); ++it) {
+		if (const auto n = names.constFind(it.value()); n != names.constEnd())
+			m_roles[*n] = it.key();
+	}
+}
+
+
+
+/**
+ * @brief JobProxyModel::invalidateKeys
+ */
+
+void JobProxyModel::invalidateKeys()
+{
+	m_keyCache.clear();
+	m_employerRank.clear();
+}
+
+
+
+/**
+ * @brief JobProxyModel::invalidateRows
+ * @param topLeft
+ * @param bottomRight
+ */
+
+void JobProxyModel::invalidateRows(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+	if (!topLeft.isValid() || !bottomRight.isValid())
+		return;
+
+	for (int i=topLeft.row(); i<=bottomRight.row(); ++i) {
+		m_keyCache.remove(sourceData(i, RoleId).toLongLong());
+
+		// A new employer shifts the ranks of the others
+
+		if (m_sortField == SortEmployer && !m_employerRank.isEmpty() &&
+				!m_employerRank.contains(sourceData(i, RoleMaster).toString()))
+			invalidateKeys();
+	}
+}
+
+
+
+/**
+ * @brief JobProxyModel::sortKey
+ * @param sourceRow
+ * @return
+ */
+
+qint64 JobProxyModel::sortKey(const int &sourceRow) const
+{
+	const qint64 id = sourceData(sourceRow, RoleId).toLongLong();
+
+	if (m_sortField == SortId)
+		return id;
+
+	if (const auto it = m_keyCache.constFind(id); it != m_keyCache.constEnd())
+		return *it;
+
+	qint64 key = 0;
+
+	switch (m_sortField) {
+		case SortId:
+			key = id;
+			break;
+
+		case SortStart:
+			key = sourceData(sourceRow, RoleStart).toDate().toJulianDay();
+			break;
+
+		case SortEnd:
+		{
+			const QDate &end = sourceData(sourceRow, RoleEnd).toDate();
+			key = end.isNull() ? std::numeric_limits<qint64>::max() : end.toJulianDay();
+			break;
+		}
+
+		case SortDuration:
+			key = sourceData(sourceRow, RoleDurationYears).toLongLong() * 1000
+				  + sourceData(sourceRow, RoleDurationDays).toLongLong();
+			break;
+
+		case SortType:
+		{
+			const QString &type = sourceData(sourceRow, RoleType).toString();
+			const qint64 idx = Application::jobTypeList().indexOf(type);
+			key = idx == -1 ? Application::jobTypeList().size() : idx;
+			break;
+		}
+
+		case SortEmployer:
+			key = employerRank(sourceData(sourceRow, RoleMaster).toString());
+			break;
+	}
+
+	m_keyCache.insert(id, key);
+
+	return key;
+}
+
+
+
+/**
+ * @brief JobProxyModel::employerRank
+ * @param employer
+ * @return
+ */
+
+qint64 JobProxyModel::employerRank(const QString &employer) const
+{
+	if (m_employerRank.isEmpty() && sourceModel()) {
+		QSet<QString> employers;
+
+		for (int i=0; i<sourceModel()->rowCount(); ++i)
+			employers.insert(sourceData(i, RoleMaster).toString());
+
+		QStringList list(employers.cbegin(), employers.cend());
+
+		QCollator collator;
+		collator.setCaseSensitivity(Qt::CaseInsensitive);
+
+		std::sort(list.begin(), list.end(), collator);
+
+		for (int i=0; i<list.size(); ++i)
+			m_employerRank.insert(list.at(i), i);
+	}
+
+	return m_employerRank.value(employer, m_employerRank.size());
+}
+
+
+
+/**
+ * @brief JobProxyModel::sourceData
+ * @param sourceRow
+ * @param role
+ * @return
+ */
+
+QVariant JobProxyModel::sourceData(const int &sourceRow, const int &role) const
+{
+	if (!sourceModel() || m_roles[role] == -1)
+		return QVariant();
+
+	return sourceModel()->index(sourceRow, 0).data(m_roles[role]);
+}
+
+
+
+/**
+ * @brief JobProxyModel::sortField
+ * @return
+ */
+
+JobProxyModel::SortField JobProxyModel::sortField() const
+{
+	return m_sortField;
+}
+
+void JobProxyModel::setSortField(const SortField &newSortField)
+{
+	if (m_sortField == newSortField)
+		return;
+	m_sortField = newSortField;
+	invalidateKeys();
+	emit sortFieldChanged();
+	invalidate();
+}
+
+void JobProxyModel::setSortOrder(const Qt::SortOrder &newSortOrder)
+{
+	if (sortOrder() == newSortOrder)
+		return;
+	sort(0, newSortOrder);
+	emit sortOrderChanged();
+}
+
+
+QString JobProxyModel::filterType() const
+{
+	return m_filterType;
+}
+
+void JobProxyModel::setFilterType(const QString &newFilterType)
+{
+	if (m_filterType == newFilterType)
+		return;
+	m_filterType = newFilterType;
+	emit filterTypeChanged();
+	invalidateFilter();
+}
+
+QDate JobProxyModel::filterFrom() const
+{
+	return m_filterFrom;
+}
+
+void JobProxyModel::setFilterFrom(const QDate &newFilterFrom)
+{
+	if (m_filterFrom == newFilterFrom)
+		return;
+	m_filterFrom = newFilterFrom;
+	emit filterFromChanged();
+	invalidateFilter();
+}
+
+QDate JobProxyModel::filterTo() const
+{
+	return m_filterTo;
+}
+
+void JobProxyModel::setFilterTo(const QDate &newFilterTo)
+{
+	if (m_filterTo == newFilterTo)
+		return;
+	m_filterTo = newFilterTo;
+	emit filterToChanged();
+	invalidateFilter();
+}
+
+bool JobProxyModel::filterOverlap() const
+{
+	return m_filterOverlap;
+}
+
+void JobProxyModel::setFilterOverlap(bool newFilterOverlap)
+{
+	if (m_filterOverlap == newFilterOverlap)
+		return;
+	m_filterOverlap = newFilterOverlap;
+	emit filterOverlapChanged();
+	invalidateFilter();
+}
+
+QString JobProxyModel::filterText() const
+{
+	return m_filterText;
+}
+
+void JobProxyModel::setFilterText(const QString &newFilterText)
+{
+	if (m_filterText == newFilterText)
+		return;
+	m_filterText = newFilterText;
+	m_textMatch.clear();
+	emit filterTextChanged();
+	refreshTextMatch();
+	invalidateFilter();
+}
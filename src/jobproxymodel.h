@@ -0,0 +1,161 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * jobproxymodel.h
+ *
+ * Created on: 2024. 01. 17.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * JobProxyModel
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef JOBPROXYMODEL_H
+#define JOBPROXYMODEL_H
+
+#include <QSortFilterProxyModel>
+#include <QDate>
+#include <QFuture>
+#include <QSet>
+#include <QtQml/qqmlregistration.h>
+#include <functional>
+
+
+/**
+ * @brief The JobProxyModel class
+ *
+ * Sort and filter proxy over the job list. Sort keys are integers computed once per row
+ * (cached by job id) and invalidated only for the rows changed in the source model,
+ * so dynamic sorting re-sorts only the affected rows.
+ * The full-text matches are queried asynchronously: on filter change and once per sync
+ * (refreshTextMatch()), never per changed row.
+ */
+
+class JobProxyModel : public QSortFilterProxyModel
+{
+	Q_OBJECT
+	QML_ELEMENT
+	QML_UNCREATABLE("JobProxyModel is uncreatable")
+
+	Q_PROPERTY(SortField sortField READ sortField WRITE setSortField NOTIFY sortFieldChanged FINAL)
+	Q_PROPERTY(Qt::SortOrder sortOrder READ sortOrder WRITE setSortOrder NOTIFY sortOrderChanged FINAL)
+	Q_PROPERTY(QString filterType READ filterType WRITE setFilterType NOTIFY filterTypeChanged FINAL)
+	Q_PROPERTY(QDate filterFrom READ filterFrom WRITE setFilterFrom NOTIFY filterFromChanged FINAL)
+	Q_PROPERTY(QDate filterTo READ filterTo WRITE setFilterTo NOTIFY filterToChanged FINAL)
+	Q_PROPERTY(bool filterOverlap READ filterOverlap WRITE setFilterOverlap NOTIFY filterOverlapChanged FINAL)
+	Q_PROPERTY(QString filterText READ filterText WRITE setFilterText NOTIFY filterTextChanged FINAL)
+	Q_PROPERTY(int count READ count NOTIFY countChanged FINAL)
+
+public:
+	explicit JobProxyModel(QObject *parent = nullptr);
+	virtual ~JobProxyModel();
+
+	enum SortField {
+		SortId = 0,
+		SortStart,
+		SortEnd,
+		SortDuration,
+		SortType,
+		SortEmployer
+	};
+
+	Q_ENUM(SortField)
+
+	void setSourceModel(QAbstractItemModel *sourceModel) override;
+
+	Q_INVOKABLE void clearFilters();
+
+	void setTextSearch(const std::function<QFuture<QVariantList>(const QString &)> &func);
+	void setAsOf(const QDate &asOf);
+	void refreshTextMatch();
+
+	int count() const { return rowCount(); }
+
+	SortField sortField() const;
+	void setSortField(const SortField &newSortField);
+
+	Qt::SortOrder sortOrder() const { return QSortFilterProxyModel::sortOrder(); }
+	void setSortOrder(const Qt::SortOrder &newSortOrder);
+
+	QString filterType() const;
+	void setFilterType(const QString &newFilterType);
+
+	QDate filterFrom() const;
+	void setFilterFrom(const QDate &newFilterFrom);
+
+	QDate filterTo() const;
+	void setFilterTo(const QDate &newFilterTo);
+
+	bool filterOverlap() const;
+	void setFilterOverlap(bool newFilterOverlap);
+
+	QString filterText() const;
+	void setFilterText(const QString &newFilterText);
+
+signals:
+	void sortFieldChanged();
+	void sortOrderChanged();
+	void filterTypeChanged();
+	void filterFromChanged();
+	void filterToChanged();
+	void filterOverlapChanged();
+	void filterTextChanged();
+	void countChanged();
+
+protected:
+	bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
+	bool lessThan(const QModelIndex &source_left, const QModelIndex &source_right) const override;
+
+private:
+	void updateRoles();
+	void invalidateKeys();
+	void invalidateRows(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+	qint64 sortKey(const int &sourceRow) const;
+	qint64 employerRank(const QString &employer) const;
+	QVariant sourceData(const int &sourceRow, const int &role) const;
+
+	enum Role {
+		RoleId = 0,
+		RoleStart,
+		RoleEnd,
+		RoleName,
+		RoleMaster,
+		RoleType,
+		RoleOverlap,
+		RoleDurationYears,
+		RoleDurationDays,
+		RoleCount
+	};
+
+	int m_roles[RoleCount];
+
+	SortField m_sortField = SortId;
+	QString m_filterType;
+	QDate m_filterFrom;
+	QDate m_filterTo;
+	QDate m_asOf;
+	bool m_filterOverlap = false;
+	QString m_filterText;
+	std::function<QFuture<QVariantList>(const QString &)> m_textSearch;
+	QSet<qint64> m_textMatch;
+	quint64 m_textGeneration = 0;
+
+	mutable QHash<qint64, qint64> m_keyCache;
+	mutable QHash<QString, qint64> m_employerRank;
+};
+
+#endif // JOBPROXYMODEL_H
@@ -0,0 +1,326 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * jsonstreamwriter.cpp
+ *
+ * Created on: 2024. 01. 08.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * JsonStreamWriter
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "jsonstreamwriter.h"
+#include "logfilter.h"
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QLocale>
+#include <limits>
+
+
+/**
+ * @brief JsonStreamWriter::JsonStreamWriter
+ * @param device
+ * @param format
+ */
+
+JsonStreamWriter::JsonStreamWriter(QIODevice *device, const QJsonDocument::JsonFormat &format)
+	: m_device(device)
+	, m_format(format)
+{
+	Q_ASSERT(m_device);
+
+	if (!m_device->isWritable()) {
+		LOG_CWARNING("utils") << "JSON stream device isn't writable";
+		m_error = true;
+	}
+}
+
+
+/**
+ * @brief JsonStreamWriter::~JsonStreamWriter
+ */
+
+JsonStreamWriter::~JsonStreamWriter()
+{
+	if (!m_stack.isEmpty())
+		LOG_CWARNING("utils") << "Unterminated JSON stream";
+}
+
+
+
+/**
+ * @brief JsonStreamWriter::beginObject
+ * @return
+ */
+
+JsonStreamWriter &JsonStreamWriter::beginObject()
+{
+	beginValue();
+	write(QByteArrayLiteral("{"));
+	m_stack.append(Level{false, 0});
+	return *this;
+}
+
+
+/**
+ * @brief JsonStreamWriter::endObject
+ * @return
+ */
+
+JsonStreamWriter &JsonStreamWriter::endObject()
+{
+	if (m_stack.isEmpty() || m_stack.last().isArray) {
+		LOG_CERROR("utils") << "Invalid JSON stream: unexpected end of object";
+		m_error = true;
+		return *this;
+	}
+
+	const Level level = m_stack.takeLast();
+
+	if (level.count)
+		writeNewLine();
+
+	write(QByteArrayLiteral("}"));
+
+	if (m_stack.isEmpty() && m_format == QJsonDocument::Indented)
+		write(QByteArrayLiteral("\n"));
+
+	return *this;
+}
+
+
+/**
+ * @brief JsonStreamWriter::beginArray
+ * @return
+ */
+
+JsonStreamWriter &JsonStreamWriter::beginArray()
+{
+	beginValue();
+	write(QByteArrayLiteral("["));
+	m_stack.append(Level{true, 0});
+	return *this;
+}
+
+
+/**
+ * @brief JsonStreamWriter::endArray
+ * @return
+ */
+
+JsonStreamWriter &JsonStreamWriter::endArray()
+{
+	if (m_stack.isEmpty() || !m_stack.last().isArray) {
+		LOG_CERROR("utils") << "Invalid JSON stream: unexpected end of array";
+		m_error = true;
+		return *this;
+	}
+
+	const Level level = m_stack.takeLast();
+
+	if (level.count)
+		writeNewLine();
+
+	write(QByteArrayLiteral("]"));
+
+	if (m_stack.isEmpty() && m_format == QJsonDocument::Indented)
+		write(QByteArrayLiteral("\n"));
+
+	return *this;
+}
+
+
+
+/**
+ * @brief JsonStreamWriter::key
+ * @param key
+ * @return
+ */
+
+JsonStreamWriter &JsonStreamWriter::key(const QString &key)
+{
+	if (m_stack.isEmpty() || m_stack.last().isArray || m_afterKey) {
+		LOG_CERROR("utils") << "Invalid JSON stream: unexpected key" << key;
+		m_error = true;
+		return *this;
+	}
+
+	Level &level = m_stack.last();
+
+	if (level.count++)
+		write(QByteArrayLiteral(","));
+
+	writeNewLine();
+	writeString(key);
+	write(m_format == QJsonDocument::Indented ? QByteArrayLiteral(": ") : QByteArrayLiteral(":"));
+
+	m_afterKey = true;
+
+	return *this;
+}
+
+
+
+/**
+ * @brief JsonStreamWriter::value
+ * @param value
+ * @return
+ */
+
+JsonStreamWriter &JsonStreamWriter::value(const QJsonValue &value)
+{
+	beginValue();
+
+	switch (value.type()) {
+		case QJsonValue::Null:
+		case QJsonValue::Undefined:
+			write(QByteArrayLiteral("null"));
+			break;
+
+		case QJsonValue::Bool:
+			write(value.toBool() ? QByteArrayLiteral("true") : QByteArrayLiteral("false"));
+			break;
+
+		case QJsonValue::Double:
+		{
+			static constexpr qint64 invalid = std::numeric_limits<qint64>::min();
+
+			if (const qint64 i = value.toInteger(invalid); i != invalid)
+				write(QByteArray::number(i));
+			else if (const double d = value.toDouble(); qIsFinite(d))
+				write(QByteArray::number(d, 'g', QLocale::FloatingPointShortest));
+			else
+				write(QByteArrayLiteral("null"));
+		}
+			break;
+
+		case QJsonValue::String:
+			writeString(value.toString());
+			break;
+
+		case QJsonValue::Array:
+			write(QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact));
+			break;
+
+		case QJsonValue::Object:
+			write(QJsonDocument(value.toObject()).toJson(QJsonDocument::Compact));
+			break;
+	}
+
+	return *this;
+}
+
+
+
+/**
+ * @brief JsonStreamWriter::beginValue
+ */
+
+void JsonStreamWriter::beginValue()
+{
+	if (m_afterKey) {
+		m_afterKey = false;
+		return;
+	}
+
+	if (m_stack.isEmpty())
+		return;
+
+	Level &level = m_stack.last();
+
+	if (!level.isArray) {
+		LOG_CERROR("utils") << "Invalid JSON stream: missing key";
+		m_error = true;
+		return;
+	}
+
+	if (level.count++)
+		write(QByteArrayLiteral(","));
+
+	writeNewLine();
+}
+
+
+
+/**
+ * @brief JsonStreamWriter::writeNewLine
+ */
+
+void JsonStreamWriter::writeNewLine()
+{
+	if (m_format != QJsonDocument::Indented)
+		return;
+
+	write(QByteArrayLiteral("\n"));
+	write(QByteArray(4*m_stack.size(), ' '));
+}
+
+
+
+/**
+ * @brief JsonStreamWriter::write
+ * @param data
+ */
+
+void JsonStreamWriter::write(const QByteArray &data)
+{
+	if (m_error)
+		return;
+
+	if (m_device->write(data) != data.size()) {
+		LOG_CERROR("utils") << "JSON stream write error:" << qPrintable(m_device->errorString());
+		m_error = true;
+	}
+}
+
+
+
+/**
+ * @brief JsonStreamWriter::writeString
+ * @param str
+ */
+
+void JsonStreamWriter::writeString(const QString &str)
+{
+	const QByteArray &utf8 = str.toUtf8();
+
+	QByteArray out;
+	out.reserve(utf8.size()+2);
+	out.append('"');
+
+	for (const char c : utf8) {
+		switch (c) {
+			case '"':	out.append("\\\""); break;
+			case '\\':	out.append("\\\\"); break;
+			case '\b':	out.append("\\b"); break;
+			case '\f':	out.append("\\f"); break;
+			case '\n':	out.append("\\n"); break;
+			case '\r':	out.append("\\r"); break;
+			case '\t':	out.append("\\t"); break;
+			default:
+				if (static_cast<uchar>(c) < 0x20)
+					out.append("\\u00").append(QByteArray::number(static_cast<uchar>(c), 16).rightJustified(2, '0'));
+				else
+					out.append(c);
+		}
+	}
+
+	out.append('"');
+
+	write(out);
+}
@@ -0,0 +1,77 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * jsonstreamwriter.h
+ *
+ * Created on: 2024. 01. 08.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * JsonStreamWriter
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef JSONSTREAMWRITER_H
+#define JSONSTREAMWRITER_H
+
+#include <QIODevice>
+#include <QJsonDocument>
+#include <QJsonValue>
+
+
+/**
+ * @brief The JsonStreamWriter class
+ *
+ * Writes a JSON document directly to a QIODevice without building
+ * the whole QJsonObject/QJsonDocument tree in memory.
+ */
+
+class JsonStreamWriter
+{
+public:
+	explicit JsonStreamWriter(QIODevice *device, const QJsonDocument::JsonFormat &format = QJsonDocument::Indented);
+	~JsonStreamWriter();
+
+	JsonStreamWriter &beginObject();
+	JsonStreamWriter &endObject();
+	JsonStreamWriter &beginArray();
+	JsonStreamWriter &endArray();
+
+	JsonStreamWriter &key(const QString &key);
+	JsonStreamWriter &value(const QJsonValue &value);
+	JsonStreamWriter &value(const QString &key, const QJsonValue &v) { return this->key(key).value(v); }
+
+	bool hasError() const { return m_error; }
+
+private:
+	struct Level {
+		bool isArray = false;
+		int count = 0;
+	};
+
+	void beginValue();
+	void writeNewLine();
+	void write(const QByteArray &data);
+	void writeString(const QString &str);
+
+	QIODevice *const m_device;
+	const QJsonDocument::JsonFormat m_format;
+	QVector<Level> m_stack;
+	bool m_afterKey = false;
+	bool m_error = false;
+};
+
+#endif // JSONSTREAMWRITER_H
@@ -0,0 +1,542 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * jubileescheduler.cpp
+ *
+ * Created on: 2024. 01. 18.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * JubileeScheduler
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "jubileescheduler.h"
+#include "database.h"
+#include "databasemanager.h"
+#include "logfilter.h"
+#include "utils_.h"
+#include "xlsxdocument.h"
+#include <QBuffer>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QPdfWriter>
+#include <QTextDocument>
+#include <QJsonArray>
+#include <QSqlQuery>
+#include <querybuilder.hpp>
+
+#if QT_CONFIG(thread) && !defined(NO_LAMBDA_THREAD)
+#include <QtConcurrent>
+#endif
+
+
+/**
+ * @brief JubileeScheduler::JubileeScheduler
+ * @param parent
+ */
+
+JubileeScheduler::JubileeScheduler(QObject *parent)
+	: QObject{parent}
+{
+
+}
+
+
+/**
+ * @brief JubileeScheduler::~JubileeScheduler
+ */
+
+JubileeScheduler::~JubileeScheduler()
+{
+
+}
+
+
+
+/**
+ * @brief JubileeScheduler::Entry::operator <
+ * @param other
+ * @return
+ */
+
+bool JubileeScheduler::Entry::operator<(const Entry &other) const
+{
+	if (date != other.date)
+		return date < other.date;
+
+	if (title != other.title)
+		return title < other.title;
+
+	return file < other.file;
+}
+
+
+
+/**
+ * @brief JubileeScheduler::scan
+ * @param path
+ * @param from
+ * @param months
+ * @return
+ */
+
+QFuture<bool> JubileeScheduler::scan(const QString &path, const QDate &from, const int &months)
+{
+	if (!QFileInfo::exists(path)) {
+		LOG_CWARNING("app") << "Path doesn't exists:" << qPrintable(path);
+		return QtFuture::makeReadyFuture(false);
+	}
+
+	return scan(fileList(path), from, months);
+}
+
+
+
+/**
+ * @brief JubileeScheduler::scan
+ * @param files
+ * @param from
+ * @param months
+ * @return
+ */
+
+QFuture<bool> JubileeScheduler::scan(const QStringList &files, const QDate &from, const int &months)
+{
+	if (!from.isValid() || months <= 0) {
+		LOG_CWARNING("app") << "Invalid jubilee interval";
+		return QtFuture::makeReadyFuture(false);
+	}
+
+	if (m_running) {
+		LOG_CWARNING("app") << "Jubilee scan already running";
+		return QtFuture::makeReadyFuture(false);
+	}
+
+	m_from = from;
+	m_to = from.addMonths(months);
+
+	// Only new or modified files (or files evaluated for another date) are processed
+
+	QStringList changed;
+	QHash<QString, CacheItem> cache;
+
+	for (const QString &f : files) {
+		const QFileInfo info(f);
+		const QString &path = info.absoluteFilePath();
+
+		if (const auto it = m_cache.constFind(path); it != m_cache.constEnd() &&
+				it->modified == info.lastModified() && it->size == info.size() && it->from == from) {
+			cache.insert(path, *it);
+			continue;
+		}
+
+		CacheItem item;
+		item.modified = info.lastModified();
+		item.size = info.size();
+		item.from = from;
+		cache.insert(path, item);
+
+		changed.append(path);
+	}
+
+	const auto func = [from](const QString &file) { return evaluate(file, from); };
+
+#if QT_CONFIG(thread) && !defined(NO_LAMBDA_THREAD)
+	m_running = true;
+
+	return QtConcurrent::mapped(changed, func)
+			.then(this, [this, changed, cache](QFuture<std::optional<Entry>> future) mutable {
+		const QList<std::optional<Entry>> &results = future.results();
+
+		for (int i=0; i<changed.size() && i<results.size(); ++i)
+			cache[changed.at(i)].entry = results.at(i);
+
+		m_running = false;
+
+		finish(cache, changed.size());
+
+		return true;
+	});
+#else
+	for (const QString &f : std::as_const(changed))
+		cache[f].entry = func(f);
+
+	finish(cache, changed.size());
+
+	return QtFuture::makeReadyFuture(true);
+#endif
+}
+
+
+
+/**
+ * @brief JubileeScheduler::finish
+ * Store the cache and collect the calendar
+ * @param cache
+ * @param evaluated
+ */
+
+void JubileeScheduler::finish(const QHash<QString, CacheItem> &cache, const int &evaluated)
+{
+	m_cache = cache;
+	m_evaluated = evaluated;
+
+	LOG_CDEBUG("app") << "Jubilee scan:" << m_cache.size() << "files," << m_evaluated << "evaluated";
+
+	m_calendar.clear();
+
+	for (const CacheItem &item : std::as_const(m_cache)) {
+		if (item.entry && item.entry->date >= m_from && item.entry->date <= m_to)
+			m_calendar.append(*item.entry);
+	}
+
+	std::sort(m_calendar.begin(), m_calendar.end());
+}
+
+
+
+/**
+ * @brief JubileeScheduler::clearCache
+ */
+
+void JubileeScheduler::clearCache()
+{
+	m_cache.clear();
+}
+
+
+
+
+/**
+ * @brief JubileeScheduler::directory
+ * @param path (directory or catalog file)
+ * @return directory of the files of the path
+ */
+
+QString JubileeScheduler::directory(const QString &path)
+{
+	const QFileInfo info(path);
+
+	return info.isDir() ? info.absoluteFilePath() : info.absolutePath();
+}
+
+
+
+/**
+ * @brief JubileeScheduler::fileList
+ * @param path (directory or catalog file with one path per line)
+ * @return
+ */
+
+QStringList JubileeScheduler::fileList(const QString &path)
+{
+	const QFileInfo info(path);
+
+	QStringList list;
+
+	if (info.isDir()) {
+		const QDir dir(path);
+
+		for (const QString &f : dir.entryList({QStringLiteral("*.json")}, QDir::Files | QDir::Readable, QDir::Name))
+			list.append(dir.absoluteFilePath(f));
+
+		return list;
+	}
+
+	const auto &content = Utils::fileContent(path);
+
+	if (!content) {
+		LOG_CWARNING("app") << "Can't read catalog:" << qPrintable(path);
+		return list;
+	}
+
+	const QDir dir = info.absoluteDir();
+
+	for (const QString &line : QString::fromUtf8(*content).split(QChar('\n'), Qt::SkipEmptyParts)) {
+		const QString &f = line.trimmed();
+
+		if (!f.isEmpty() && !f.startsWith(QChar('#')))
+			list.append(dir.absoluteFilePath(f));
+	}
+
+	return list;
+}
+
+
+
+/**
+ * @brief JubileeScheduler::evaluate
+ * @param file
+ * @param from
+ * @return
+ */
+
+std::optional<JubileeScheduler::Entry> JubileeScheduler::evaluate(const QString &file, const QDate &from)
+{
+	const auto &content = Utils::fileContent(file);
+
+	if (!content) {
+		LOG_CWARNING("app") << "Can't read file:" << qPrintable(file);
+		return std::nullopt;
+	}
+
+	QJsonParseError error;
+	const QJsonDocument &doc = QJsonDocument::fromJson(*content, &error);
+
+	if (error.error != QJsonParseError::NoError) {
+		LOG_CWARNING("app") << "Invalid JSON:" << qPrintable(file) << error.errorString();
+		return std::nullopt;
+	}
+
+	const QJsonObject &json = doc.object();
+
+	if (json.value(QStringLiteral("_type")).toString() != QStringLiteral("TimeCalculator")) {
+		LOG_CWARNING("app") << "Invalid JSON:" << qPrintable(file);
+		return std::nullopt;
+	}
+
+	// Every file gets its own bare connection, so the workers don't share anything
+
+	const QString &name = DatabaseManager::uniqueName(QStringLiteral("jubilee"));
+	QVector<QVariantMap> totals;
+
+	{
+		QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), name);
+		db.setDatabaseName(QStringLiteral(":memory:"));
+
+		if (db.open() && load(db, json))
+			totals = Database::totalsSeries(db, {from},
+											Database::cutoffDate(json.value(QStringLiteral("prestigeCalculationTime")).toInt()));
+		else
+			LOG_CWARNING("app") << "Can't load file:" << qPrintable(file);
+
+		db.close();
+	}
+
+	QSqlDatabase::removeDatabase(name);
+
+	if (totals.isEmpty())
+		return std::nullopt;
+
+	Entry e;
+	e.file = file;
+	e.title = json.value(QStringLiteral("title")).toString();
+	e.date = totals.first().value(QStringLiteral("nextPrestige")).toDate();
+	e.years = totals.first().value(QStringLiteral("nextPrestigeYears")).toInt();
+
+	if (e.years <= 0 || !e.date.isValid())
+		return std::nullopt;
+
+	return e;
+}
+
+
+
+/**
+ * @brief JubileeScheduler::load
+ * Load the columns of the jobs and calculations used by Database::totalsSeries()
+ * @param db
+ * @param json
+ * @return
+ */
+
+bool JubileeScheduler::load(QSqlDatabase &db, const QJsonObject &json)
+{
+	if (!QueryBuilder::q(db).addQuery("CREATE TABLE job(id INTEGER NOT NULL PRIMARY KEY, start TEXT NOT NULL, end TEXT)").exec() ||
+			!QueryBuilder::q(db).addQuery("CREATE TABLE calc(jobid INTEGER NOT NULL, type INTEGER NOT NULL, "
+										  "mode INTEGER NOT NULL DEFAULT 1, years INTEGER, days INTEGER)").exec())
+		return false;
+
+	db.transaction();
+
+	// One prepared statement per table
+
+	QSqlQuery q(db);
+
+	if (!q.prepare(QStringLiteral("INSERT INTO job(id, start, end) VALUES (?, ?, ?)"))) {
+		db.rollback();
+		return false;
+	}
+
+	for (const QJsonValue &v : json.value(QStringLiteral("jobs")).toArray()) {
+		const QJsonObject &obj = v.toObject();
+		const QString &end = obj.value(QStringLiteral("end")).toString();
+
+		q.bindValue(0, obj.value(QStringLiteral("id")).toInteger());
+		q.bindValue(1, obj.value(QStringLiteral("start")).toString());
+		q.bindValue(2, end.isEmpty() ? QVariant() : QVariant(end));
+
+		if (!q.exec()) {
+			db.rollback();
+			return false;
+		}
+	}
+
+	if (!q.prepare(QStringLiteral("INSERT INTO calc(jobid, type, mode, years, days) VALUES (?, ?, ?, ?, ?)"))) {
+		db.rollback();
+		return false;
+	}
+
+	for (const QJsonValue &v : json.value(QStringLiteral("calculations")).toArray()) {
+		const QJsonObject &obj = v.toObject();
+
+		q.bindValue(0, obj.value(QStringLiteral("jobid")).toInteger());
+		q.bindValue(1, obj.value(QStringLiteral("type")).toInt());
+		q.bindValue(2, obj.value(QStringLiteral("mode")).toInt(1));
+		q.bindValue(3, obj.value(QStringLiteral("years")).toInt());
+		q.bindValue(4, obj.value(QStringLiteral("days")).toInt());
+
+		if (!q.exec()) {
+			db.rollback();
+			return false;
+		}
+	}
+
+	return db.commit();
+}
+
+
+
+
+
+/**
+ * @brief JubileeScheduler::toCsv
+ * @return
+ */
+
+QByteArray JubileeScheduler::toCsv() const
+{
+	const auto field = [](QString s) -> QString {
+		if (s.contains(QChar(';')) || s.contains(QChar('"')) || s.contains(QChar('\n')))
+			return QStringLiteral("\"%1\"").arg(s.replace(QStringLiteral("\""), QStringLiteral("\"\"")));
+		return s;
+	};
+
+	QString txt = QStringLiteral("Dátum;Év;Név;Fájl\n");
+
+	for (const Entry &e : m_calendar) {
+		txt.append(e.date.toString(QStringLiteral("yyyy-MM-dd"))).append(QChar(';'))
+				.append(QString::number(e.years)).append(QChar(';'))
+				.append(field(e.title)).append(QChar(';'))
+				.append(field(e.file)).append(QChar('\n'));
+	}
+
+	return txt.toUtf8();
+}
+
+
+
+/**
+ * @brief JubileeScheduler::toXlsx
+ * @return
+ */
+
+QByteArray JubileeScheduler::toXlsx() const
+{
+	QXlsx::Document doc;
+
+	QXlsx::Format format;
+	format.setBottomBorderStyle(QXlsx::Format::BorderMedium);
+	format.setFontBold(true);
+
+	QXlsx::Format dateFormat;
+	dateFormat.setNumberFormat(QStringLiteral("yyyy-mm-dd"));
+
+	doc.write(1, 1, QStringLiteral("Dátum"), format);
+	doc.write(1, 2, QStringLiteral("Év"), format);
+	doc.write(1, 3, QStringLiteral("Név"), format);
+	doc.write(1, 4, QStringLiteral("Fájl"), format);
+
+	int row = 2;
+
+	for (const Entry &e : m_calendar) {
+		doc.write(row, 1, e.date, dateFormat);
+		doc.write(row, 2, e.years);
+		doc.write(row, 3, e.title);
+		doc.write(row, 4, e.file);
+		++row;
+	}
+
+	QBuffer buf;
+	doc.saveAs(&buf);
+	return buf.data();
+}
+
+
+
+/**
+ * @brief JubileeScheduler::toPdf
+ * @return
+ */
+
+QByteArray JubileeScheduler::toPdf() const
+{
+	QString txt;
+
+	txt.append(QStringLiteral("<html><body>\n"));
+
+	txt.append(QStringLiteral("<h1>Jubileumi jutalmak</h1>"));
+	txt.append(QStringLiteral("<h4>%1 – %2</h4>")
+			   .arg(QLocale().toString(m_from, QStringLiteral("yyyy. MMMM d.")))
+			   .arg(QLocale().toString(m_to, QStringLiteral("yyyy. MMMM d.")))
+			   );
+
+	txt.append(QStringLiteral("<table width=\"100%\" cellpadding=\"3\">"
+							  "<tr><th align=\"left\">Időpont</th><th align=\"left\">Év</th><th align=\"left\">Név</th></tr>"));
+
+	for (const Entry &e : m_calendar) {
+		txt.append(QStringLiteral("<tr><td>%1</td><td>%2</td><td>%3</td></tr>")
+				   .arg(QLocale().toString(e.date, QStringLiteral("yyyy. MMMM d.")))
+				   .arg(e.years)
+				   .arg(e.title.toHtmlEscaped()));
+	}
+
+	txt.append(QStringLiteral("</table>"));
+
+	txt.append(QStringLiteral("<p style=\"font-size: 5pt;\">Készült: %1</p>")
+			   .arg(QLocale().toString(QDateTime::currentDateTime(), QStringLiteral("yyyy. MMMM d. HH:mm:ss"))));
+
+	txt.append(QStringLiteral("</body></html>"));
+
+
+	QTextDocument document;
+
+	document.setPageSize(QPageSize::sizePoints(QPageSize::A4));
+	document.setDefaultFont(QFont(QStringLiteral("Noto Sans"), 7));
+	document.setHtml(txt);
+
+	QByteArray content;
+	QBuffer buffer(&content);
+	buffer.open(QIODevice::WriteOnly);
+
+	QPdfWriter pdf(&buffer);
+	QPageLayout layout = pdf.pageLayout();
+	layout.setUnits(QPageLayout::Millimeter);
+	layout.setPageSize(QPageSize::A4);
+	layout.setMargins(QMarginsF(10, 10, 10, 10));
+	pdf.setPageLayout(layout);
+
+	pdf.setTitle(QStringLiteral("Jubileumi jutalmak"));
+	pdf.setCreator(QStringLiteral("TimeCalculator"));
+
+	document.print(&pdf);
+
+	buffer.close();
+
+	return content;
+}
@@ -0,0 +1,103 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * jubileescheduler.h
+ *
+ * Created on: 2024. 01. 18.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * JubileeScheduler
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef JUBILEESCHEDULER_H
+#define JUBILEESCHEDULER_H
+
+#include <QObject>
+#include <QDate>
+#include <QDateTime>
+#include <QFuture>
+#include <QHash>
+#include <QJsonObject>
+#include <QSqlDatabase>
+#include <optional>
+
+
+/**
+ * @brief The JubileeScheduler class
+ *
+ * Collects the upcoming jubilees of every employee file in a directory (or listed in a catalog file).
+ * Files are evaluated in parallel on the thread pool with the totals of Database (on a bare in-memory
+ * connection per file), the results are collected into one calendar sorted by date. Unchanged files
+ * are served from the cache of the previous scan.
+ */
+
+class JubileeScheduler : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit JubileeScheduler(QObject *parent = nullptr);
+	virtual ~JubileeScheduler();
+
+	struct Entry {
+		QString file;
+		QString title;
+		QDate date;
+		int years = 0;
+
+		bool operator<(const Entry &other) const;
+	};
+
+	QFuture<bool> scan(const QString &path, const QDate &from, const int &months);
+	QFuture<bool> scan(const QStringList &files, const QDate &from, const int &months);
+
+	bool isRunning() const { return m_running; }
+
+	const QVector<Entry> &calendar() const { return m_calendar; }
+	int evaluated() const { return m_evaluated; }
+
+	static QString directory(const QString &path);
+
+	void clearCache();
+
+	QByteArray toCsv() const;
+	QByteArray toXlsx() const;
+	QByteArray toPdf() const;
+
+private:
+	struct CacheItem {
+		QDateTime modified;
+		qint64 size = 0;
+		QDate from;
+		std::optional<Entry> entry;
+	};
+
+	static QStringList fileList(const QString &path);
+	static std::optional<Entry> evaluate(const QString &file, const QDate &from);
+	static bool load(QSqlDatabase &db, const QJsonObject &json);
+	void finish(const QHash<QString, CacheItem> &cache, const int &evaluated);
+
+	QHash<QString, CacheItem> m_cache;
+	QVector<Entry> m_calendar;
+	QDate m_from;
+	QDate m_to;
+	int m_evaluated = 0;
+	bool m_running = false;
+};
+
+#endif // JUBILEESCHEDULER_H
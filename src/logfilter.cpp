@@ -0,0 +1,169 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * logfilter.cpp
+ *
+ * Created on: 2024. 01. 29.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * LogFilter
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "logfilter.h"
+#include <QMutex>
+#include <QStringList>
+
+
+std::atomic<int> LogFilter::m_minimum = LogFilter::Trace;
+std::atomic<int> LogFilter::m_default = LogFilter::Trace;
+std::atomic<int> LogFilter::m_count = 0;
+LogFilter::Category LogFilter::m_categories[LogFilter::MaxCategories];
+
+Q_GLOBAL_STATIC(QMutex, g_filterMutex)
+
+
+
+/**
+ * @brief LogFilter::setLevel
+ * Set the level of every category
+ * @param level
+ */
+
+void LogFilter::setLevel(const Level &level)
+{
+	QMutexLocker locker(g_filterMutex());
+
+	m_default.store(level, std::memory_order_relaxed);
+
+	for (int i=0; i<m_count.load(std::memory_order_relaxed); ++i)
+		m_categories[i].level.store(level, std::memory_order_relaxed);
+
+	updateMinimum();
+}
+
+
+
+/**
+ * @brief LogFilter::setLevel
+ * Set the level of the category
+ * @param category
+ * @param level
+ * @return
+ */
+
+bool LogFilter::setLevel(const char *category, const Level &level)
+{
+	if (!category || qstrlen(category) >= sizeof(Category::name))
+		return false;
+
+	QMutexLocker locker(g_filterMutex());
+
+	const int count = m_count.load(std::memory_order_relaxed);
+
+	for (int i=0; i<count; ++i) {
+		if (qstrcmp(m_categories[i].name, category) == 0) {
+			m_categories[i].level.store(level, std::memory_order_relaxed);
+			updateMinimum();
+			return true;
+		}
+	}
+
+	if (count >= MaxCategories)
+		return false;
+
+	// The slot is published by the release store of the count
+
+	qstrcpy(m_categories[count].name, category);
+	m_categories[count].level.store(level, std::memory_order_relaxed);
+	m_count.store(count+1, std::memory_order_release);
+
+	updateMinimum();
+
+	return true;
+}
+
+
+
+/**
+ * @brief LogFilter::configure
+ * Levels from a specification like "info,db=trace,app=debug" (a level without category sets the default)
+ * @param spec
+ * @return
+ */
+
+bool LogFilter::configure(const QString &spec)
+{
+	bool success = true;
+
+	for (const QString &s : spec.split(',', Qt::SkipEmptyParts)) {
+		const QStringList &parts = s.trimmed().split('=');
+
+		const std::optional<Level> &level = levelFromString(parts.last().trimmed());
+
+		if (!level || parts.size() > 2) {
+			success = false;
+			continue;
+		}
+
+		if (parts.size() == 1)
+			setLevel(*level);
+		else if (!setLevel(parts.first().trimmed().toUtf8().constData(), *level))
+			success = false;
+	}
+
+	return success;
+}
+
+
+
+/**
+ * @brief LogFilter::levelFromString
+ * @param str
+ * @return
+ */
+
+std::optional<LogFilter::Level> LogFilter::levelFromString(const QString &str)
+{
+	static const QStringList names = {
+		QStringLiteral("trace"), QStringLiteral("debug"), QStringLiteral("info"),
+		QStringLiteral("warning"), QStringLiteral("error"), QStringLiteral("fatal"),
+	};
+
+	const int idx = names.indexOf(str.toLower());
+
+	if (idx < 0)
+		return std::nullopt;
+
+	return static_cast<Level>(idx);
+}
+
+
+
+/**
+ * @brief LogFilter::updateMinimum
+ */
+
+void LogFilter::updateMinimum()
+{
+	int min = m_default.load(std::memory_order_relaxed);
+
+	for (int i=0; i<m_count.load(std::memory_order_relaxed); ++i)
+		min = std::min(min, m_categories[i].level.load(std::memory_order_relaxed));
+
+	m_minimum.store(min, std::memory_order_relaxed);
+}
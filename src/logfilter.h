@@ -0,0 +1,134 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * logfilter.h
+ *
+ * Created on: 2024. 01. 29.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * LogFilter
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOGFILTER_H
+#define LOGFILTER_H
+
+#include "Logger.h"
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+#include <optional>
+
+
+/**
+ * @brief The LogFilter class
+ *
+ * Level filter of the log categories. The LOG_C* macros redefined below test the level
+ * before the message is built, so the arguments of a disabled message are not evaluated.
+ * Messages below LOG_MIN_LEVEL are removed at compile time.
+ *
+ * A disabled level costs a relaxed atomic load (below the minimum level of all categories)
+ * or a short scan of the configured categories.
+ */
+
+class LogFilter
+{
+public:
+	enum Level {
+		Trace = 0,
+		Debug,
+		Info,
+		Warning,
+		Error,
+		Fatal
+	};
+
+	static bool isEnabled(const Level &level, const char *category) {
+		if (level < m_minimum.load(std::memory_order_relaxed))
+			return false;
+
+		const int count = m_count.load(std::memory_order_acquire);
+
+		for (int i=0; i<count; ++i) {
+			if (qstrcmp(m_categories[i].name, category) == 0)
+				return level >= m_categories[i].level.load(std::memory_order_relaxed);
+		}
+
+		return level >= m_default.load(std::memory_order_relaxed);
+	}
+
+	static void setLevel(const Level &level);
+	static bool setLevel(const char *category, const Level &level);
+	static bool configure(const QString &spec);
+
+	static std::optional<Level> levelFromString(const QString &str);
+
+	static constexpr int MaxCategories = 16;
+
+private:
+	struct Category {
+		char name[32] = {};
+		std::atomic<int> level = Trace;
+	};
+
+	static void updateMinimum();
+
+	static std::atomic<int> m_minimum;
+	static std::atomic<int> m_default;
+	static std::atomic<int> m_count;
+	static Category m_categories[MaxCategories];
+};
+
+
+
+#ifndef LOG_MIN_LEVEL
+#	define LOG_MIN_LEVEL	0
+#endif
+
+#if defined(CUTELOGGERSHARED_EXPORT)
+#	define LOG_WRITE_(level, category)	CuteMessageLogger(cuteLoggerInstance(), Logger::level, __FILE__, __LINE__, Q_FUNC_INFO, category).write()
+#	define LOG_WRITE_Trace(category)	LOG_WRITE_(Trace, category)
+#	define LOG_WRITE_Debug(category)	LOG_WRITE_(Debug, category)
+#	define LOG_WRITE_Info(category)		LOG_WRITE_(Info, category)
+#	define LOG_WRITE_Warning(category)	LOG_WRITE_(Warning, category)
+#	define LOG_WRITE_Error(category)	LOG_WRITE_(Error, category)
+#	define LOG_WRITE_Fatal(category)	LOG_WRITE_(Fatal, category)
+#else
+#	define LOG_WRITE_Trace(category)	qDebug() << category
+#	define LOG_WRITE_Debug(category)	qDebug() << category
+#	define LOG_WRITE_Info(category)		qInfo() << category
+#	define LOG_WRITE_Warning(category)	qWarning() << category
+#	define LOG_WRITE_Error(category)	qCritical() << category
+#	define LOG_WRITE_Fatal(category)	qCritical() << category
+#endif
+
+#define LOG_FILTERED_(level, category)	\
+	if (LogFilter::level < LOG_MIN_LEVEL || !LogFilter::isEnabled(LogFilter::level, category)) {} else LOG_WRITE_##level(category)
+
+#undef LOG_CTRACE
+#undef LOG_CDEBUG
+#undef LOG_CINFO
+#undef LOG_CWARNING
+#undef LOG_CERROR
+
+#define LOG_CTRACE(category)	LOG_FILTERED_(Trace, category)
+#define LOG_CDEBUG(category)	LOG_FILTERED_(Debug, category)
+#define LOG_CINFO(category)		LOG_FILTERED_(Info, category)
+#define LOG_CWARNING(category)	LOG_FILTERED_(Warning, category)
+#define LOG_CERROR(category)	LOG_FILTERED_(Error, category)
+
+#endif // LOGFILTER_H
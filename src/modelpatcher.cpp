@@ -0,0 +1,208 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * modelpatcher.cpp
+ *
+ * Created on: 2024. 01. 12.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * ModelPatcher
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "modelpatcher.h"
+#include "tracer.h"
+#include "logfilter.h"
+#include "qsdiffrunner.h"
+
+#if QT_CONFIG(thread) && !defined(NO_LAMBDA_THREAD)
+#include <QtConcurrent>
+#include <QFutureWatcher>
+#define MODEL_PATCHER_THREADED
+#endif
+
+
+/**
+ * @brief ModelPatcher::ModelPatcher
+ * @param model
+ * @param keyField
+ * @param hashField
+ * @param parent
+ */
+
+ModelPatcher::ModelPatcher(QSListModel *model, const QString &keyField, const QString &hashField, QObject *parent)
+	: QObject(parent)
+	, m_model(model)
+	, m_keyField(keyField)
+	, m_hashField(hashField)
+{
+	Q_ASSERT(m_model);
+}
+
+
+/**
+ * @brief ModelPatcher::~ModelPatcher
+ */
+
+ModelPatcher::~ModelPatcher()
+{
+
+}
+
+
+
+/**
+ * @brief ModelPatcher::patch
+ * @param data
+ */
+
+void ModelPatcher::patch(const QVariantList &data)
+{
+	TRACE_SCOPE("ModelPatcher::patch");
+
+	const quint64 sequence = ++m_sequence;
+
+#ifdef MODEL_PATCHER_THREADED
+	// Implicitly shared copy: the worker never sees later modifications of the storage
+
+	const QVariantList previous = m_model->storage();
+
+	QFutureWatcher<QList<QSPatch>> *watcher = new QFutureWatcher<QList<QSPatch>>(this);
+
+	connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, sequence]() {
+		watcher->deleteLater();
+		--m_running;
+
+		if (sequence != m_sequence) {
+			LOG_CTRACE("utils") << "Drop outdated model patch" << sequence << "current:" << m_sequence;
+			return;
+		}
+
+		apply(watcher->result());
+	});
+
+	++m_running;
+
+	watcher->setFuture(QtConcurrent::run(&ModelPatcher::compare, previous, data, m_keyField, m_hashField));
+#else
+	Q_UNUSED(sequence);
+	apply(compare(m_model->storage(), data, m_keyField, m_hashField));
+#endif
+}
+
+
+
+/**
+ * @brief ModelPatcher::compare
+ * @param from
+ * @param to
+ * @param keyField
+ * @param hashField
+ * @return
+ */
+
+QList<QSPatch> ModelPatcher::compare(const QVariantList &from, const QVariantList &to, const QString &keyField,
+									 const QString &hashField)
+{
+	if (hashField.isEmpty()) {
+		QSDiffRunner runner;
+		runner.setKeyField(keyField);
+		return runner.compare(from, to);
+	}
+
+
+	// Same keys in the same order: only rows with different hash generate updates
+
+	bool sameKeys = from.size() == to.size();
+
+	for (int i=0; sameKeys && i<from.size(); ++i) {
+		if (from.at(i).toMap().value(keyField) != to.at(i).toMap().value(keyField))
+			sameKeys = false;
+	}
+
+	if (sameKeys) {
+		QList<QSPatch> patches;
+
+		for (int i=0; i<from.size(); ++i) {
+			const QVariantMap &prev = from.at(i).toMap();
+			const QVariantMap &next = to.at(i).toMap();
+
+			if (prev.value(hashField).toULongLong() == next.value(hashField).toULongLong())
+				continue;
+
+			QVariantMap diff;
+
+			for (auto it = next.constBegin(); it != next.constEnd(); ++it) {
+				if (prev.value(it.key()) != it.value())
+					diff.insert(it.key(), it.value());
+			}
+
+			for (auto it = prev.constBegin(); it != prev.constEnd(); ++it) {
+				if (it.value().isValid() && !next.contains(it.key()))
+					diff.insert(it.key(), QVariant());
+			}
+
+			if (!diff.isEmpty())
+				patches.append(QSPatch(QSPatch::Update, i, i, 1, diff));
+		}
+
+		return patches;
+	}
+
+
+	// Structural changes: unchanged rows are replaced by the previous (shared) instance before diffing
+
+	QHash<qint64, QVariant> prevRows;
+
+	for (const QVariant &v : from)
+		prevRows.insert(v.toMap().value(keyField).toLongLong(), v);
+
+	QVariantList list;
+	list.reserve(to.size());
+
+	for (const QVariant &v : to) {
+		const QVariantMap &next = v.toMap();
+		const auto it = prevRows.constFind(next.value(keyField).toLongLong());
+
+		if (it != prevRows.constEnd() && it->toMap().value(hashField).toULongLong() == next.value(hashField).toULongLong())
+			list.append(*it);
+		else
+			list.append(v);
+	}
+
+	QSDiffRunner runner;
+	runner.setKeyField(keyField);
+	return runner.compare(from, list);
+}
+
+
+
+/**
+ * @brief ModelPatcher::apply
+ * @param patches
+ */
+
+void ModelPatcher::apply(const QList<QSPatch> &patches)
+{
+	if (!patches.isEmpty()) {
+		QSDiffRunner runner;
+		runner.setKeyField(m_keyField);
+		runner.patch(m_model, patches);
+	}
+
+	emit patched();
+}
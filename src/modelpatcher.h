@@ -0,0 +1,73 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * modelpatcher.h
+ *
+ * Created on: 2024. 01. 12.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * ModelPatcher
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MODELPATCHER_H
+#define MODELPATCHER_H
+
+#include "qslistmodel.h"
+#include "qspatch.h"
+#include <QObject>
+
+
+/**
+ * @brief The ModelPatcher class
+ *
+ * Computes the difference between the storage of a QSListModel and a new list on a worker thread
+ * and patches the model on the GUI thread. Results computed for an outdated request are dropped.
+ *
+ * If hashField is set, every row carries a content hash and rows with equal (integer) key and hash
+ * are treated as unchanged without comparing their fields.
+ */
+
+class ModelPatcher : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit ModelPatcher(QSListModel *model, const QString &keyField, const QString &hashField = QString(),
+						  QObject *parent = nullptr);
+	virtual ~ModelPatcher();
+
+	void patch(const QVariantList &data);
+	bool isBusy() const { return m_running > 0; }
+
+	static QList<QSPatch> compare(const QVariantList &from, const QVariantList &to, const QString &keyField,
+								  const QString &hashField = QString());
+
+signals:
+	void patched();
+
+private:
+	void apply(const QList<QSPatch> &patches);
+
+	QSListModel *const m_model;
+	const QString m_keyField;
+	const QString m_hashField;
+	quint64 m_sequence = 0;
+	int m_running = 0;
+};
+
+#endif // MODELPATCHER_H
@@ -25,9 +25,12 @@
  */
 
 #include "onlineapplication.h"
-#include "Logger.h"
+#include "logfilter.h"
+#include "tracer.h"
 #include "utils_.h"
 #include "emscripten_browser_file.h"
+#include <QBuffer>
+#include <QPointer>
 
 
 OnlineApplication::OnlineApplication(QGuiApplication *app)
@@ -43,80 +46,104 @@ OnlineApplication::OnlineApplication(QGuiApplication *app)
 
 
 /**
- * @brief OnlineApplication::dbOpen
+ * @brief upload
+ * Awaitable browser file upload, the content is returned when the user has selected a file
  * @param accept
+ * @return
  */
 
-void OnlineApplication::dbOpen(const QString &accept)
+static auto upload(const std::string &accept)
 {
-	if (m_database)
-		return messageError(tr("Már meg van nyitva egy adatbázis!"));
-
-	emscripten_browser_file::upload(accept.toStdString(), [](std::string const &/*filename*/,
-									std::string const &/*mime_type*/,
-									std::string_view buffer, void *ptr){
-		if (!ptr) {
-			LOG_CERROR("app") << "Invalid argument";
-			return;
-		}
+	struct Awaiter {
+		std::string accept;
+		QByteArray content;
+		std::coroutine_handle<> handle;
 
-		OnlineApplication *app = reinterpret_cast<OnlineApplication*>(ptr);
+		bool await_ready() const noexcept { return false; }
 
-		if (!app) {
-			LOG_CERROR("app") << "Invalid argument";
-			return;
-		}
+		void await_suspend(std::coroutine_handle<> h) {
+			handle = h;
 
-		QByteArray content(buffer.data(), buffer.length());
-		const auto &json = Utils::byteArrayToJsonObject(content);
+			emscripten_browser_file::upload(accept, [](std::string const &/*filename*/,
+											std::string const &/*mime_type*/,
+											std::string_view buffer, void *ptr){
+				Awaiter *awaiter = static_cast<Awaiter*>(ptr);
 
-		if (!json) {
-			app->messageError(tr("Érvénytelen fájl"));
-		} else {
-			app->loadFromJson(*json);
+				if (!awaiter) {
+					LOG_CERROR("app") << "Invalid argument";
+					return;
+				}
+
+				awaiter->content = QByteArray(buffer.data(), buffer.length());
+				awaiter->handle.resume();
+			}, this);
 		}
 
-	}, this);
+		QByteArray await_resume() { return std::move(content); }
+	};
 
+	return Awaiter{accept, {}, {}};
 }
 
 
 
 /**
- * @brief OnlineApplication::dbSave
+ * @brief OnlineApplication::dbOpenTask
+ * @param accept
+ * @return
  */
 
-void OnlineApplication::dbSave()
+Coro::Task<> OnlineApplication::dbOpenTask(const QString accept)
 {
-	if (!m_database)
-		return messageError(tr("Nincs megnyitva adatbázis!"));
+	const QByteArray &content = co_await upload(accept.toStdString());
 
-	const auto &json = m_database->toJson();
+	const auto &json = co_await Coro::run(this, [content]() { return Utils::byteArrayToJsonObject(content); });
+
+	if (!json) {
+		messageError(tr("Érvénytelen fájl"));
+	} else {
+		loadFromJson(*json);
+	}
+}
 
-	if (json) {
-		QJsonDocument doc(*json);
-		const QByteArray &content = doc.toJson();
 
-		wasmSave(content, m_database->title().append(QStringLiteral(".json")), QStringLiteral("application/json"));
 
-		m_database->setModified(false);
-	} else
+/**
+ * @brief OnlineApplication::dbSaveTask
+ * @return
+ */
+
+Coro::Task<> OnlineApplication::dbSaveTask()
+{
+	QPointer<Database> db = m_database;
+
+	const std::optional<QByteArray> &content = co_await Coro::await(db->toJsonAsync(), this);
+
+	if (!content || !db) {
 		messageError(tr("Sikertelen mentés"));
+		co_return;
+	}
+
+	wasmSave(*content, db->title().append(QStringLiteral(".json")), QStringLiteral("application/json"));
+
+	db->setModified(false);
 }
 
 
 /**
- * @brief OnlineApplication::dbPrint
+ * @brief OnlineApplication::dbPrintTask
+ * @return
  */
 
-void OnlineApplication::dbPrint()
+Coro::Task<> OnlineApplication::dbPrintTask()
 {
-	if (!m_database)
-		return messageError(tr("Nincs megnyitva adatbázis!"));
+	const QString &title = m_database->title();
+	const QByteArray &content = co_await printContent();
 
-	const QByteArray &content = toTextDocument();
+	if (content.isEmpty())
+		co_return;
 
-	wasmSave(content, m_database->title().append(QStringLiteral(".pdf")), QStringLiteral("application/pdf"));
+	wasmSave(content, title + QStringLiteral(".pdf"), QStringLiteral("application/pdf"));
 }
 
 
@@ -132,47 +159,34 @@ void OnlineApplication::importTemplateDownload() const
 }
 
 
+
 /**
- * @brief OnlineApplication::import
+ * @brief OnlineApplication::traceSave
  */
 
-void OnlineApplication::import()
+void OnlineApplication::traceSave() const
 {
-	if (!m_database)
-		return messageError(tr("Nincs megnyitva adatbázis!"));
-
-	emscripten_browser_file::upload(std::string{".xlsx"}, [](std::string const &/*filename*/,
-									std::string const &/*mime_type*/,
-									std::string_view buffer, void *ptr){
-		if (!ptr) {
-			LOG_CERROR("app") << "Invalid argument";
-			return;
-		}
+	QByteArray content;
+	QBuffer buffer(&content);
+	buffer.open(QIODevice::WriteOnly);
 
-		OnlineApplication *app = reinterpret_cast<OnlineApplication*>(ptr);
+	if (!Tracer::save(&buffer))
+		return messageError(tr("Sikertelen mentés"));
 
-		if (!app) {
-			LOG_CERROR("app") << "Invalid argument";
-			return;
-		}
+	buffer.close();
 
-		QByteArray content(buffer.data(), buffer.length());
-
-		if (!app->importData(content)) {
-			app->messageError(tr("Hibás fájl"));
-		} else {
-			app->messageInfo(tr("Az importálás sikerült."));
-		}
-	}, this);
+	wasmSave(content, QStringLiteral("trace.json"), QStringLiteral("application/json"));
+}
 
 
-	/*wasmOpen(QStringLiteral("*.xlsx"), [this](const QByteArray &content, const QString &){
-		if (!importData(content)) {
-			messageError(tr("Hibás fájl"));
-		} else {
-			messageInfo(tr("Az importálás sikerült."));
-		}
-	});*/
-}
+/**
+ * @brief OnlineApplication::importTask
+ * @return
+ */
 
+Coro::Task<> OnlineApplication::importTask()
+{
+	const QByteArray &content = co_await upload(std::string{".xlsx"});
 
+	co_await importContent(content);
+}
@@ -35,12 +35,14 @@ public:
 	OnlineApplication(QGuiApplication *app);
 	virtual ~OnlineApplication() {}
 
-	Q_INVOKABLE virtual void dbOpen(const QString &accept = QStringLiteral(".json")) override;
-	Q_INVOKABLE virtual void dbSave() override;
-	Q_INVOKABLE virtual void dbPrint() override;
-
 	Q_INVOKABLE virtual void importTemplateDownload() const override;
-	Q_INVOKABLE virtual void import() override;
+	Q_INVOKABLE virtual void traceSave() const override;
+
+protected:
+	virtual Coro::Task<> dbOpenTask(const QString accept) override;
+	virtual Coro::Task<> dbSaveTask() override;
+	virtual Coro::Task<> dbPrintTask() override;
+	virtual Coro::Task<> importTask() override;
 };
 
 #endif // ONLINEAPPLICATION_H
@@ -0,0 +1,311 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * overlapclusters.cpp
+ *
+ * Created on: 2024. 01. 19.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * OverlapClusters
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "overlapclusters.h"
+#include <algorithm>
+
+
+
+/**
+ * @brief OverlapClusters::clear
+ */
+
+void OverlapClusters::clear()
+{
+	m_intervals.clear();
+	m_parent.clear();
+	m_clusters.clear();
+	m_index.clear();
+	m_clusterRoot.clear();
+}
+
+
+
+/**
+ * @brief OverlapClusters::rebuild
+ * @param intervals
+ */
+
+void OverlapClusters::rebuild(const QHash<qint64, Interval> &intervals)
+{
+	clear();
+
+	m_intervals = intervals;
+
+	sweep(m_intervals.keys());
+}
+
+
+
+/**
+ * @brief OverlapClusters::insert
+ * Insert a new interval or move an existing one, merging every cluster it overlaps
+ * @param id
+ * @param interval
+ */
+
+void OverlapClusters::insert(const qint64 &id, const Interval &interval)
+{
+	if (m_intervals.contains(id))
+		remove(id);
+
+	m_intervals.insert(id, interval);
+	m_parent.insert(id, id);
+
+	// Clusters are disjoint and ordered by start: the candidates are the last cluster
+	// starting before the interval and the ones starting inside it
+
+	QVector<qint64> roots;
+
+	auto it = m_index.upperBound(interval.start);
+
+	if (it != m_index.begin())
+		--it;
+
+	for (; it != m_index.end() && it.key() <= interval.end; ++it) {
+		const Cluster &c = m_clusters[it.value()];
+
+		if (c.end >= interval.start)
+			roots.append(it.value());
+	}
+
+	qint64 root = id;
+
+	Cluster cluster;
+	cluster.start = interval.start;
+	cluster.end = interval.end;
+	cluster.minId = id;
+	cluster.members.append(id);
+
+	for (qint64 r : roots) {
+		Cluster other = takeCluster(r);
+
+		// Union by size: the larger cluster keeps its root
+
+		if (other.members.size() > cluster.members.size()) {
+			std::swap(cluster.members, other.members);
+			std::swap(root, r);
+		}
+
+		m_parent[r] = root;
+		cluster.members.append(other.members);
+		cluster.start = std::min(cluster.start, other.start);
+		cluster.end = std::max(cluster.end, other.end);
+		cluster.minId = std::min(cluster.minId, other.minId);
+	}
+
+	addCluster(root, std::move(cluster));
+}
+
+
+
+/**
+ * @brief OverlapClusters::remove
+ * Remove an interval and split its former cluster by sweeping its remaining members
+ * @param id
+ */
+
+void OverlapClusters::remove(const qint64 &id)
+{
+	if (!m_intervals.contains(id))
+		return;
+
+	Cluster cluster = takeCluster(find(id));
+
+	for (const qint64 &m : std::as_const(cluster.members))
+		m_parent.remove(m);
+
+	cluster.members.removeAll(id);
+	m_intervals.remove(id);
+
+	sweep(cluster.members);
+}
+
+
+
+/**
+ * @brief OverlapClusters::clusterId
+ * @param id
+ * @return the smallest job id of the cluster, 0 if the job is unknown
+ */
+
+qint64 OverlapClusters::clusterId(const qint64 &id) const
+{
+	if (!m_intervals.contains(id))
+		return 0;
+
+	return m_clusters.value(find(id)).minId;
+}
+
+
+
+/**
+ * @brief OverlapClusters::members
+ * @param clusterId
+ * @return
+ */
+
+QVector<qint64> OverlapClusters::members(const qint64 &clusterId) const
+{
+	const auto it = m_clusterRoot.constFind(clusterId);
+
+	if (it == m_clusterRoot.constEnd())
+		return {};
+
+	QVector<qint64> list = m_clusters.value(it.value()).members;
+	std::sort(list.begin(), list.end());
+	return list;
+}
+
+
+
+/**
+ * @brief OverlapClusters::size
+ * @param id
+ * @return
+ */
+
+int OverlapClusters::size(const qint64 &id) const
+{
+	if (!m_intervals.contains(id))
+		return 0;
+
+	return m_clusters.value(find(id)).members.size();
+}
+
+
+
+/**
+ * @brief OverlapClusters::find
+ * @param id
+ * @return
+ */
+
+qint64 OverlapClusters::find(const qint64 &id) const
+{
+	qint64 root = id;
+
+	while (true) {
+		const qint64 &p = m_parent.value(root, root);
+		if (p == root)
+			break;
+		root = p;
+	}
+
+	// Path compression
+
+	qint64 n = id;
+
+	while (n != root) {
+		qint64 &p = m_parent[n];
+		n = p;
+		p = root;
+	}
+
+	return root;
+}
+
+
+
+/**
+ * @brief OverlapClusters::sweep
+ * Build the clusters of the given (unclustered) intervals
+ * @param ids
+ */
+
+void OverlapClusters::sweep(QVector<qint64> ids)
+{
+	std::sort(ids.begin(), ids.end(), [this](const qint64 &id1, const qint64 &id2) {
+		const QDate &s1 = m_intervals.value(id1).start;
+		const QDate &s2 = m_intervals.value(id2).start;
+		return s1 == s2 ? id1 < id2 : s1 < s2;
+	});
+
+	qint64 root = 0;
+	Cluster cluster;
+
+	for (const qint64 &id : std::as_const(ids)) {
+		const Interval &i = m_intervals.value(id);
+
+		if (!cluster.members.isEmpty() && i.start <= cluster.end) {
+			m_parent.insert(id, root);
+			cluster.members.append(id);
+			cluster.end = std::max(cluster.end, i.end);
+			cluster.minId = std::min(cluster.minId, id);
+			continue;
+		}
+
+		if (!cluster.members.isEmpty())
+			addCluster(root, std::move(cluster));
+
+		root = id;
+		m_parent.insert(id, id);
+
+		cluster = Cluster();
+		cluster.start = i.start;
+		cluster.end = i.end;
+		cluster.minId = id;
+		cluster.members.append(id);
+	}
+
+	if (!cluster.members.isEmpty())
+		addCluster(root, std::move(cluster));
+}
+
+
+
+/**
+ * @brief OverlapClusters::addCluster
+ * @param root
+ * @param cluster
+ */
+
+void OverlapClusters::addCluster(const qint64 &root, Cluster &&cluster)
+{
+	m_index.insert(cluster.start, root);
+	m_clusterRoot.insert(cluster.minId, root);
+	m_clusters.insert(root, std::move(cluster));
+}
+
+
+
+/**
+ * @brief OverlapClusters::takeCluster
+ * @param root
+ * @return
+ */
+
+OverlapClusters::Cluster OverlapClusters::takeCluster(const qint64 &root)
+{
+	Cluster cluster = m_clusters.take(root);
+
+	if (const auto it = m_index.find(cluster.start); it != m_index.end() && it.value() == root)
+		m_index.erase(it);
+
+	m_clusterRoot.remove(cluster.minId);
+
+	return cluster;
+}
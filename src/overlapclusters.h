@@ -0,0 +1,86 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * overlapclusters.h
+ *
+ * Created on: 2024. 01. 19.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * OverlapClusters
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OVERLAPCLUSTERS_H
+#define OVERLAPCLUSTERS_H
+
+#include <QDate>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+
+
+/**
+ * @brief The OverlapClusters class
+ *
+ * Groups jobs into clusters of transitively overlapping intervals. The clusters are built
+ * with a sweep over the sorted intervals and kept in a union-find structure, so inserting
+ * a row only merges the clusters it touches and removing a row re-sweeps its own cluster.
+ */
+
+class OverlapClusters
+{
+public:
+	struct Interval {
+		QDate start;
+		QDate end;
+	};
+
+	OverlapClusters() = default;
+
+	void clear();
+	void rebuild(const QHash<qint64, Interval> &intervals);
+
+	void insert(const qint64 &id, const Interval &interval);
+	void remove(const qint64 &id);
+
+	bool contains(const qint64 &id) const { return m_intervals.contains(id); }
+
+	qint64 clusterId(const qint64 &id) const;
+	QVector<qint64> members(const qint64 &clusterId) const;
+	int size(const qint64 &id) const;
+
+private:
+	struct Cluster {
+		QDate start;
+		QDate end;
+		qint64 minId = 0;
+		QVector<qint64> members;
+	};
+
+	qint64 find(const qint64 &id) const;
+	void sweep(QVector<qint64> ids);
+	void addCluster(const qint64 &root, Cluster &&cluster);
+	Cluster takeCluster(const qint64 &root);
+
+	QHash<qint64, Interval> m_intervals;
+	mutable QHash<qint64, qint64> m_parent;
+	QHash<qint64, Cluster> m_clusters;				// root -> cluster
+	QMap<QDate, qint64> m_index;					// cluster start -> root (clusters are disjoint)
+	QHash<qint64, qint64> m_clusterRoot;			// cluster id (smallest member) -> root
+};
+
+#endif // OVERLAPCLUSTERS_H
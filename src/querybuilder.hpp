@@ -31,30 +31,34 @@
 #include "qjsonarray.h"
 #include "qjsonobject.h"
 #include "qsqlrecord.h"
+#include "querystats.h"
+#include <QDate>
+#include <QElapsedTimer>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QObject>
 #include <QSqlQuery>
+#include <type_traits>
 
 
 
 #ifndef DB_LOG_ERROR
-#   include "Logger.h"
+#   include "logfilter.h"
 #   define DB_LOG_ERROR()   LOG_CERROR("db")
 #endif
 
 #ifndef DB_LOG_WARNING
-#   include "Logger.h"
+#   include "logfilter.h"
 #   define DB_LOG_WARNING()   LOG_CWARNING("db")
 #endif
 
 #ifndef DB_LOG_DEBUG
-#   include "Logger.h"
+#   include "logfilter.h"
 #   define DB_LOG_DEBUG()   LOG_CDEBUG("db")
 #endif
 
 #ifndef DB_LOG_TRACE
-#   include "Logger.h"
+#   include "logfilter.h"
 #   define DB_LOG_TRACE()   LOG_CTRACE("db")
 #endif
 
@@ -115,8 +119,42 @@ private:
 	QVector<QueryString> m_queryString;
 	QVector<Bind> m_bind;
 
+	QueryStats::Entry *m_statsEntry = nullptr;
+	QueryStats::Sample m_statsSample;
+	QElapsedTimer m_statsTimer;
+
+	void statsFetched(const qint64 &rows);
+	void statsCommit();
+
 public:
+
+	/**
+	 * @brief The Row class
+	 * Current row of the result set, columns addressed by their index in the SELECT list
+	 */
+
+	class Row {
+	public:
+		explicit Row(const QSqlQuery &query) : m_query(query) {}
+
+		QVariant value(const int &column) const { return m_query.value(column); }
+		bool isNull(const int &column) const { return m_query.isNull(column); }
+
+		int toInt(const int &column) const { return m_query.value(column).toInt(); }
+		qint64 toLongLong(const int &column) const { return m_query.value(column).toLongLong(); }
+		double toDouble(const int &column) const { return m_query.value(column).toDouble(); }
+		bool toBool(const int &column) const { return m_query.value(column).toBool(); }
+		QString toString(const int &column) const { return m_query.value(column).toString(); }
+		QDate toDate(const int &column) const { return m_query.value(column).toDate(); }
+
+	private:
+		const QSqlQuery &m_query;
+	};
+
 	explicit QueryBuilder(QSqlDatabase db) : m_sqlQuery(db) {};
+	QueryBuilder(const QueryBuilder &) = delete;
+	QueryBuilder &operator=(const QueryBuilder &) = delete;
+	~QueryBuilder() { statsCommit(); }
 
 	static QueryBuilder q(QSqlDatabase db) { return QueryBuilder(db); }
 
@@ -190,7 +228,14 @@ public:
 	std::optional<QVariant> execToValue(const char *field);
 	std::optional<QVariant> execToValue(const char *field, const QVariant &defaultValue);
 
+	template <typename Func>
+	bool execForEach(Func func);
+
+	template <typename T>
+	static QVector<T> resolveConverters(const QSqlRecord &rec, const QMap<QString, T> &map);
+
 	void clear() {
+		statsCommit();
 		m_sqlQuery.clear();
 		m_queryString.clear();
 		m_bind.clear();
@@ -199,6 +244,8 @@ public:
 	QSqlQuery &sqlQuery() { return m_sqlQuery; }
 
 	QVariant value(const char *field) { return m_sqlQuery.value(field); }
+	QVariant value(const int &column) { return m_sqlQuery.value(column); }
+	int indexOf(const char *field) const { return m_sqlQuery.record().indexOf(field); }
 	QVariant value(const char *field, const QVariant &defaultValue) {
 		return m_sqlQuery.value(field).isNull() ? defaultValue : m_sqlQuery.value(field) ;
 	}
@@ -213,8 +260,18 @@ public:
 
 
 
+/**
+ * @brief QueryBuilder::exec
+ * Prepare, bind and execute the query. If QueryStats is enabled, the times are recorded
+ * when the result is released (next exec, clear or destruction), rows fetched by the exec* helpers
+ * are counted.
+ * @return
+ */
+
 inline bool QueryBuilder::exec()
 {
+	statsCommit();
+
 	QByteArray q;
 
 	auto bit = m_bind.constBegin();
@@ -306,8 +363,20 @@ inline bool QueryBuilder::exec()
 		}
 	}
 
+	const bool stats = QueryStats::enabled();
+
+	if (stats) {
+		m_statsEntry = QueryStats::instance()->entry(q);
+		m_statsSample = QueryStats::Sample();
+		m_statsSample.rows = -1;
+		m_statsTimer.start();
+	}
+
 	m_sqlQuery.prepare(q);
 
+	if (stats)
+		m_statsSample.prepare = m_statsTimer.nsecsElapsed();
+
 	foreach (const Bind &b, m_bind) {
 		if (b.type == Bind::Positional || b.type == Bind::Field)
 			m_sqlQuery.addBindValue(b.value);
@@ -318,9 +387,14 @@ inline bool QueryBuilder::exec()
 			m_sqlQuery.bindValue(b.name, b.value);
 	}
 
+	if (stats)
+		m_statsSample.bind = m_statsTimer.nsecsElapsed() - m_statsSample.prepare;
 
 	bool r = m_sqlQuery.exec();
 
+	if (stats)
+		m_statsSample.step = m_statsTimer.nsecsElapsed() - m_statsSample.prepare - m_statsSample.bind;
+
 	if (r)
 		DB_LOG_TRACE() << "Sql query:" << qPrintable(m_sqlQuery.executedQuery().simplified());
 	else {
@@ -351,6 +425,8 @@ inline std::optional<QJsonArray> QueryBuilder::execToJsonArray()
 		list.append(obj);
 	}
 
+	statsFetched(list.size());
+
 	return list;
 }
 
@@ -423,26 +499,31 @@ inline std::optional<QJsonArray> QueryBuilder::execToJsonArray(const QMap<QStrin
 {
 	if (!exec()) return std::nullopt;
 
+	const QSqlRecord &rec = m_sqlQuery.record();
+	const QVector<FieldConvertFunc> &funcs = resolveConverters(rec, map);
+	const int count = rec.count();
+
 	QJsonArray list;
 
 	while (m_sqlQuery.next()) {
-		const QSqlRecord &rec = m_sqlQuery.record();
 		QJsonObject obj;
 
-		for (int i=0; i<rec.count(); ++i) {
-			const QString &f = rec.fieldName(i);
-			if (map.contains(f)) {
-				const FieldConvertFunc &func = map.value(f);
-				const QJsonValue &v = std::invoke(func, rec.value(i));
-				if (!v.isNull()) obj.insert(f, v);
+		for (int i=0; i<count; ++i) {
+			const QVariant &value = m_sqlQuery.value(i);
+
+			if (const FieldConvertFunc &func = funcs.at(i)) {
+				const QJsonValue &v = std::invoke(func, value);
+				if (!v.isNull()) obj.insert(rec.fieldName(i), v);
 			} else {
-				obj.insert(rec.fieldName(i), rec.value(i).toJsonValue());
+				obj.insert(rec.fieldName(i), value.toJsonValue());
 			}
 		}
 
 		list.append(obj);
 	}
 
+	statsFetched(list.size());
+
 	return list;
 }
 
@@ -461,13 +542,12 @@ inline std::optional<QJsonObject> QueryBuilder::execToJsonObject(const QMap<QStr
 
 	if (m_sqlQuery.first()) {
 		const QSqlRecord &rec = m_sqlQuery.record();
+		const QVector<FieldConvertFunc> &funcs = resolveConverters(rec, map);
 
 		for (int i=0; i<rec.count(); ++i) {
-			const QString &f = rec.fieldName(i);
-			if (map.contains(f)) {
-				const FieldConvertFunc &func = map.value(f);
+			if (const FieldConvertFunc &func = funcs.at(i)) {
 				const QJsonValue &v = std::invoke(func, rec.value(i));
-				if (!v.isNull()) obj.insert(f, v);
+				if (!v.isNull()) obj.insert(rec.fieldName(i), v);
 			} else {
 				obj.insert(rec.fieldName(i), rec.value(i).toJsonValue());
 			}
@@ -489,26 +569,95 @@ inline std::optional<QVariantList> QueryBuilder::execToVariantList(const QMap<QS
 {
 	if (!exec()) return std::nullopt;
 
+	const QSqlRecord &rec = m_sqlQuery.record();
+	const QVector<FieldConvertVariantFunc> &funcs = resolveConverters(rec, map);
+	const int count = rec.count();
+
 	QVariantList list;
 
 	while (m_sqlQuery.next()) {
-		const QSqlRecord &rec = m_sqlQuery.record();
 		QVariantMap obj;
 
-		for (int i=0; i<rec.count(); ++i) {
-			const QString &f = rec.fieldName(i);
-			if (map.contains(f)) {
-				const FieldConvertVariantFunc &func = map.value(f);
-				const QVariant &v = std::invoke(func, rec.value(i));
-				if (!v.isNull()) obj.insert(f, v);
+		for (int i=0; i<count; ++i) {
+			const QVariant &value = m_sqlQuery.value(i);
+
+			if (const FieldConvertVariantFunc &func = funcs.at(i)) {
+				const QVariant &v = std::invoke(func, value);
+				if (!v.isNull()) obj.insert(rec.fieldName(i), v);
 			} else {
-				obj.insert(rec.fieldName(i), rec.value(i).toJsonValue());
+				obj.insert(rec.fieldName(i), value.toJsonValue());
 			}
 		}
 
 		list.append(obj);
 	}
 
+	statsFetched(list.size());
+
+	return list;
+}
+
+
+
+
+/**
+ * @brief QueryBuilder::execForEach
+ * Execute the query and call func(const Row &) for every row on a forward-only cursor.
+ * If func returns bool, false stops the iteration.
+ * @param func
+ * @return
+ */
+
+template<typename Func>
+inline bool QueryBuilder::execForEach(Func func)
+{
+	m_sqlQuery.setForwardOnly(true);
+
+	if (!exec()) return false;
+
+	const Row row(m_sqlQuery);
+	qint64 rows = 0;
+
+	while (m_sqlQuery.next()) {
+		++rows;
+
+		if constexpr (std::is_same_v<std::invoke_result_t<Func, const Row &>, bool>) {
+			if (!std::invoke(func, row))
+				break;
+		} else {
+			std::invoke(func, row);
+		}
+	}
+
+	statsFetched(rows);
+
+	return true;
+}
+
+
+
+
+/**
+ * @brief QueryBuilder::resolveConverters
+ * Converters of the columns of the record indexed by column (empty function if there is none)
+ * @param rec
+ * @param map
+ * @return
+ */
+
+template<typename T>
+inline QVector<T> QueryBuilder::resolveConverters(const QSqlRecord &rec, const QMap<QString, T> &map)
+{
+	QVector<T> list(rec.count());
+
+	if (map.isEmpty())
+		return list;
+
+	for (int i=0; i<rec.count(); ++i) {
+		if (const auto it = map.constFind(rec.fieldName(i)); it != map.constEnd())
+			list[i] = it.value();
+	}
+
 	return list;
 }
 
@@ -549,6 +698,48 @@ inline std::optional<QVariant> QueryBuilder::execToValue(const char *field, cons
 
 
 
+/**
+ * @brief QueryBuilder::statsFetched
+ * All rows fetched: the step time includes the iteration
+ * @param rows
+ */
+
+inline void QueryBuilder::statsFetched(const qint64 &rows)
+{
+	if (!m_statsEntry)
+		return;
+
+	m_statsSample.rows = rows;
+	m_statsSample.step = m_statsTimer.nsecsElapsed() - m_statsSample.prepare - m_statsSample.bind;
+}
+
+
+
+
+/**
+ * @brief QueryBuilder::statsCommit
+ * Record the pending sample. If the rows were not counted, the position of the cursor (SELECT)
+ * or the number of affected rows is used.
+ */
+
+inline void QueryBuilder::statsCommit()
+{
+	if (!m_statsEntry)
+		return;
+
+	if (m_statsSample.rows < 0) {
+		if (m_sqlQuery.isSelect())
+			m_statsSample.rows = std::max(0, m_sqlQuery.at() + 1);
+		else
+			m_statsSample.rows = std::max(0, m_sqlQuery.numRowsAffected());
+	}
+
+	QueryStats::instance()->record(m_statsEntry, m_statsSample);
+	m_statsEntry = nullptr;
+}
+
+
+
 inline int QueryBuilder::fieldCount() const
 {
 	int r = 0;
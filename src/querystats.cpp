@@ -0,0 +1,329 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * querystats.cpp
+ *
+ * Created on: 2024. 01. 27.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * QueryStats
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "querystats.h"
+#include <QHash>
+#include <algorithm>
+#include <bit>
+
+
+std::atomic<bool> QueryStats::m_enabled = false;
+
+
+
+/**
+ * @brief QueryStats::instance
+ * @return
+ */
+
+QueryStats *QueryStats::instance()
+{
+	static QueryStats stats;
+	return &stats;
+}
+
+
+
+/**
+ * @brief QueryStats::entry
+ * Entry of the statement (created on first use). If the table is full, the shared overflow entry is returned.
+ * @param sql
+ * @return
+ */
+
+QueryStats::Entry *QueryStats::entry(const QByteArray &sql)
+{
+	const QByteArray &normalized = normalize(sql);
+	const size_t hash = qHash(normalized);
+
+	for (int n=0, i=hash % Capacity; n<Capacity; ++n, i=(i+1) % Capacity) {
+		Entry *e = m_table[i].load(std::memory_order_acquire);
+
+		if (!e) {
+			Entry *ptr = new Entry(hash, normalized);
+
+			if (m_table[i].compare_exchange_strong(e, ptr, std::memory_order_acq_rel, std::memory_order_acquire))
+				return ptr;
+
+			delete ptr;
+		}
+
+		if (e->m_hash == hash && e->m_sql == normalized)
+			return e;
+	}
+
+	Entry *e = m_overflow.load(std::memory_order_acquire);
+
+	if (!e) {
+		Entry *ptr = new Entry(0, QByteArrayLiteral("(other)"));
+
+		if (m_overflow.compare_exchange_strong(e, ptr, std::memory_order_acq_rel, std::memory_order_acquire))
+			return ptr;
+
+		delete ptr;
+	}
+
+	return e;
+}
+
+
+
+/**
+ * @brief QueryStats::record
+ * @param entry
+ * @param sample
+ */
+
+void QueryStats::record(Entry *entry, const Sample &sample)
+{
+	if (!entry)
+		return;
+
+	const qint64 total = sample.prepare + sample.bind + sample.step;
+
+	entry->m_count.fetch_add(1, std::memory_order_relaxed);
+	entry->m_rows.fetch_add(sample.rows, std::memory_order_relaxed);
+	entry->m_prepare.fetch_add(sample.prepare, std::memory_order_relaxed);
+	entry->m_bind.fetch_add(sample.bind, std::memory_order_relaxed);
+	entry->m_step.fetch_add(sample.step, std::memory_order_relaxed);
+	entry->m_histogram[bucket(total)].fetch_add(1, std::memory_order_relaxed);
+
+	for (qint64 max = entry->m_max.load(std::memory_order_relaxed);
+		 max < total && !entry->m_max.compare_exchange_weak(max, total, std::memory_order_relaxed); ) {}
+}
+
+
+
+/**
+ * @brief QueryStats::snapshot
+ * Statistics of the executed statements ordered by total time
+ * @return
+ */
+
+QVector<QueryStats::Stat> QueryStats::snapshot() const
+{
+	QVector<Stat> list;
+
+	const auto add = [&list](const Entry *e) {
+		if (!e)
+			return;
+
+		Stat s;
+		s.count = e->m_count.load(std::memory_order_relaxed);
+
+		if (s.count == 0)
+			return;
+
+		s.sql = e->m_sql;
+		s.rows = e->m_rows.load(std::memory_order_relaxed);
+		s.prepare = e->m_prepare.load(std::memory_order_relaxed);
+		s.bind = e->m_bind.load(std::memory_order_relaxed);
+		s.step = e->m_step.load(std::memory_order_relaxed);
+		s.max = e->m_max.load(std::memory_order_relaxed);
+		s.total = s.prepare + s.bind + s.step;
+		s.mean = s.total / s.count;
+
+		std::array<quint32, Buckets> histogram;
+		quint64 sum = 0;
+
+		for (int i=0; i<Buckets; ++i)
+			sum += histogram[i] = e->m_histogram[i].load(std::memory_order_relaxed);
+
+		const quint64 limit = (sum * 99 + 99) / 100;
+		quint64 cumulative = 0;
+
+		for (int i=0; i<Buckets; ++i) {
+			cumulative += histogram[i];
+
+			if (cumulative >= limit) {
+				s.p99 = std::min(bucketLimit(i), s.max);
+				break;
+			}
+		}
+
+		list.append(s);
+	};
+
+	for (const auto &ptr : m_table)
+		add(ptr.load(std::memory_order_acquire));
+
+	add(m_overflow.load(std::memory_order_acquire));
+
+	std::sort(list.begin(), list.end(), [](const Stat &s1, const Stat &s2) { return s1.total > s2.total; });
+
+	return list;
+}
+
+
+
+/**
+ * @brief QueryStats::dump
+ * Text table of the statistics (times in microseconds)
+ * @return
+ */
+
+QString QueryStats::dump() const
+{
+	QString txt = QStringLiteral("%1 %2 %3 %4 %5 %6  %7\n")
+				  .arg(QStringLiteral("count"), 8)
+				  .arg(QStringLiteral("total"), 12)
+				  .arg(QStringLiteral("mean"), 10)
+				  .arg(QStringLiteral("p99"), 10)
+				  .arg(QStringLiteral("max"), 10)
+				  .arg(QStringLiteral("rows"), 10)
+				  .arg(QStringLiteral("sql"));
+
+	for (const Stat &s : snapshot()) {
+		txt += QStringLiteral("%1 %2 %3 %4 %5 %6  %7\n")
+			   .arg(s.count, 8)
+			   .arg(s.total / 1000, 12)
+			   .arg(s.mean / 1000, 10)
+			   .arg(s.p99 / 1000, 10)
+			   .arg(s.max / 1000, 10)
+			   .arg(s.rows, 10)
+			   .arg(QString::fromUtf8(s.sql));
+	}
+
+	return txt;
+}
+
+
+
+/**
+ * @brief QueryStats::reset
+ * Clear the counters (the entries are kept)
+ */
+
+void QueryStats::reset()
+{
+	const auto clear = [](Entry *e) {
+		if (!e)
+			return;
+
+		e->m_count.store(0, std::memory_order_relaxed);
+		e->m_rows.store(0, std::memory_order_relaxed);
+		e->m_prepare.store(0, std::memory_order_relaxed);
+		e->m_bind.store(0, std::memory_order_relaxed);
+		e->m_step.store(0, std::memory_order_relaxed);
+		e->m_max.store(0, std::memory_order_relaxed);
+
+		for (auto &b : e->m_histogram)
+			b.store(0, std::memory_order_relaxed);
+	};
+
+	for (auto &ptr : m_table)
+		clear(ptr.load(std::memory_order_acquire));
+
+	clear(m_overflow.load(std::memory_order_acquire));
+}
+
+
+
+/**
+ * @brief QueryStats::normalize
+ * Simplified statement text, runs of placeholders ("?,?,?") collapsed to a single "?"
+ * @param sql
+ * @return
+ */
+
+QByteArray QueryStats::normalize(const QByteArray &sql)
+{
+	const QByteArray &s = sql.simplified();
+
+	QByteArray r;
+	r.reserve(s.size());
+
+	for (int i=0; i<s.size(); ++i) {
+		r += s.at(i);
+
+		if (s.at(i) != '?')
+			continue;
+
+		// Skip ", ?" sequences
+
+		for (int j=i+1; j<s.size(); ) {
+			while (j<s.size() && s.at(j) == ' ')
+				++j;
+
+			if (j >= s.size() || s.at(j) != ',')
+				break;
+
+			++j;
+
+			while (j<s.size() && s.at(j) == ' ')
+				++j;
+
+			if (j >= s.size() || s.at(j) != '?')
+				break;
+
+			i = j++;
+		}
+	}
+
+	return r;
+}
+
+
+
+/**
+ * @brief QueryStats::bucket
+ * Histogram bucket of the latency: 4 linear sub-buckets in every power of two
+ * @param ns
+ * @return
+ */
+
+int QueryStats::bucket(const qint64 &ns)
+{
+	if (ns < 4)
+		return std::max<qint64>(0, ns);
+
+	const int e = std::min<int>(std::bit_width(quint64(ns)) - 1, Buckets/4 - 1);
+
+	if (quint64(ns) >> e > 1)			// clamped
+		return Buckets-1;
+
+	return e*4 + int((quint64(ns) >> (e-2)) & 3);
+}
+
+
+
+/**
+ * @brief QueryStats::bucketLimit
+ * Upper limit of the bucket
+ * @param index
+ * @return
+ */
+
+qint64 QueryStats::bucketLimit(const int &index)
+{
+	if (index < 4)
+		return index;
+
+	const int e = index / 4;
+	const int sub = index % 4;
+
+	return (qint64(4 + sub + 1) << (e-2)) - 1;
+}
@@ -0,0 +1,129 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * querystats.h
+ *
+ * Created on: 2024. 01. 27.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * QueryStats
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUERYSTATS_H
+#define QUERYSTATS_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <array>
+#include <atomic>
+
+
+/**
+ * @brief The QueryStats class
+ *
+ * Execution statistics of the SQL statements, aggregated by the normalised statement text
+ * (whitespace simplified, expanded lists of placeholders collapsed).
+ * Entries are stored in a fixed size open addressing table and published with compare-and-swap,
+ * counters are atomic, so recording never takes a lock. The latency percentiles are estimated
+ * from a log-linear histogram (4 buckets per power of two nanoseconds).
+ * Recording is disabled by default (see setEnabled()).
+ */
+
+class QueryStats
+{
+public:
+	struct Sample {
+		qint64 prepare = 0;
+		qint64 bind = 0;
+		qint64 step = 0;
+		qint64 rows = 0;
+	};
+
+	struct Stat {
+		QByteArray sql;
+		quint64 count = 0;
+		quint64 rows = 0;
+		qint64 prepare = 0;
+		qint64 bind = 0;
+		qint64 step = 0;
+		qint64 total = 0;
+		qint64 mean = 0;
+		qint64 p99 = 0;
+		qint64 max = 0;
+	};
+
+	class Entry;
+
+	static constexpr int Capacity = 1024;
+	static constexpr int Buckets = 192;
+
+	static QueryStats *instance();
+
+	static bool enabled() { return m_enabled.load(std::memory_order_relaxed); }
+	static void setEnabled(const bool &on) { m_enabled.store(on, std::memory_order_relaxed); }
+
+	Entry *entry(const QByteArray &sql);
+	void record(Entry *entry, const Sample &sample);
+
+	QVector<Stat> snapshot() const;
+	QString dump() const;
+	void reset();
+
+	static QByteArray normalize(const QByteArray &sql);
+
+private:
+	QueryStats() = default;
+
+	static int bucket(const qint64 &ns);
+	static qint64 bucketLimit(const int &index);
+
+	std::array<std::atomic<Entry*>, Capacity> m_table = {};
+	std::atomic<Entry*> m_overflow = nullptr;
+
+	static std::atomic<bool> m_enabled;
+};
+
+
+
+
+/**
+ * @brief The QueryStats::Entry class
+ */
+
+class QueryStats::Entry
+{
+public:
+	Entry(const size_t &hash, const QByteArray &sql) : m_hash(hash), m_sql(sql) {}
+
+private:
+	const size_t m_hash;
+	const QByteArray m_sql;
+
+	std::atomic<quint64> m_count = 0;
+	std::atomic<quint64> m_rows = 0;
+	std::atomic<qint64> m_prepare = 0;
+	std::atomic<qint64> m_bind = 0;
+	std::atomic<qint64> m_step = 0;
+	std::atomic<qint64> m_max = 0;
+	std::array<std::atomic<quint32>, QueryStats::Buckets> m_histogram = {};
+
+	friend class QueryStats;
+};
+
+#endif // QUERYSTATS_H
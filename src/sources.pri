@@ -0,0 +1,50 @@
+# Sources shared by the application, the benchmarks and the tools
+
+INCLUDEPATH += $$PWD
+
+# Trace messages are compiled out of release builds (see logfilter.h)
+
+CONFIG(release, debug|release): DEFINES += LOG_MIN_LEVEL=1
+
+SOURCES += \
+	$$PWD/abstractapplication.cpp \
+	$$PWD/application.cpp \
+	$$PWD/calculationresult.cpp \
+	$$PWD/database.cpp \
+	$$PWD/databasemanager.cpp \
+	$$PWD/databaseworker.cpp \
+	$$PWD/durationcache.cpp \
+	$$PWD/joblistmodel.cpp \
+	$$PWD/jobproxymodel.cpp \
+	$$PWD/jsonstreamwriter.cpp \
+	$$PWD/jubileescheduler.cpp \
+	$$PWD/logfilter.cpp \
+	$$PWD/modelpatcher.cpp \
+	$$PWD/overlapclusters.cpp \
+	$$PWD/querystats.cpp \
+	$$PWD/tracer.cpp \
+	$$PWD/undostack.cpp \
+	$$PWD/utils_.cpp
+
+HEADERS += \
+	$$PWD/abstractapplication.h \
+	$$PWD/application.h \
+	$$PWD/calculationresult.h \
+	$$PWD/civilcalendar.hpp \
+	$$PWD/database.h \
+	$$PWD/databasemanager.h \
+	$$PWD/databaseworker.h \
+	$$PWD/durationcache.h \
+	$$PWD/joblistmodel.h \
+	$$PWD/jobproxymodel.h \
+	$$PWD/jsonstreamwriter.h \
+	$$PWD/jubileescheduler.h \
+	$$PWD/logfilter.h \
+	$$PWD/modelpatcher.h \
+	$$PWD/overlapclusters.h \
+	$$PWD/querybuilder.hpp \
+	$$PWD/querystats.h \
+	$$PWD/task.hpp \
+	$$PWD/tracer.h \
+	$$PWD/undostack.h \
+	$$PWD/utils_.h
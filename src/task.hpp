@@ -0,0 +1,264 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * task.hpp
+ *
+ * Created on: 2024. 01. 23.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * Task
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TASK_HPP
+#define TASK_HPP
+
+#include <QObject>
+#include <QFuture>
+#include <QPromise>
+#include <coroutine>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+#if QT_CONFIG(thread) && !defined(NO_LAMBDA_THREAD)
+#include <QtConcurrent>
+#define TASK_THREADED
+#endif
+
+
+/**
+ * Coroutines driven by the Qt event loop
+ *
+ *   Coro::Task<bool> Application::flow() {
+ *       const auto &data = co_await Coro::run(this, [](){ return parse(); });	// thread pool
+ *       co_await Coro::yield(this);										// let the event loop run
+ *       co_return co_await Coro::await(m_database->jobAddAsync(data), this);	// QFuture
+ *   }
+ *
+ * A Task starts immediately and runs until its first suspension. It may be awaited by another
+ * coroutine or dropped (fire and forget): the coroutine frame is destroyed when it finishes.
+ * Every suspension resumes on the thread of the context object; if the context is destroyed
+ * while suspended, the coroutine is never resumed.
+ *
+ * Parameters of coroutines are taken by value: references may dangle after the first suspension.
+ */
+
+namespace Coro {
+
+template <typename T>
+class Task;
+
+
+namespace Private {
+
+template <typename T>
+struct State {
+	std::optional<T> result;
+	std::coroutine_handle<> continuation;
+	bool done = false;
+};
+
+template <>
+struct State<void> {
+	std::coroutine_handle<> continuation;
+	bool done = false;
+};
+
+
+template <typename Promise>
+struct FinalAwaiter {
+	bool await_ready() const noexcept { return false; }
+
+	void await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+		const auto state = handle.promise().state;
+		state->done = true;
+
+		// The result lives in the shared state, the frame is no longer needed
+
+		handle.destroy();
+
+		if (state->continuation)
+			state->continuation.resume();
+	}
+
+	void await_resume() const noexcept {}
+};
+
+
+template <typename T>
+struct PromiseBase {
+	const std::shared_ptr<State<T>> state = std::make_shared<State<T>>();
+
+	std::suspend_never initial_suspend() const noexcept { return {}; }
+	void unhandled_exception() const noexcept { std::terminate(); }
+};
+
+
+template <typename T>
+struct Promise : public PromiseBase<T> {
+	Task<T> get_return_object();
+	FinalAwaiter<Promise> final_suspend() const noexcept { return {}; }
+	void return_value(T value) { this->state->result = std::move(value); }
+};
+
+
+template <>
+struct Promise<void> : public PromiseBase<void> {
+	Task<void> get_return_object();
+	FinalAwaiter<Promise> final_suspend() const noexcept { return {}; }
+	void return_void() const {}
+};
+
+}
+
+
+
+/**
+ * @brief The Task class
+ */
+
+template <typename T = void>
+class Task
+{
+public:
+	using promise_type = Private::Promise<T>;
+
+	bool isDone() const { return m_state->done; }
+
+	bool await_ready() const noexcept { return m_state->done; }
+	void await_suspend(std::coroutine_handle<> handle) const { m_state->continuation = handle; }
+
+	T await_resume() const {
+		if constexpr (!std::is_void_v<T>)
+			return std::move(*m_state->result);
+	}
+
+private:
+	explicit Task(const std::shared_ptr<Private::State<T>> &state) : m_state(state) {}
+
+	friend promise_type;
+
+	std::shared_ptr<Private::State<T>> m_state;
+};
+
+
+namespace Private {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() { return Task<T>(this->state); }
+
+inline Task<void> Promise<void>::get_return_object() { return Task<void>(this->state); }
+
+}
+
+
+
+
+/**
+ * @brief yield
+ * Resume from the event loop of the context
+ * @param context
+ * @return
+ */
+
+inline auto yield(QObject *context)
+{
+	struct Awaiter {
+		QObject *context;
+
+		bool await_ready() const noexcept { return false; }
+
+		void await_suspend(std::coroutine_handle<> handle) const {
+			QMetaObject::invokeMethod(context, [handle]() { handle.resume(); }, Qt::QueuedConnection);
+		}
+
+		void await_resume() const noexcept {}
+	};
+
+	return Awaiter{context};
+}
+
+
+
+
+/**
+ * @brief await
+ * Wait for the future and resume on the thread of the context
+ * @param future
+ * @param context
+ * @return
+ */
+
+template <typename T>
+auto await(QFuture<T> future, QObject *context)
+{
+	struct Awaiter {
+		QFuture<T> future;
+		QObject *context;
+
+		bool await_ready() const { return future.isFinished(); }
+
+		void await_suspend(std::coroutine_handle<> handle) {
+			future.then(context, [handle](QFuture<T>) { handle.resume(); });
+		}
+
+		T await_resume() const {
+			if constexpr (!std::is_void_v<T>)
+				return future.result();
+		}
+	};
+
+	return Awaiter{std::move(future), context};
+}
+
+
+
+
+/**
+ * @brief run
+ * Run func on the global thread pool (on the calling thread if threads are not available)
+ * @param context
+ * @param func
+ * @return
+ */
+
+template <typename Func>
+auto run(QObject *context, Func func)
+{
+#ifdef TASK_THREADED
+	return await(QtConcurrent::run(std::move(func)), context);
+#else
+	using R = std::invoke_result_t<Func>;
+
+	QPromise<R> promise;
+	promise.start();
+
+	if constexpr (std::is_void_v<R>)
+		func();
+	else
+		promise.addResult(func());
+
+	promise.finish();
+
+	return await(promise.future(), context);
+#endif
+}
+
+}
+
+#endif // TASK_HPP
@@ -0,0 +1,306 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * tracer.cpp
+ *
+ * Created on: 2024. 01. 28.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * Tracer
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "tracer.h"
+#include "jsonstreamwriter.h"
+#include "logfilter.h"
+#include <QCoreApplication>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThread>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <vector>
+
+
+std::atomic<bool> Tracer::m_enabled = false;
+
+
+namespace {
+
+/**
+ * Ring buffer of a thread. Written only by its own thread, buffers are kept after
+ * the thread finished until their events are cleared. Events before the position
+ * "cleared" are dropped.
+ */
+
+struct TraceBuffer {
+	std::array<Tracer::Event, Tracer::BufferSize> events;
+	std::atomic<quint64> written = 0;
+	std::atomic<quint64> cleared = 0;
+	int tid = 0;
+	QString threadName;
+};
+
+
+struct TraceRegistry {
+	QMutex mutex;
+	std::vector<std::shared_ptr<TraceBuffer>> buffers;
+	int nextTid = 1;
+};
+
+
+TraceRegistry &registry()
+{
+	static TraceRegistry r;
+	return r;
+}
+
+
+/// Only the registry holds the buffer: its thread finished (the mutex must be locked)
+
+bool finished(const std::shared_ptr<TraceBuffer> &buffer)
+{
+	return buffer.use_count() == 1;
+}
+
+
+TraceBuffer *threadBuffer()
+{
+	thread_local std::shared_ptr<TraceBuffer> buffer;
+
+	if (!buffer) {
+		buffer = std::make_shared<TraceBuffer>();
+
+		QThread *thread = QThread::currentThread();
+
+		if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+			buffer->threadName = QStringLiteral("main");
+		else if (thread && !thread->objectName().isEmpty())
+			buffer->threadName = thread->objectName();
+
+		TraceRegistry &r = registry();
+		QMutexLocker locker(&r.mutex);
+		buffer->tid = r.nextTid++;
+
+		if (buffer->threadName.isEmpty())
+			buffer->threadName = QStringLiteral("thread %1").arg(buffer->tid);
+
+		// Threads of the pools come and go: drop the finished ones without pending events
+
+		std::erase_if(r.buffers, [](const std::shared_ptr<TraceBuffer> &b) {
+			return finished(b) && b->cleared.load(std::memory_order_relaxed) >= b->written.load(std::memory_order_acquire);
+		});
+
+		r.buffers.push_back(buffer);
+	}
+
+	return buffer.get();
+}
+
+
+quint64 first(const TraceBuffer &buffer, const quint64 &written)
+{
+	const quint64 c = buffer.cleared.load(std::memory_order_relaxed);
+	return std::max(c, written > Tracer::BufferSize ? written-Tracer::BufferSize : 0);
+}
+
+}
+
+
+
+/**
+ * @brief Tracer::setEnabled
+ * @param on
+ */
+
+void Tracer::setEnabled(const bool &on)
+{
+	LOG_CDEBUG("app") << "Tracing" << (on ? "enabled" : "disabled");
+
+	m_enabled.store(on, std::memory_order_relaxed);
+}
+
+
+
+/**
+ * @brief Tracer::now
+ * Monotonic time in nanoseconds
+ * @return
+ */
+
+qint64 Tracer::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+
+/**
+ * @brief Tracer::add
+ * Append a complete event to the buffer of the current thread (the oldest events are overwritten)
+ * @param name
+ * @param category
+ * @param start
+ * @param duration
+ */
+
+void Tracer::add(const char *name, const char *category, const qint64 &start, const qint64 &duration)
+{
+	TraceBuffer *buffer = threadBuffer();
+
+	const quint64 n = buffer->written.load(std::memory_order_relaxed);
+
+	Event &e = buffer->events[n % BufferSize];
+	e.name = name;
+	e.category = category;
+	e.start = start;
+	e.duration = duration;
+
+	buffer->written.store(n+1, std::memory_order_release);
+}
+
+
+
+/**
+ * @brief Tracer::save
+ * Write the events in Chrome trace event format (times in microseconds).
+ * Events of running threads written during the export may be inconsistent.
+ * @param device
+ * @return
+ */
+
+bool Tracer::save(QIODevice *device)
+{
+	Q_ASSERT(device);
+
+	std::vector<std::shared_ptr<TraceBuffer>> buffers;
+
+	{
+		TraceRegistry &r = registry();
+		QMutexLocker locker(&r.mutex);
+		buffers = r.buffers;
+	}
+
+	qint64 origin = std::numeric_limits<qint64>::max();
+
+	for (const auto &b : buffers) {
+		const quint64 n = b->written.load(std::memory_order_acquire);
+
+		for (quint64 i = first(*b, n); i<n; ++i)
+			origin = std::min(origin, b->events[i % BufferSize].start);
+	}
+
+	const qint64 pid = QCoreApplication::applicationPid();
+
+	JsonStreamWriter writer(device, QJsonDocument::Compact);
+
+	writer.beginObject();
+	writer.value(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+	writer.key(QStringLiteral("traceEvents")).beginArray();
+
+	writer.value(QJsonObject{
+					 { QStringLiteral("name"), QStringLiteral("process_name") },
+					 { QStringLiteral("ph"), QStringLiteral("M") },
+					 { QStringLiteral("pid"), pid },
+					 { QStringLiteral("args"), QJsonObject{ { QStringLiteral("name"), QCoreApplication::applicationName() } } },
+				 });
+
+	for (const auto &b : buffers) {
+		writer.value(QJsonObject{
+						 { QStringLiteral("name"), QStringLiteral("thread_name") },
+						 { QStringLiteral("ph"), QStringLiteral("M") },
+						 { QStringLiteral("pid"), pid },
+						 { QStringLiteral("tid"), b->tid },
+						 { QStringLiteral("args"), QJsonObject{ { QStringLiteral("name"), b->threadName } } },
+					 });
+
+		const quint64 n = b->written.load(std::memory_order_acquire);
+
+		for (quint64 i = first(*b, n); i<n && !writer.hasError(); ++i) {
+			const Event &e = b->events[i % BufferSize];
+
+			writer.value(QJsonObject{
+							 { QStringLiteral("name"), QString::fromUtf8(e.name) },
+							 { QStringLiteral("cat"), QString::fromUtf8(e.category) },
+							 { QStringLiteral("ph"), QStringLiteral("X") },
+							 { QStringLiteral("ts"), (e.start - origin) / 1000. },
+							 { QStringLiteral("dur"), e.duration / 1000. },
+							 { QStringLiteral("pid"), pid },
+							 { QStringLiteral("tid"), b->tid },
+						 });
+		}
+	}
+
+	writer.endArray();
+	writer.endObject();
+
+	return !writer.hasError();
+}
+
+
+
+/**
+ * @brief Tracer::save
+ * @param file
+ * @return
+ */
+
+bool Tracer::save(const QString &file)
+{
+	QSaveFile f(file);
+
+	if (!f.open(QIODevice::WriteOnly)) {
+		LOG_CERROR("app") << "Can't write file:" << qPrintable(file);
+		return false;
+	}
+
+	if (!save(&f)) {
+		f.cancelWriting();
+		return false;
+	}
+
+	if (!f.commit()) {
+		LOG_CERROR("app") << "Can't write file:" << qPrintable(file);
+		return false;
+	}
+
+	LOG_CINFO("app") << "Trace saved:" << qPrintable(file);
+
+	return true;
+}
+
+
+
+/**
+ * @brief Tracer::clear
+ * Drop the recorded events and the buffers of the finished threads
+ */
+
+void Tracer::clear()
+{
+	TraceRegistry &r = registry();
+	QMutexLocker locker(&r.mutex);
+
+	std::erase_if(r.buffers, &finished);
+
+	for (const auto &b : r.buffers)
+		b->cleared.store(b->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
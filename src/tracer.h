@@ -0,0 +1,106 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * tracer.h
+ *
+ * Created on: 2024. 01. 28.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * Tracer
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QIODevice>
+#include <atomic>
+
+
+/**
+ * @brief The Tracer class
+ *
+ * Scoped spans written to thread-local ring buffers and exported as Chrome trace events
+ * (chrome://tracing, ui.perfetto.dev). While disabled a span costs one relaxed atomic load.
+ * Names and categories must be string literals (only the pointers are stored).
+ * Define NO_TRACE to compile the spans out.
+ */
+
+class Tracer
+{
+public:
+	struct Event {
+		const char *name = nullptr;
+		const char *category = nullptr;
+		qint64 start = 0;
+		qint64 duration = 0;
+	};
+
+	class Scope
+	{
+	public:
+		explicit Scope(const char *name, const char *category = "app")
+			: m_name(name)
+			, m_category(category)
+			, m_start(Tracer::enabled() ? Tracer::now() : -1)
+		{}
+
+		~Scope() { finish(); }
+
+		void finish() {
+			if (m_start < 0)
+				return;
+
+			Tracer::add(m_name, m_category, m_start, Tracer::now() - m_start);
+			m_start = -1;
+		}
+
+	private:
+		Q_DISABLE_COPY(Scope)
+
+		const char *const m_name;
+		const char *const m_category;
+		qint64 m_start;
+	};
+
+	static constexpr int BufferSize = 16384;
+
+	static bool enabled() { return m_enabled.load(std::memory_order_relaxed); }
+	static void setEnabled(const bool &on);
+
+	static qint64 now();
+	static void add(const char *name, const char *category, const qint64 &start, const qint64 &duration);
+
+	static bool save(QIODevice *device);
+	static bool save(const QString &file);
+	static void clear();
+
+private:
+	static std::atomic<bool> m_enabled;
+};
+
+
+#define TRACE_CONCAT_(a, b)		a##b
+#define TRACE_CONCAT(a, b)		TRACE_CONCAT_(a, b)
+
+#ifndef NO_TRACE
+#	define TRACE_SCOPE(...)		const Tracer::Scope TRACE_CONCAT(_traceScope, __LINE__)(__VA_ARGS__)
+#else
+#	define TRACE_SCOPE(...)
+#endif
+
+#endif // TRACER_H
@@ -0,0 +1,158 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * undostack.cpp
+ *
+ * Created on: 2024. 01. 10.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * UndoStack
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "undostack.h"
+
+
+/**
+ * @brief UndoStack::share
+ * @param table
+ * @param id
+ * @param data
+ * @return
+ */
+
+UndoStack::Row UndoStack::share(const Table &table, const int &id, const QVariantMap &data)
+{
+	const quint64 k = key(table, id);
+
+	if (Row ptr = m_latest.value(k).lock(); ptr && *ptr == data)
+		return ptr;
+
+	Row ptr = std::make_shared<const QVariantMap>(data);
+	m_latest.insert(k, ptr);
+	return ptr;
+}
+
+
+
+/**
+ * @brief UndoStack::push
+ * @param step
+ */
+
+void UndoStack::push(Step &&step)
+{
+	if (step.changes.isEmpty() || m_limit <= 0)
+		return;
+
+	m_undo.push_back(std::move(step));
+
+	drop(m_redo, 0);
+	drop(m_undo, m_limit);
+}
+
+
+
+/**
+ * @brief UndoStack::undo
+ * @return
+ */
+
+std::optional<UndoStack::Step> UndoStack::undo()
+{
+	if (m_undo.empty())
+		return std::nullopt;
+
+	m_redo.push_back(std::move(m_undo.back()));
+	m_undo.pop_back();
+
+	return m_redo.back();
+}
+
+
+
+/**
+ * @brief UndoStack::redo
+ * @return
+ */
+
+std::optional<UndoStack::Step> UndoStack::redo()
+{
+	if (m_redo.empty())
+		return std::nullopt;
+
+	m_undo.push_back(std::move(m_redo.back()));
+	m_redo.pop_back();
+
+	return m_undo.back();
+}
+
+
+
+/**
+ * @brief UndoStack::clear
+ */
+
+void UndoStack::clear()
+{
+	m_undo.clear();
+	m_redo.clear();
+	m_latest.clear();
+}
+
+
+
+/**
+ * @brief UndoStack::setLimit
+ * @param limit
+ */
+
+void UndoStack::setLimit(const int &limit)
+{
+	m_limit = qMax(0, limit);
+
+	drop(m_undo, m_limit);
+	drop(m_redo, m_limit);
+}
+
+
+
+/**
+ * @brief UndoStack::drop
+ * Remove the oldest steps of the list down to size. Only the rows of the dropped steps
+ * are looked up in the latest versions, so a push costs O(changed rows).
+ * @param list
+ * @param size
+ */
+
+void UndoStack::drop(std::deque<Step> &list, const std::size_t &size)
+{
+	while (list.size() > size) {
+		QVector<quint64> keys;
+		keys.reserve(list.front().changes.size());
+
+		for (const Change &change : std::as_const(list.front().changes))
+			keys.append(key(change.table, change.id));
+
+		list.pop_front();
+
+		for (const quint64 &k : std::as_const(keys)) {
+			if (const auto it = m_latest.constFind(k); it != m_latest.constEnd() && it->expired())
+				m_latest.erase(it);
+		}
+	}
+}
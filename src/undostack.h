@@ -0,0 +1,95 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * undostack.h
+ *
+ * Created on: 2024. 01. 10.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * UndoStack
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef UNDOSTACK_H
+#define UNDOSTACK_H
+
+#include <QVariantMap>
+#include <QHash>
+#include <deque>
+#include <memory>
+#include <optional>
+
+
+/**
+ * @brief The UndoStack class
+ *
+ * Every step stores only the rows changed by a mutation. Row versions are immutable
+ * and shared between steps (the "after" of a step is the same object as the "before"
+ * of the next step touching that row), so memory grows with the number of changed rows.
+ */
+
+class UndoStack
+{
+public:
+	enum Table {
+		Job = 0,
+		Calc
+	};
+
+	typedef std::shared_ptr<const QVariantMap> Row;
+
+	struct Change {
+		Table table = Job;
+		int id = -1;
+		Row before;				// nullptr: the row didn't exist
+		Row after;				// nullptr: the row was deleted
+	};
+
+	struct Step {
+		QString text;
+		QVector<Change> changes;
+	};
+
+	explicit UndoStack(const int &limit = 50) : m_limit(limit) {}
+
+	Row share(const Table &table, const int &id, const QVariantMap &data);
+
+	void push(Step &&step);
+	std::optional<Step> undo();
+	std::optional<Step> redo();
+	void clear();
+
+	bool canUndo() const { return !m_undo.empty(); }
+	bool canRedo() const { return !m_redo.empty(); }
+
+	QString undoText() const { return m_undo.empty() ? QString() : m_undo.back().text; }
+	QString redoText() const { return m_redo.empty() ? QString() : m_redo.back().text; }
+
+	int limit() const { return m_limit; }
+	void setLimit(const int &limit);
+
+private:
+	static quint64 key(const Table &table, const int &id) { return (quint64(table) << 32) | quint32(id); }
+	void drop(std::deque<Step> &list, const std::size_t &size);
+
+	int m_limit = 50;
+	std::deque<Step> m_undo;
+	std::deque<Step> m_redo;
+	QHash<quint64, std::weak_ptr<const QVariantMap>> m_latest;
+};
+
+#endif // UNDOSTACK_H
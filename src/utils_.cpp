@@ -25,7 +25,8 @@
  */
 
 #include "utils_.h"
-#include "Logger.h"
+#include "tracer.h"
+#include "logfilter.h"
 #include "qclipboard.h"
 #include "qdesktopservices.h"
 #include "qdir.h"
@@ -529,6 +530,8 @@ QStringList Utils::getRolesFromObject(const QMetaObject *object)
 
 void Utils::patchSListModel(QSListModel *model, const QVariantList &data, const QString &keyField)
 {
+	TRACE_SCOPE("Utils::patchSListModel");
+
 	Q_ASSERT(model);
 
 	QSDiffRunner runner;
@@ -541,6 +544,70 @@ void Utils::patchSListModel(QSListModel *model, const QVariantList &data, const
 }
 
 
+/**
+ * @brief Utils::rowHash
+ * @param map
+ * @return
+ */
+
+quint64 Utils::rowHash(const QVariantMap &map)
+{
+	// FNV-1a 64 bit
+
+	quint64 hash = 14695981039346656037ULL;
+
+	const auto feed = [&hash](const void *data, const qsizetype &size) {
+		const uchar *p = static_cast<const uchar*>(data);
+		for (qsizetype i=0; i<size; ++i) {
+			hash ^= p[i];
+			hash *= 1099511628211ULL;
+		}
+	};
+
+	for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+		const QString &key = it.key();
+		feed(key.constData(), key.size() * sizeof(QChar));
+
+		const QVariant &v = it.value();
+		const qint32 type = v.isNull() ? QMetaType::UnknownType : v.typeId();
+
+		feed(&type, sizeof(type));
+
+		switch (type) {
+			case QMetaType::UnknownType:
+				break;
+
+			case QMetaType::Bool:
+			case QMetaType::Int:
+			case QMetaType::UInt:
+			case QMetaType::LongLong:
+			case QMetaType::ULongLong:
+			{
+				const qint64 n = v.toLongLong();
+				feed(&n, sizeof(n));
+				break;
+			}
+
+			case QMetaType::QDate:
+			{
+				const qint64 n = v.toDate().toJulianDay();
+				feed(&n, sizeof(n));
+				break;
+			}
+
+			default:
+			{
+				const QString &str = v.toString();
+				feed(str.constData(), str.size() * sizeof(QChar));
+				break;
+			}
+		}
+	}
+
+	return hash;
+}
+
+
 /**
  * @brief Utils::setCliboardText
  * @param text
@@ -33,6 +33,7 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QColor>
+#include <QtQml/qqmlregistration.h>
 #include <optional>
 #include <qslistmodel.h>
 
@@ -43,6 +44,8 @@
 class Utils : public QObject
 {
 	Q_OBJECT
+	QML_ELEMENT
+	QML_UNCREATABLE("Utils is uncreatable")
 
 public:
 	explicit Utils(QObject *parent = nullptr);
@@ -103,6 +106,7 @@ public:
 
 	static QStringList getRolesFromObject(const QMetaObject *object);
 	static void patchSListModel(QSListModel *model, const QVariantList &data, const QString &keyField);
+	static quint64 rowHash(const QVariantMap &map);
 
 	Q_INVOKABLE static void setClipboardText(const QString &text);
 	Q_INVOKABLE static QString clipboardText();
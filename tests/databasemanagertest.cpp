@@ -0,0 +1,288 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * databasemanagertest.cpp
+ *
+ * Created on: 2026. 10. 19.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * DatabaseManagerTest
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "databasemanagertest.h"
+#include "database.h"
+#include "databasemanager.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QTest>
+
+
+/**
+ * @brief DatabaseManagerTest::DatabaseManagerTest
+ * @param parent
+ */
+
+DatabaseManagerTest::DatabaseManagerTest(QObject *parent)
+	: QObject(parent)
+{
+
+}
+
+
+
+/**
+ * @brief DatabaseManagerTest::cleanup
+ * The manager deletes the closed databases later
+ */
+
+void DatabaseManagerTest::cleanup()
+{
+	QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+
+
+/**
+ * @brief DatabaseManagerTest::refcount
+ * A file is loaded once, it stays loaded (idle) after the last release
+ */
+
+void DatabaseManagerTest::refcount()
+{
+	const QString &file = writeDatabase(QStringLiteral("refcount.json"), QStringLiteral("A"));
+	QVERIFY(!file.isEmpty());
+
+	DatabaseManager manager;
+
+	Database *db = manager.acquire(file);
+	QVERIFY(db);
+	QCOMPARE(manager.acquire(file), db);
+	QCOMPARE(manager.size(), 1);
+	QCOMPARE(manager.idleCount(), 0);
+
+	QVERIFY(manager.release(db));
+	QCOMPARE(manager.idleCount(), 0);
+
+	QVERIFY(manager.release(db));
+	QCOMPARE(manager.idleCount(), 1);
+	QCOMPARE(manager.size(), 1);
+
+	QVERIFY(!manager.release(db));
+
+	QCOMPARE(manager.acquire(file), db);
+	QCOMPARE(manager.idleCount(), 0);
+
+	QVERIFY(manager.close(db));
+	QCOMPARE(manager.size(), 0);
+}
+
+
+
+/**
+ * @brief DatabaseManagerTest::closeWithoutFile
+ * Databases without a file can't be acquired again: closed on their last release
+ */
+
+void DatabaseManagerTest::closeWithoutFile()
+{
+	DatabaseManager manager;
+
+	Database *db = manager.create(QStringLiteral("New"));
+	QVERIFY(db);
+	QCOMPARE(manager.size(), 1);
+	QVERIFY(manager.files().isEmpty());
+
+	QVERIFY(manager.release(db));
+	QCOMPARE(manager.size(), 0);
+}
+
+
+
+/**
+ * @brief DatabaseManagerTest::evictionOrder
+ * The least recently used unmodified idle databases are closed above the limit
+ */
+
+void DatabaseManagerTest::evictionOrder()
+{
+	QHash<QString, QString> files;
+
+	for (const QString &name : QStringList{ QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("c"), QStringLiteral("d") }) {
+		files.insert(name, writeDatabase(name + QStringLiteral(".json"), name));
+		QVERIFY(!files.value(name).isEmpty());
+	}
+
+	const auto loaded = [&files](const DatabaseManager &manager) {
+		QStringList list;
+
+		for (const QString &f : manager.files())
+			list.append(files.key(f));
+
+		list.sort();
+		return list;
+	};
+
+	const auto use = [&files](DatabaseManager &manager, const QString &name) {
+		Database *db = manager.acquire(files.value(name));
+		return db && manager.release(db);
+	};
+
+	DatabaseManager manager(2);
+
+	QVERIFY(use(manager, QStringLiteral("a")));
+	QVERIFY(use(manager, QStringLiteral("b")));
+	QVERIFY(use(manager, QStringLiteral("c")));
+	QCOMPARE(loaded(manager), (QStringList{ QStringLiteral("b"), QStringLiteral("c") }));
+
+	// Using b again makes c the least recently used
+
+	QVERIFY(use(manager, QStringLiteral("b")));
+	QVERIFY(use(manager, QStringLiteral("d")));
+	QCOMPARE(loaded(manager), (QStringList{ QStringLiteral("b"), QStringLiteral("d") }));
+
+	// Modified databases are kept
+
+	Database *db = manager.acquire(files.value(QStringLiteral("b")));
+	QVERIFY(db);
+	db->setModified(true);
+	QVERIFY(manager.release(db));
+
+	QVERIFY(use(manager, QStringLiteral("a")));
+	QVERIFY(use(manager, QStringLiteral("c")));
+	QCOMPARE(loaded(manager), (QStringList{ QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("c") }));
+
+	// Used databases are kept
+
+	Database *dbA = manager.acquire(files.value(QStringLiteral("a")));
+	QVERIFY(dbA);
+
+	manager.setIdleLimit(0);
+	QCOMPARE(loaded(manager), (QStringList{ QStringLiteral("a"), QStringLiteral("b") }));
+
+	QVERIFY(manager.release(dbA));
+	QCOMPARE(loaded(manager), QStringList{ QStringLiteral("b") });
+
+	QVERIFY(manager.close(manager.acquire(files.value(QStringLiteral("b")))));
+	QCOMPARE(manager.size(), 0);
+}
+
+
+
+/**
+ * @brief DatabaseManagerTest::reloadChangedFile
+ * An idle database is reloaded if its file has changed, a used one is kept
+ */
+
+void DatabaseManagerTest::reloadChangedFile()
+{
+	const QDateTime &time = QDateTime::currentDateTime().addSecs(-3600);
+	const QString &file = writeDatabase(QStringLiteral("reload.json"), QStringLiteral("A"), time);
+	QVERIFY(!file.isEmpty());
+
+	DatabaseManager manager;
+
+	Database *db = manager.acquire(file);
+	QVERIFY(db);
+	QCOMPARE(db->title(), QStringLiteral("A"));
+	QVERIFY(manager.release(db));
+
+	QVERIFY(!writeDatabase(QStringLiteral("reload.json"), QStringLiteral("B"), time.addSecs(60)).isEmpty());
+
+	db = manager.acquire(file);
+	QVERIFY(db);
+	QCOMPARE(db->title(), QStringLiteral("B"));
+	QCOMPARE(manager.size(), 1);
+
+	QVERIFY(!writeDatabase(QStringLiteral("reload.json"), QStringLiteral("C"), time.addSecs(120)).isEmpty());
+
+	Database *db2 = manager.acquire(file);
+	QCOMPARE(db2, db);
+	QCOMPARE(db2->title(), QStringLiteral("B"));
+
+	QVERIFY(manager.release(db));
+	QVERIFY(manager.release(db));
+}
+
+
+
+/**
+ * @brief DatabaseManagerTest::acquireWithContent
+ * The content read by the caller is used only if the file isn't loaded yet
+ */
+
+void DatabaseManagerTest::acquireWithContent()
+{
+	const QString &file = writeDatabase(QStringLiteral("content.json"), QStringLiteral("A"));
+	QVERIFY(!file.isEmpty());
+
+	const auto &content = [](const QString &title) {
+		return QJsonObject{
+			{ QStringLiteral("_type"), QStringLiteral("TimeCalculator") },
+			{ QStringLiteral("_version"), 0 },
+			{ QStringLiteral("title"), title },
+		};
+	};
+
+	DatabaseManager manager;
+
+	Database *db = manager.acquire(file, content(QStringLiteral("B")));
+	QVERIFY(db);
+	QCOMPARE(db->title(), QStringLiteral("B"));
+
+	QCOMPARE(manager.acquire(file, content(QStringLiteral("C"))), db);
+	QCOMPARE(db->title(), QStringLiteral("B"));
+
+	QVERIFY(manager.release(db));
+	QVERIFY(manager.release(db));
+}
+
+
+
+/**
+ * @brief DatabaseManagerTest::writeDatabase
+ * Write an empty database to the temporary directory
+ * @param name
+ * @param title
+ * @param modified
+ * @return file name, empty on error
+ */
+
+QString DatabaseManagerTest::writeDatabase(const QString &name, const QString &title, const QDateTime &modified)
+{
+	const QJsonObject json{
+		{ QStringLiteral("_type"), QStringLiteral("TimeCalculator") },
+		{ QStringLiteral("_version"), 0 },
+		{ QStringLiteral("title"), title },
+	};
+
+	QFile f(m_dir.filePath(name));
+
+	if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return QString();
+
+	f.write(QJsonDocument(json).toJson());
+	f.flush();
+
+	if (modified.isValid() && !f.setFileTime(modified, QFileDevice::FileModificationTime))
+		return QString();
+
+	f.close();
+
+	return QFileInfo(f).canonicalFilePath();
+}
@@ -0,0 +1,62 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * databasemanagertest.h
+ *
+ * Created on: 2026. 10. 19.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * DatabaseManagerTest
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASEMANAGERTEST_H
+#define DATABASEMANAGERTEST_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+
+/**
+ * @brief The DatabaseManagerTest class
+ *
+ * Reference counting, eviction and reloading of DatabaseManager
+ */
+
+class DatabaseManagerTest : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit DatabaseManagerTest(QObject *parent = nullptr);
+
+private slots:
+	void cleanup();
+
+	void refcount();
+	void closeWithoutFile();
+	void evictionOrder();
+	void reloadChangedFile();
+	void acquireWithContent();
+
+private:
+	QString writeDatabase(const QString &name, const QString &title, const QDateTime &modified = QDateTime());
+
+	QTemporaryDir m_dir;
+};
+
+#endif // DATABASEMANAGERTEST_H
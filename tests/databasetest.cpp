@@ -0,0 +1,71 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * databasetest.cpp
+ *
+ * Created on: 2026. 10. 19.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * DatabaseTest
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "databasetest.h"
+#include "database.h"
+#include <QTest>
+
+
+/**
+ * @brief DatabaseTest::DatabaseTest
+ * @param parent
+ */
+
+DatabaseTest::DatabaseTest(QObject *parent)
+	: QObject(parent)
+{
+
+}
+
+
+
+/**
+ * @brief DatabaseTest::searchAfterUndo
+ * The full-text index follows the rows restored by undo
+ */
+
+void DatabaseTest::searchAfterUndo()
+{
+	Database db;
+	QVERIFY(db.open());
+
+	const int id = db.jobAdd(QJsonObject{
+								 { QStringLiteral("name"), QStringLiteral("Gimnázium") },
+								 { QStringLiteral("start"), QStringLiteral("2000-09-01") },
+							 });
+	QVERIFY(id > 0);
+
+	QVERIFY(db.jobEdit(id, QJsonObject{ { QStringLiteral("name"), QStringLiteral("Óvoda") } }));
+	QCOMPARE(db.search(QStringLiteral("Óvoda")).size(), 1);
+	QVERIFY(db.search(QStringLiteral("Gimnázium")).isEmpty());
+
+	QVERIFY(db.undo());
+
+	const QVariantList &list = db.search(QStringLiteral("Gimnázium"));
+	QCOMPARE(list.size(), 1);
+	QCOMPARE(list.first().toInt(), id);
+	QVERIFY(db.search(QStringLiteral("Óvoda")).isEmpty());
+}
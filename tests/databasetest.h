@@ -0,0 +1,50 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * databasetest.h
+ *
+ * Created on: 2026. 10. 19.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * DatabaseTest
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASETEST_H
+#define DATABASETEST_H
+
+#include <QObject>
+
+
+/**
+ * @brief The DatabaseTest class
+ *
+ * Regression tests of Database
+ */
+
+class DatabaseTest : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit DatabaseTest(QObject *parent = nullptr);
+
+private slots:
+	void searchAfterUndo();
+};
+
+#endif // DATABASETEST_H
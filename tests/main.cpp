@@ -0,0 +1,62 @@
+/*
+ * ---- Call of Suli ----
+ *
+ * main.cpp
+ *
+ * Created on: 2026. 10. 19.
+ *     Author: Valaczka János Pál <valaczka.janos@piarista.hu>
+ *
+ * Tests
+ *
+ *  This file is part of Call of Suli.
+ *
+ *  Call of Suli is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "application.h"
+#include "databasemanagertest.h"
+#include "databasetest.h"
+#include <QGuiApplication>
+#include <QTest>
+
+
+/**
+ * Runs every test class, the exit code is the number of failed classes:
+ *
+ *   tests
+ *   make check
+ */
+
+int main(int argc, char *argv[])
+{
+	if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+
+	QGuiApplication app(argc, argv);
+	Application application(&app);
+
+	int failed = 0;
+
+	{
+		DatabaseTest test;
+		failed += QTest::qExec(&test, argc, argv) != 0;
+	}
+
+	{
+		DatabaseManagerTest test;
+		failed += QTest::qExec(&test, argc, argv) != 0;
+	}
+
+	return failed;
+}
@@ -0,0 +1,34 @@
+lessThan(QT_MAJOR_VERSION, 6): error(Minimum Qt version 6 required)
+
+TEMPLATE = app
+TARGET = tests
+
+QT += gui quick svg quickcontrols2 sql printsupport concurrent testlib
+
+CONFIG += c++20
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+include(../common.pri)
+include(../version/version.pri)
+
+DESTDIR = ..
+
+include(../lib/import_lib.pri)
+
+!android:if(linux|win32){
+	QMAKE_LFLAGS += \
+		"-Wl,--rpath,'$${LITERAL_DOLLAR}$${LITERAL_DOLLAR}ORIGIN'" \
+		"-Wl,--rpath,'$${LITERAL_DOLLAR}$${LITERAL_DOLLAR}ORIGIN/lib'"
+}
+
+include(../src/sources.pri)
+
+SOURCES += \
+	databasemanagertest.cpp \
+	databasetest.cpp \
+	main.cpp
+
+HEADERS += \
+	databasemanagertest.h \
+	databasetest.h